@@ -0,0 +1,30 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SimulationBenchmark.h"
+
+// --------------------------------------------------------
+// Entry point for the console build of the simulation
+// benchmark, which doesn't need Windows or DirectX:
+//   SimulationBenchmark [-benchmark steps] [-assets folder]
+// --------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	// A minute at 60Hz by default, with the assets next to the working directory
+	int steps = 3600;
+	const char* assetFolder = "Assets";
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-benchmark") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+			steps = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-assets") == 0 && i + 1 < argc)
+			assetFolder = argv[++i];
+		else if (strcmp(argv[i], "-benchmark") != 0)
+		{
+			printf("Usage: %s [-benchmark steps] [-assets folder]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	return RunSimulationBenchmark(steps, assetFolder);
+}
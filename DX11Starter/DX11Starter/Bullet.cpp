@@ -6,7 +6,7 @@ const float Bullet::range = 50.0f;
 const float Bullet::lifetime = range / speed;
 const float Bullet::laserRadius = 0.1f;
 
-Bullet::Bullet(Mesh* mesh, Material* material) : Entity(mesh, material)
+Bullet::Bullet(int mesh, int material, float radius) : Entity(mesh, material, radius, ENTITY_BULLET)
 {
 	this->SetScale(0.15f, 0.15f, 0.15f);
 	this->laser = new PointLight();
@@ -39,34 +39,6 @@ void Bullet::Update(float deltaTime, float totalTime)
 	this->laser->Position = this->GetPosition();
 }
 
-void Bullet::Draw(ID3D11DeviceContext* context, Camera* camera, LightManager* lightManager)
-{
-	if (this->IsActive() != true)
-	{
-		return;
-	}
-
-	SimpleVertexShader* vShader = GetMaterial()->GetVertexShader();
-	SimplePixelShader* pShader = GetMaterial()->GetPixelShader();
-
-	vShader->SetShader();
-	pShader->SetShader();
-
-	// Send data to shader variables
-	vShader->SetMatrix4x4("world", GetWorld());
-	vShader->SetMatrix4x4("view", camera->GetView());
-	vShader->SetMatrix4x4("projection", camera->GetProj());
-	vShader->SetMatrix4x4("normalWorld", GetNormalWorld());
-
-	pShader->SetData("bulletLight", &(*laser), sizeof(PointLight));
-	pShader->SetData("cameraPosition", &(camera->GetCamPosition()), sizeof(XMFLOAT3));
-
-	vShader->CopyAllBufferData();
-	pShader->CopyAllBufferData();
-
-	Entity::Draw(context, camera, lightManager);
-}
-
 void Bullet::Collides()
 {
 	this->SetActive(false);
@@ -84,6 +56,7 @@ void Bullet::Launch(float timeStamp)
 	this->SetPosition(player->GetPosition().x, player->GetPosition().y, player->GetPosition().z + player->GetRadius());
 	this->spawnTime = timeStamp;
 	this->SetActive(true);
+	this->ResetInterpolation();
 	this->laser->Radius = Bullet::laserRadius;
 	this->laser->Position = this->GetPosition();
 }
@@ -1,16 +1,14 @@
 #pragma once
 #include "Entity.h"
-#include "Camera.h"
 #include "Lights.h"
 #include<vector>
 
 class Bullet : public Entity
 {
 public:
-	Bullet(Mesh* mesh, Material* material);
+	Bullet(int mesh, int material, float radius);
 	~Bullet();
 	void Update(float deltaTime, float totalTime) override;
-	void Draw(ID3D11DeviceContext* context, Camera* camera, LightManager* lightManager) override;
 	void Collides() override;
 
 	void Launch(float timeStamp);
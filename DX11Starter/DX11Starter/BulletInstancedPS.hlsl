@@ -0,0 +1,62 @@
+
+// Struct representing the data we expect to receive from earlier pipeline stages
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;
+	float3 normal       : NORMAL;
+	float2 uv           : TEXTCOORD;
+	float3 worldPos     : POSITION;
+	nointerpolation uint2 lights : LIGHTS;	// The bullet's own light, if it has one
+};
+
+struct PointLight {
+	float4 ambientColor;
+	float4 diffuseColor;
+	float4 specularColor;
+	float3 position;
+	float  radius;
+};
+
+// Every point light in the scene, packed once a frame
+StructuredBuffer<PointLight> lights : register(t2);
+
+// Changes once a frame, shared by every shader (FrameConstantData in C++).
+// Only the camera is needed here, after the matrices and directional light
+cbuffer perFrame : register(b1)
+{
+	float4 cameraPosition : packoffset(c12);
+};
+
+float4 calcPointLight(PointLight light, float3 position, float3 normal, float3 camera)
+{
+	float3 lightDist = light.position - position;
+	float3 lightNormDir = normalize(lightDist);
+
+	//Diffuse
+	float nDotL = saturate(dot(normal, lightNormDir));
+
+	//Specular
+	float3 cameraDir = normalize(camera - position);
+	float3 halfway = normalize(lightNormDir + cameraDir);
+
+	float nDotH = saturate(dot(normal, halfway));
+
+	float specAmt = pow(nDotH, 128);
+
+	return ((specAmt * light.specularColor) + (light.diffuseColor * nDotL) + light.ambientColor) * (light.radius / (.04 * dot(lightDist, lightDist)));
+}
+
+// --------------------------------------------------------
+// The entry point (main method) for our pixel shader
+// --------------------------------------------------------
+float4 main(VertexToPixel input) : SV_TARGET
+{
+	float4 surfaceColor = float4(1.0f, 1.0f, 1.0f, 1.0f);
+
+	float4 light = 0.0f;
+
+	if (input.lights.y > 0)
+		light += calcPointLight(lights[input.lights.x], input.worldPos, input.normal, cameraPosition.xyz);
+
+	return surfaceColor * light;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+
+
+// Changes once a frame, shared by every shader (FrameConstantData in C++)
+cbuffer perFrame : register(b1)
+{
+	matrix view;
+	matrix projection;
+};
+
+// Struct representing a single vertex worth of data, plus the instance it
+// belongs to (InstanceData in C++, from the second vertex buffer)
+struct VertexShaderInput
+{
+
+	float3 position		: POSITION;    // XYZ position
+	float3 normal		: NORMAL;      // XYZ normal
+	float2 uv           : TEXTCOORD;   // UV coordinate
+	float3 tangent      : TANGENT;
+
+	matrix world		: WORLD_PER_INSTANCE;
+	matrix normalWorld	: NORMALWORLD_PER_INSTANCE;
+	uint2 lights		: LIGHTS_PER_INSTANCE;    // The bullet's own light, in the light buffer
+};
+
+// Struct representing the data we're sending down the pipeline
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;	// XYZW position (System Value Position)
+	float3 normal       : NORMAL;
+	float2 uv           : TEXTCOORD;
+	float4 worldPos		: POSITION;
+	nointerpolation uint2 lights : LIGHTS;
+};
+
+// --------------------------------------------------------
+// The entry point (main method) for our vertex shader
+// --------------------------------------------------------
+VertexToPixel main(VertexShaderInput input)
+{
+	// Set up output struct
+	VertexToPixel output;
+
+	matrix worldViewProj = mul(mul(input.world, view), projection);
+
+	output.worldPos = mul(float4(input.position, 1.0f), input.world);
+	output.position = mul(float4(input.position, 1.0f), worldViewProj);
+
+	//Copy normal
+	output.normal = -1.0f * normalize(mul(input.normal, (float3x3) input.normalWorld));
+
+	//Copy uvs
+	output.uv = input.uv;
+
+	output.lights = input.lights;
+
+	return output;
+}
\ No newline at end of file
@@ -16,11 +16,17 @@ struct PointLight {
 	float  radius;
 };
 
-// Constant Buffer
-cbuffer externalData : register(b0)
+// Constant Buffers
+cbuffer perObject : register(b0)
 {
 	PointLight bulletLight;
-	float4 cameraPosition;
+};
+
+// Changes once a frame, shared by every shader (FrameConstantData in C++).
+// Only the camera is needed here, after the matrices and directional light
+cbuffer perFrame : register(b1)
+{
+	float4 cameraPosition : packoffset(c12);
 };
 
 float4 calcPointLight(PointLight light, float3 position, float3 normal, float3 camera)
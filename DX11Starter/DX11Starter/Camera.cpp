@@ -1,11 +1,11 @@
 #include "Camera.h"
-#include <string>
+#include <math.h>
 
 Camera::Camera(float width, float height, float fov, float nearClip, float farClip)
 {
 	xRotation = 0.0f;
 	yRotation = 0.0f;
-	XMStoreFloat3(&camPosition, XMVectorSet(0.0f, 0.0f, -3.0f, 0.0f));
+	camPosition = XMFLOAT3(0.0f, 0.0f, -3.0f);
 
 	this->width = width;
 	this->height = height;
@@ -13,6 +13,8 @@ Camera::Camera(float width, float height, float fov, float nearClip, float farCl
 	this->nearClip = nearClip;
 	this->farClip = farClip;
 
+	viewMatrix = XMFLOAT4X4();
+	viewMatrix._11 = viewMatrix._22 = viewMatrix._33 = viewMatrix._44 = 1.0f;
 	RecalcProj();
 }
 
@@ -23,22 +25,44 @@ Camera::~Camera()
 //Public methods
 void Camera::Update(float deltaTime, float totalTime, XMFLOAT3 playerPosition)
 {
-	//Get direction
-	//XMVECTOR rotation = XMQuaternionRotationRollPitchYaw(xRotation, yRotation, 0.0f);
-	XMVECTOR camInPlayerPlane = XMLoadFloat3(&camPosition);
-	camInPlayerPlane = XMVectorAdd(camInPlayerPlane, XMVectorSet(0.0f, 0.0f, 4.0f, 0.0f));
-	XMVECTOR playerDirection = XMLoadFloat3(&playerPosition) - camInPlayerPlane;
-	
-	XMVECTOR lookDir = XMVector4Normalize(XMVectorAdd(XMVectorScale(playerDirection, 0.2f), camInPlayerPlane) - XMLoadFloat3(&camPosition));
-	XMVECTOR upDir = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-	XMVECTOR position = XMLoadFloat3(&camPosition);
-	
-	//Get view matrix
-	XMMATRIX view = XMMatrixLookToLH(position, lookDir, upDir);
+	//Look a fifth of the way from straight ahead towards the player, from
+	//the point level with the player's plane
+	XMFLOAT3 inPlane(camPosition.x, camPosition.y, camPosition.z + 4.0f);
+	XMFLOAT3 direction(
+		(playerPosition.x - inPlane.x) * 0.2f + inPlane.x - camPosition.x,
+		(playerPosition.y - inPlane.y) * 0.2f + inPlane.y - camPosition.y,
+		(playerPosition.z - inPlane.z) * 0.2f + inPlane.z - camPosition.z);
+	LookTo(camPosition, direction);
+}
 
-	//Save data
-	XMStoreFloat3(&camPosition, position);
-	XMStoreFloat4x4(&viewMatrix, XMMatrixTranspose(view));
+void Camera::LookTo(XMFLOAT3 position, XMFLOAT3 direction)
+{
+	//Same as XMMatrixLookToLH with y up: the rows are the camera's right, up
+	//and forward axes, each with the eye moved to the origin
+	XMFLOAT3 forward = Normalize(direction);
+	XMFLOAT3 right = Normalize(Cross(XMFLOAT3(0.0f, 1.0f, 0.0f), forward));
+	XMFLOAT3 up = Cross(forward, right);
+
+	//Stored transposed, the way the shaders want it
+	viewMatrix._11 = right.x;
+	viewMatrix._12 = right.y;
+	viewMatrix._13 = right.z;
+	viewMatrix._14 = -Dot(right, position);
+	viewMatrix._21 = up.x;
+	viewMatrix._22 = up.y;
+	viewMatrix._23 = up.z;
+	viewMatrix._24 = -Dot(up, position);
+	viewMatrix._31 = forward.x;
+	viewMatrix._32 = forward.y;
+	viewMatrix._33 = forward.z;
+	viewMatrix._34 = -Dot(forward, position);
+	viewMatrix._41 = 0.0f;
+	viewMatrix._42 = 0.0f;
+	viewMatrix._43 = 0.0f;
+	viewMatrix._44 = 1.0f;
+
+	camPosition = position;
+	RecalcFrustum();
 }
 
 void Camera::Rotate(float dx, float dy)
@@ -102,14 +126,80 @@ XMFLOAT3 Camera::GetCamPosition()
 	return camPosition;
 }
 
+void Camera::GetFrustumPlanes(XMFLOAT4* planes)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		planes[i] = frustumPlanes[i];
+	}
+}
+
 //Private methods
+void Camera::RecalcFrustum()
+{
+	//Both matrices are stored transposed, so proj * view here is the
+	//transpose of view * proj, and its rows are the columns the planes are
+	//built from
+	XMFLOAT4X4 m;
+	for (int r = 0; r < 4; r++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			m.m[r][c] =
+				projMatrix.m[r][0] * viewMatrix.m[0][c] +
+				projMatrix.m[r][1] * viewMatrix.m[1][c] +
+				projMatrix.m[r][2] * viewMatrix.m[2][c] +
+				projMatrix.m[r][3] * viewMatrix.m[3][c];
+		}
+	}
+
+	for (int c = 0; c < 4; c++)
+	{
+		(&frustumPlanes[0].x)[c] = m.m[3][c] + m.m[0][c];
+		(&frustumPlanes[1].x)[c] = m.m[3][c] - m.m[0][c];
+		(&frustumPlanes[2].x)[c] = m.m[3][c] + m.m[1][c];
+		(&frustumPlanes[3].x)[c] = m.m[3][c] - m.m[1][c];
+		(&frustumPlanes[4].x)[c] = m.m[2][c];					// D3D depth starts at 0
+		(&frustumPlanes[5].x)[c] = m.m[3][c] - m.m[2][c];
+	}
+
+	//Unit normals, so plane distances are real distances
+	for (int i = 0; i < 6; i++)
+	{
+		XMFLOAT4& p = frustumPlanes[i];
+		float length = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+		p = XMFLOAT4(p.x / length, p.y / length, p.z / length, p.w / length);
+	}
+}
+
 void Camera::RecalcProj()
 {
-	// Create the Projection matrix
-	XMMATRIX P = XMMatrixPerspectiveFovLH(
-		fov,						// Field of View Angle
-		(float)width / height,		// Aspect ratio
-		nearClip,					// Near clip plane distance
-		farClip);					// Far clip plane distance
-	XMStoreFloat4x4(&projMatrix, XMMatrixTranspose(P)); // Transpose for HLSL!
-}
\ No newline at end of file
+	//Same as XMMatrixPerspectiveFovLH, stored transposed for HLSL
+	float yScale = 1.0f / tanf(fov * 0.5f);
+	float xScale = yScale / (width / height);
+	float range = farClip / (farClip - nearClip);
+
+	projMatrix = XMFLOAT4X4();
+	projMatrix._11 = xScale;
+	projMatrix._22 = yScale;
+	projMatrix._33 = range;
+	projMatrix._34 = -range * nearClip;
+	projMatrix._43 = 1.0f;
+	RecalcFrustum();
+}
+
+XMFLOAT3 Camera::Normalize(XMFLOAT3 v)
+{
+	float length = sqrtf(Dot(v, v));
+	return XMFLOAT3(v.x / length, v.y / length, v.z / length);
+}
+
+XMFLOAT3 Camera::Cross(XMFLOAT3 a, XMFLOAT3 b)
+{
+	return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+float Camera::Dot(XMFLOAT3 a, XMFLOAT3 b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
@@ -1,11 +1,16 @@
 #pragma once
 
-#include <d3d11.h>
-#include <DirectXMath.h>
 #include <vector>
+#include "Portable.h"
 
 using namespace DirectX;
 
+// --------------------------------------------------------
+// View and projection for the game, and the frustum planes
+// worked out from them.  Only does plain float math, so the
+// simulation can follow the player and cull particles with it
+// without a device.
+// --------------------------------------------------------
 class Camera
 {
 public:
@@ -18,13 +23,22 @@ public:
 	void SetPosition(float x, float y, float z);
 	void SetRotation(float x, float y);
 
+	//Moves the camera and points it along direction, with y up.  Update does
+	//this every frame, anything else can use it to look from a fixed spot
+	void LookTo(XMFLOAT3 position, XMFLOAT3 direction);
+
 	XMFLOAT4X4 GetView();
 	XMFLOAT4X4 GetProj();
 	XMFLOAT3 GetCamPosition();
+
+	//Left, right, bottom, top, near, far.  Normals point inwards and are unit length.
+	//Worked out whenever the view or projection changes
+	void GetFrustumPlanes(XMFLOAT4* planes);
 private:
 	//Matrixes
 	XMFLOAT4X4 viewMatrix;
 	XMFLOAT4X4 projMatrix;
+	XMFLOAT4 frustumPlanes[6];
 
 	//Look-to data
 	XMFLOAT3 camPosition;
@@ -44,5 +58,9 @@ private:
 
 	//Private methods
 	void RecalcProj();
+	void RecalcFrustum();
+	static XMFLOAT3 Normalize(XMFLOAT3 v);
+	static XMFLOAT3 Cross(XMFLOAT3 a, XMFLOAT3 b);
+	static float Dot(XMFLOAT3 a, XMFLOAT3 b);
 };
 
@@ -0,0 +1,74 @@
+#include "ConstantBufferData.h"
+#include <string.h>
+
+SimpleBufferStats ConstantBufferData::frameStats = {};
+SimpleBufferStats ConstantBufferData::lastFrameStats = {};
+
+ConstantBufferData::ConstantBufferData(unsigned int size, bool perObject)
+{
+	this->size = size;
+	this->perObject = perObject;
+	data = new unsigned char[size];
+	memset(data, 0, size);
+
+	//The GPU buffer starts out uninitialised
+	dirty = true;
+}
+
+ConstantBufferData::~ConstantBufferData()
+{
+	delete[] data;
+}
+
+unsigned int ConstantBufferData::GetSize()
+{
+	return size;
+}
+
+const unsigned char* ConstantBufferData::GetData()
+{
+	return data;
+}
+
+bool ConstantBufferData::IsDirty()
+{
+	return dirty;
+}
+
+void ConstantBufferData::Write(unsigned int offset, const void* data, unsigned int size)
+{
+	unsigned char* dest = this->data + offset;
+	if (memcmp(dest, data, size) == 0)
+		return;
+
+	memcpy(dest, data, size);
+	dirty = true;
+}
+
+void ConstantBufferData::Upload(StateTarget* target, ID3D11Buffer* buffer)
+{
+	if (!dirty)
+	{
+		frameStats.BuffersSkipped++;
+		return;
+	}
+
+	target->UpdateSubresource(buffer, data, size);
+	dirty = false;
+
+	frameStats.BuffersUploaded++;
+	frameStats.BytesUploaded += size;
+	if (perObject)
+		frameStats.ObjectBytesUploaded += size;
+}
+
+void ConstantBufferData::EndFrame()
+{
+	lastFrameStats = frameStats;
+	frameStats = {};
+}
+
+const SimpleBufferStats& ConstantBufferData::GetLastFrameStats()
+{
+	return lastFrameStats;
+}
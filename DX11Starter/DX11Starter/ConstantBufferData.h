@@ -0,0 +1,54 @@
+#pragma once
+
+#include "StateTarget.h"
+
+// --------------------------------------------------------
+// Constant buffer traffic, summed over every buffer
+// --------------------------------------------------------
+struct SimpleBufferStats
+{
+	unsigned int BuffersUploaded;
+	unsigned int BuffersSkipped;	// Nothing had changed since the last upload
+	unsigned int BytesUploaded;
+	unsigned int ObjectBytesUploaded;	// The part of BytesUploaded that went to perObject cbuffers
+};
+
+// --------------------------------------------------------
+// The CPU copy of a constant buffer, and whether it's changed
+// since it last went to the GPU.  Writes that don't change any
+// bytes leave it clean, so Upload only sends what's needed.
+//
+// Constant buffers can only be updated whole before D3D 11.1,
+// so there's no point tracking which bytes changed
+// --------------------------------------------------------
+class ConstantBufferData
+{
+public:
+	//perObject buffers are counted separately in the stats
+	ConstantBufferData(unsigned int size, bool perObject);
+	~ConstantBufferData();
+
+	unsigned int GetSize();
+	const unsigned char* GetData();
+	bool IsDirty();
+
+	//Copies size bytes in at offset, marking the buffer dirty only if they change
+	void Write(unsigned int offset, const void* data, unsigned int size);
+
+	//Sends the whole copy to buffer if it's dirty, and counts it either way
+	void Upload(StateTarget* target, ID3D11Buffer* buffer);
+
+	//Call once a frame, then GetLastFrameStats has the totals for the
+	//frame just drawn
+	static void EndFrame();
+	static const SimpleBufferStats& GetLastFrameStats();
+
+private:
+	unsigned int size;
+	unsigned char* data;
+	bool dirty;
+	bool perObject;
+
+	static SimpleBufferStats frameStats;
+	static SimpleBufferStats lastFrameStats;
+};
@@ -0,0 +1,81 @@
+#include "D3DStateTarget.h"
+
+D3DStateTarget::D3DStateTarget(ID3D11DeviceContext* context)
+{
+	this->context = context;
+}
+
+D3DStateTarget::~D3DStateTarget()
+{
+}
+
+void D3DStateTarget::IASetInputLayout(ID3D11InputLayout* layout)
+{
+	context->IASetInputLayout(layout);
+}
+
+void D3DStateTarget::VSSetShader(ID3D11VertexShader* shader)
+{
+	context->VSSetShader(shader, 0, 0);
+}
+
+void D3DStateTarget::PSSetShader(ID3D11PixelShader* shader)
+{
+	context->PSSetShader(shader, 0, 0);
+}
+
+void D3DStateTarget::VSSetConstantBuffers(unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers)
+{
+	context->VSSetConstantBuffers(slot, count, buffers);
+}
+
+void D3DStateTarget::PSSetConstantBuffers(unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers)
+{
+	context->PSSetConstantBuffers(slot, count, buffers);
+}
+
+void D3DStateTarget::VSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs)
+{
+	context->VSSetShaderResources(slot, count, srvs);
+}
+
+void D3DStateTarget::PSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs)
+{
+	context->PSSetShaderResources(slot, count, srvs);
+}
+
+void D3DStateTarget::VSSetSamplers(unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers)
+{
+	context->VSSetSamplers(slot, count, samplers);
+}
+
+void D3DStateTarget::PSSetSamplers(unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers)
+{
+	context->PSSetSamplers(slot, count, samplers);
+}
+
+void D3DStateTarget::OMSetBlendState(ID3D11BlendState* state, const float blendFactor[4], unsigned int sampleMask)
+{
+	context->OMSetBlendState(state, blendFactor, sampleMask);
+}
+
+void D3DStateTarget::OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef)
+{
+	context->OMSetDepthStencilState(state, stencilRef);
+}
+
+void D3DStateTarget::RSSetState(ID3D11RasterizerState* state)
+{
+	context->RSSetState(state);
+}
+
+void D3DStateTarget::OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv)
+{
+	context->OMSetRenderTargets(count, rtvs, dsv);
+}
+
+void D3DStateTarget::UpdateSubresource(ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	//The buffer knows its own size
+	context->UpdateSubresource(buffer, 0, 0, data, 0, 0);
+}
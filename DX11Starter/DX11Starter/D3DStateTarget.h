@@ -0,0 +1,35 @@
+#pragma once
+
+#include <d3d11.h>
+#include "StateTarget.h"
+
+// --------------------------------------------------------
+// Sends the StateCache's calls straight to a device context
+// --------------------------------------------------------
+class D3DStateTarget : public StateTarget
+{
+public:
+	D3DStateTarget(ID3D11DeviceContext* context);
+	~D3DStateTarget();
+
+	void IASetInputLayout(ID3D11InputLayout* layout) override;
+	void VSSetShader(ID3D11VertexShader* shader) override;
+	void PSSetShader(ID3D11PixelShader* shader) override;
+
+	void VSSetConstantBuffers(unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers) override;
+	void PSSetConstantBuffers(unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers) override;
+	void VSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) override;
+	void PSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) override;
+	void VSSetSamplers(unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers) override;
+	void PSSetSamplers(unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers) override;
+
+	void OMSetBlendState(ID3D11BlendState* state, const float blendFactor[4], unsigned int sampleMask) override;
+	void OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef) override;
+	void RSSetState(ID3D11RasterizerState* state) override;
+	void OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv) override;
+
+	void UpdateSubresource(ID3D11Buffer* buffer, const void* data, unsigned int size) override;
+
+private:
+	ID3D11DeviceContext* context;
+};
@@ -1,4 +1,5 @@
 #include "DXCore.h"
+#include "Profiler.h"
 
 #include <WindowsX.h>
 #include <sstream>
@@ -50,6 +51,12 @@ DXCore::DXCore(
 	// Initialize fields
 	fpsFrameCount = 0;
 	fpsTimeElapsed = 0.0f;
+
+	simulationRate = 60.0f;
+	maxSimulationSteps = 5;
+	simulationTime = 0.0;
+	accumulator = 0.0;
+	interpolation = 1.0f;
 	
 	device = 0;
 	context = 0;
@@ -368,6 +375,10 @@ HRESULT DXCore::Run()
 	// Give subclass a chance to initialize
 	Init();
 
+	// Start a whole step in, so there's a simulated state before the first draw
+	simulationTime = 0.0;
+	accumulator = simulationRate > 0.0f ? 1.0 / simulationRate : 0.0;
+
 	// Our overall game and message loop
 	MSG msg = {};
 	while (msg.message != WM_QUIT)
@@ -384,12 +395,49 @@ HRESULT DXCore::Run()
 		{
 			// Update timer and title bar (if necessary)
 			UpdateTimer();
+			Profiler::BeginFrame();
 			if(titleBarStats)
 				UpdateTitleBarStats();
 
-			// The game loop
-			Update(deltaTime, totalTime);
-			Draw(deltaTime, totalTime);
+			// The game loop.  The simulation catches up with real time in
+			// fixed steps, then the frame is drawn part way between the last two
+			if (simulationRate > 0.0f)
+			{
+				double step = 1.0 / simulationRate;
+				accumulator += deltaTime;
+
+				int steps = 0;
+				while (accumulator >= step && steps < maxSimulationSteps)
+				{
+					PROFILE_SCOPE("Update");
+					Update((float)step, (float)simulationTime);
+					simulationTime += step;
+					accumulator -= step;
+					steps++;
+				}
+
+				// Too far behind to catch up, so let the game slow down
+				// rather than spend every frame simulating
+				if (accumulator >= step)
+					accumulator = step * 0.999;
+
+				interpolation = (float)(accumulator / step);
+			}
+			else
+			{
+				// Simulation time carries on from wherever it got to, so
+				// switching modes doesn't make it jump
+				PROFILE_SCOPE("Update");
+				Update(deltaTime, (float)simulationTime);
+				simulationTime += deltaTime;
+				interpolation = 1.0f;
+			}
+
+			{
+				PROFILE_SCOPE("Draw");
+				Draw(deltaTime, totalTime);
+			}
+			Profiler::EndFrame();
 		}
 	}
 
@@ -433,6 +481,32 @@ void DXCore::UpdateTimer()
 }
 
 
+// --------------------------------------------------------
+// Changes how often Update runs.  0 goes back to running it
+// once per frame with the frame's delta time
+// --------------------------------------------------------
+void DXCore::SetSimulationRate(float stepsPerSecond)
+{
+	simulationRate = stepsPerSecond > 0.0f ? stepsPerSecond : 0.0f;
+	accumulator = 0.0;
+}
+
+float DXCore::GetSimulationRate()
+{
+	return simulationRate;
+}
+
+void DXCore::SetMaxSimulationSteps(int steps)
+{
+	maxSimulationSteps = steps < 1 ? 1 : steps;
+}
+
+float DXCore::GetInterpolation()
+{
+	return interpolation;
+}
+
+
 // --------------------------------------------------------
 // Updates the window's title bar with several stats once
 // per second, including:
@@ -461,6 +535,9 @@ void DXCore::UpdateTitleBarStats()
 		"    FPS: "			<< fpsFrameCount <<
 		"    Frame Time: "	<< mspf << "ms";
 
+	if (simulationRate > 0.0f)
+		output << "    Sim: " << simulationRate << "Hz";
+
 	// Append the version of DirectX the app is using
 	switch (dxFeatureLevel)
 	{
@@ -72,6 +72,13 @@ protected:
 	// Helper function for allocating a console window
 	void CreateConsoleWindow(int bufferLines, int bufferColumns, int windowLines, int windowColumns);
 
+	// Simulation timing.  Update runs at a fixed rate (0 = once per frame with
+	// the frame's time), and Draw gets how far it is between the last two steps
+	void SetSimulationRate(float stepsPerSecond);
+	float GetSimulationRate();
+	void SetMaxSimulationSteps(int steps);
+	float GetInterpolation();
+
 private:
 	// Timing related data
 	double perfCounterSeconds;
@@ -81,6 +88,13 @@ private:
 	__int64 currentTime;
 	__int64 previousTime;
 
+	// Fixed step simulation
+	float simulationRate;		// Steps per second, 0 for one per frame
+	int maxSimulationSteps;		// Most steps in one frame before time is dropped
+	double simulationTime;		// Time the simulation has reached
+	double accumulator;			// Real time not yet simulated
+	float interpolation;		// Between the last two steps, for Draw
+
 	// FPS calculation
 	int fpsFrameCount;
 	float fpsTimeElapsed;
@@ -1,18 +1,28 @@
 #pragma once
 
-#include <d3d11.h>
-#include <DirectXMath.h>
-#include "Mesh.h"
-#include "Material.h"
-#include "Camera.h"
-#include "LightManager.h"
+#include "Portable.h"
 
 using namespace DirectX;
 
+//What an entity is drawn as, so the renderer knows which shaders'
+//per object data it needs
+enum EntityKind
+{
+	ENTITY_SHIP,
+	ENTITY_BULLET,
+	ENTITY_SPRITE
+};
+
+// --------------------------------------------------------
+// Something in the game world with a transform.  The mesh and
+// material are handles the renderer hands out, the entity only
+// carries them, so gameplay can run without a device.  Radius
+// is the mesh's bounding sphere at a scale of 1.
+// --------------------------------------------------------
 class Entity
 {
 public:
-	Entity(Mesh* mesh, Material* material);
+	Entity(int mesh, int material, float radius, EntityKind kind);
 	virtual ~Entity();
 
 	//Control active toggle
@@ -26,34 +36,48 @@ public:
 	void Spin(float dx, float dy, float dz);
 	void Resize(float dx, float dy, float dz);
 
-	XMFLOAT4X4 GetWorld();
-	XMFLOAT4X4 GetNormalWorld();
 	XMFLOAT3 GetPosition();
 	XMFLOAT3 GetRotation();
 	XMFLOAT3 GetScale();
-	Mesh* GetMesh();
-	Material* GetMaterial();
+	int GetMesh();
+	int GetMaterial();
+	EntityKind GetKind();
 	float GetRadius();
 
+	//Interpolation between simulation steps.  SaveState is called before each
+	//step, and the render transform is blended from there towards the current
+	//one by SetRenderBlend.  ResetInterpolation is for jumps that
+	//shouldn't be smoothed, like respawning
+	void SaveState();
+	void ResetInterpolation();
+	void SetRenderBlend(float blend);
+	XMFLOAT3 GetRenderPosition();
+	XMFLOAT3 GetRenderRotation();
+	XMFLOAT3 GetRenderScale();
+
 	virtual void Update(float deltaTime, float totalTime);
-	virtual void Draw(ID3D11DeviceContext* context, Camera* camera, LightManager* lightManager);
 	virtual void Collides();
 private:
 
 	bool active;
 
 	//Resources
-	Mesh* mesh;
-	Material* material;
+	int mesh;
+	int material;
+	EntityKind kind;
 
-	//Drawing data
-	XMFLOAT4X4 world;
+	//Transform
 	XMFLOAT3 position;
 	XMFLOAT3 rotation;
 	XMFLOAT3 scale;
-	bool isWorldValid;
 
-	void RecalcWorld();
+	//Transform at the start of the current simulation step
+	XMFLOAT3 previousPosition;
+	XMFLOAT3 previousRotation;
+	XMFLOAT3 previousScale;
+	float renderBlend;
+
+	XMFLOAT3 Blend(XMFLOAT3 from, XMFLOAT3 to);
 
 	// the radius of the mesh, the entity's scaled radius is created from this value
 	float masterRadius;
@@ -0,0 +1,178 @@
+#include "EntityRenderer.h"
+#include "Bullet.h"
+
+EntityRenderer::EntityRenderer()
+{
+}
+
+EntityRenderer::~EntityRenderer()
+{
+}
+
+int EntityRenderer::AddMesh(Mesh* mesh)
+{
+	meshes.push_back(mesh);
+	return (int)meshes.size() - 1;
+}
+
+int EntityRenderer::AddMaterial(Material* material)
+{
+	materials.push_back(material);
+	return (int)materials.size() - 1;
+}
+
+Mesh* EntityRenderer::GetMesh(int mesh)
+{
+	return meshes[mesh];
+}
+
+Material* EntityRenderer::GetMaterial(int material)
+{
+	return materials[material];
+}
+
+void EntityRenderer::GetWorld(Entity* entity, XMFLOAT4X4& world, XMFLOAT4X4& normalWorld)
+{
+	XMFLOAT3 position = entity->GetRenderPosition();
+	XMFLOAT3 rotation = entity->GetRenderRotation();
+	XMFLOAT3 scale = entity->GetRenderScale();
+
+	//Generate matricies for each transformation type
+	XMMATRIX t = XMMatrixTranslationFromVector(XMLoadFloat3(&position));
+	XMMATRIX r = XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
+	XMMATRIX s = XMMatrixScalingFromVector(XMLoadFloat3(&scale));
+
+	//Combine and store
+	XMMATRIX w = s * r * t;
+	XMStoreFloat4x4(&world, XMMatrixTranspose(w));
+
+	//The transpose of the transpose cancels out
+	XMStoreFloat4x4(&normalWorld, XMMatrixInverse(nullptr, w));
+}
+
+void EntityRenderer::Draw(ID3D11DeviceContext* context, Entity* entity, LightManager* lightManager)
+{
+	if (entity->GetKind() != ENTITY_SPRITE && entity->IsActive() != true)
+	{
+		return;
+	}
+
+	//Per object data for the kind of entity this is
+	switch (entity->GetKind())
+	{
+	case ENTITY_SHIP:
+		DrawShip(entity, lightManager);
+		break;
+	case ENTITY_BULLET:
+		DrawBullet(entity);
+		break;
+	case ENTITY_SPRITE:
+		DrawSprite(entity);
+		break;
+	}
+
+	// Set buffers in the input assembler
+	//  - Do this ONCE PER OBJECT you're drawing, since each object might
+	//    have different geometry.
+	Mesh* mesh = GetMesh(entity->GetMesh());
+	UINT stride = sizeof(Vertex);
+	UINT offset = 0;
+	context->IASetVertexBuffers(0, 1, mesh->GetVertexBuffer(), &stride, &offset);
+	context->IASetIndexBuffer(mesh->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
+
+	// Finally do the actual drawing
+	//  - Do this ONCE PER OBJECT you intend to draw
+	//  - This will use all of the currently set DirectX "stuff" (shaders, buffers, etc)
+	//  - DrawIndexed() uses the currently set INDEX BUFFER to look up corresponding
+	//     vertices in the currently set VERTEX BUFFER
+	context->DrawIndexed(
+		mesh->GetIndexCount(),     // The number of indices to use (we could draw a subset if we wanted)
+		0,     // Offset to the first index we want to use
+		0);    // Offset to add to each index when looking up vertices
+}
+
+void EntityRenderer::WriteInstance(Entity* entity, InstanceData& instance, LightManager* lightManager)
+{
+	GetWorld(entity, instance.World, instance.NormalWorld);
+
+	if (entity->GetKind() == ENTITY_BULLET)
+	{
+		//Bullets are only lit by their own laser
+		int light = lightManager->FindLight(((Bullet*)entity)->GetLaser());
+		instance.LightFirst = light < 0 ? 0 : (unsigned int)light;
+		instance.LightCount = light < 0 ? 0 : 1;
+		return;
+	}
+
+	lightManager->GetLightList(entity, instance.LightFirst, instance.LightCount);
+}
+
+void EntityRenderer::DrawShip(Entity* entity, LightManager* lightManager)
+{
+	Material* material = GetMaterial(entity->GetMaterial());
+
+	//Per object data, laid out exactly like the shaders' perObject cbuffers
+	ShipVS::perObject vertexData = {};
+	GetWorld(entity, vertexData.world, vertexData.normalWorld);
+
+	//Which of the packed lights reach us (worked out once a frame)
+	ShipPS::perObject pixelData = {};
+	pixelData.pointLightCount = lightManager->GatherLightIndices(entity, &pixelData.lightIndices[0].x, LightManager::maxLightsPerObject);
+
+	SimpleVertexShader* vShader = material->GetVertexShader();
+	SimplePixelShader* pShader = material->GetPixelShader();
+	const MaterialHandles& h = material->GetHandles();
+
+	//Shaders, textures and the light buffer only change with the material.
+	//View, projection, camera and sun come from the shared per frame buffer
+	if (material->Bind())
+		pShader->SetShaderResourceView(h.Lights, lightManager->GetLightSRV());
+
+	// Send per object data to shader variables, one copy per buffer
+	vShader->SetBufferData(h.VertexObjectBuffer, &vertexData, sizeof(vertexData));
+	pShader->SetBufferData(h.PixelObjectBuffer, &pixelData, sizeof(pixelData));
+
+	vShader->CopyAllBufferData();
+	pShader->CopyAllBufferData();
+}
+
+void EntityRenderer::DrawBullet(Entity* entity)
+{
+	Material* material = GetMaterial(entity->GetMaterial());
+	SimpleVertexShader* vShader = material->GetVertexShader();
+	SimplePixelShader* pShader = material->GetPixelShader();
+	const MaterialHandles& h = material->GetHandles();
+
+	//Shaders only change with the material, camera data is per frame
+	material->Bind();
+
+	// Send per object data to shader variables, one copy per buffer
+	BulletVS::perObject vertexData = {};
+	GetWorld(entity, vertexData.world, vertexData.normalWorld);
+	vShader->SetBufferData(h.VertexObjectBuffer, &vertexData, sizeof(vertexData));
+
+	BulletPS::perObject pixelData = {};
+	pixelData.bulletLight = *((Bullet*)entity)->GetLaser();
+	pShader->SetBufferData(h.PixelObjectBuffer, &pixelData, sizeof(pixelData));
+
+	vShader->CopyAllBufferData();
+	pShader->CopyAllBufferData();
+}
+
+void EntityRenderer::DrawSprite(Entity* entity)
+{
+	Material* material = GetMaterial(entity->GetMaterial());
+	SimpleVertexShader* vShader = material->GetVertexShader();
+	SimplePixelShader* pShader = material->GetPixelShader();
+	const MaterialHandles& h = material->GetHandles();
+
+	material->Bind();
+
+	XMFLOAT4X4 world;
+	XMFLOAT4X4 normalWorld;
+	GetWorld(entity, world, normalWorld);
+	vShader->SetMatrix4x4(h.World, world);
+
+	vShader->CopyAllBufferData();
+	pShader->CopyAllBufferData();
+}
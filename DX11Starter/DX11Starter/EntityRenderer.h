@@ -0,0 +1,50 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <vector>
+#include "Entity.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "LightManager.h"
+#include "ShaderConstants.h"
+
+using namespace std;
+
+// --------------------------------------------------------
+// Turns the handles entities carry into meshes and materials,
+// and draws an entity on its own with the per object data its
+// kind needs.  Doesn't own the meshes or materials, the game
+// does.  Entities are only read from, the world matrices are
+// built here from their render transform.
+// --------------------------------------------------------
+class EntityRenderer
+{
+public:
+	EntityRenderer();
+	~EntityRenderer();
+
+	//Handles for entities to carry
+	int AddMesh(Mesh* mesh);
+	int AddMaterial(Material* material);
+	Mesh* GetMesh(int mesh);
+	Material* GetMaterial(int material);
+
+	//World and inverse transpose world at the entity's render transform,
+	//both transposed for the shaders
+	void GetWorld(Entity* entity, XMFLOAT4X4& world, XMFLOAT4X4& normalWorld);
+
+	void Draw(ID3D11DeviceContext* context, Entity* entity, LightManager* lightManager);
+
+	//Fills in an entity's slot of an instance buffer, for drawing it as part
+	//of a batch instead of on its own
+	void WriteInstance(Entity* entity, InstanceData& instance, LightManager* lightManager);
+
+private:
+	vector<Mesh*> meshes;
+	vector<Material*> materials;
+
+	void DrawShip(Entity* entity, LightManager* lightManager);
+	void DrawBullet(Entity* entity);
+	void DrawSprite(Entity* entity);
+};
@@ -1,11 +1,11 @@
 #include "FireManager.h"
 
-FireManager::FireManager(Mesh* mesh, Material* material)
+FireManager::FireManager(int mesh, int material, float radius)
 {
 	//Generates all bullets needed, so we can use bulletList as circular buffer
 	for (size_t i = 0; i < maxShots; i++)
 	{
-		Bullet* b = new Bullet(mesh, material);
+		Bullet* b = new Bullet(mesh, material, radius);
 		bulletList.push_back(b);
 	}
 }
@@ -2,13 +2,14 @@
 
 #include"Bullet.h"
 #include<vector>
+#include<math.h>
 
 using namespace std;
 
 class FireManager
 {
 public:
-	FireManager(Mesh* mesh, Material* material);
+	FireManager(int mesh, int material, float radius);
 	~FireManager();
 	void Fire(float deltaTime, float totalTime, bool fire);
 	vector<Entity*> GetBullets();
@@ -0,0 +1,51 @@
+#include "FrameConstants.h"
+#include <string.h>
+
+FrameConstants::FrameConstants(ID3D11Device* device)
+{
+	memset(&data, 0, sizeof(data));
+	uploaded = false;
+	uploadBytes = 0;
+
+	//Same setup SimpleShader uses for its own buffers
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.ByteWidth = sizeof(FrameConstantData);
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	device->CreateBuffer(&desc, 0, &buffer);
+}
+
+FrameConstants::~FrameConstants()
+{
+	buffer->Release();
+}
+
+bool FrameConstants::Attach(ISimpleShader* shader)
+{
+	return shader->UseExternalBuffer("perFrame", buffer);
+}
+
+void FrameConstants::Update(ID3D11DeviceContext* context, Camera* camera, const DirectionalLight& dirLight)
+{
+	FrameConstantData next = {};
+	next.View = camera->GetView();
+	next.Projection = camera->GetProj();
+	next.DirLight = dirLight;
+	XMFLOAT3 eye = camera->GetCamPosition();
+	next.CameraPosition = XMFLOAT4(eye.x, eye.y, eye.z, 1.0f);
+
+	//A still camera means there's nothing to send
+	uploadBytes = 0;
+	if (uploaded && memcmp(&next, &data, sizeof(data)) == 0)
+		return;
+
+	data = next;
+	context->UpdateSubresource(buffer, 0, 0, &data, 0, 0);
+	uploaded = true;
+	uploadBytes = sizeof(data);
+}
+
+int FrameConstants::GetUploadBytes()
+{
+	return uploadBytes;
+}
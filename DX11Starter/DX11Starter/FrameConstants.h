@@ -0,0 +1,55 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include "SimpleShader.h"
+#include "Camera.h"
+#include "Lights.h"
+#include "ShaderConstants.h"
+
+using namespace DirectX;
+
+//Matches cbuffer perFrame (register b1) in the shaders.  Shaders only
+//declare as much of it as they use, the rest is just bigger than they need
+struct FrameConstantData
+{
+	XMFLOAT4X4 View;
+	XMFLOAT4X4 Projection;
+	DirectionalLight DirLight;
+	float Padding;
+	XMFLOAT4 CameraPosition;
+};
+
+//ShipPS declares the whole buffer, BulletPS just the camera at the end
+static_assert(sizeof(FrameConstantData) == sizeof(ShipPS::perFrame), "FrameConstantData doesn't match perFrame");
+static_assert(offsetof(FrameConstantData, DirLight) == offsetof(ShipPS::perFrame, dirLight), "FrameConstantData doesn't match perFrame");
+static_assert(offsetof(FrameConstantData, CameraPosition) == offsetof(ShipPS::perFrame, cameraPosition), "FrameConstantData doesn't match perFrame");
+static_assert(offsetof(FrameConstantData, CameraPosition) == offsetof(BulletPS::perFrame, cameraPosition), "FrameConstantData doesn't match perFrame");
+
+// --------------------------------------------------------
+// Shader data that only changes once a frame, kept in one
+// constant buffer that every shader binds in place of its
+// own perFrame buffer.  Uploaded at most once a frame,
+// instead of once per draw.
+// --------------------------------------------------------
+class FrameConstants
+{
+public:
+	FrameConstants(ID3D11Device* device);
+	~FrameConstants();
+
+	//Points the shader's perFrame cbuffer at ours.  False if it has none
+	bool Attach(ISimpleShader* shader);
+
+	//Fills in this frame's data, and uploads it if anything changed
+	void Update(ID3D11DeviceContext* context, Camera* camera, const DirectionalLight& dirLight);
+
+	//Bytes sent by the last Update (0 if nothing changed)
+	int GetUploadBytes();
+
+private:
+	ID3D11Buffer* buffer;
+	FrameConstantData data;
+	bool uploaded;
+	int uploadBytes;
+};
@@ -0,0 +1,297 @@
+#include "FrameGraph.h"
+#include "Profiler.h"
+
+FrameGraph::FrameGraph()
+{
+	culledPasses = 0;
+}
+
+FrameGraph::~FrameGraph()
+{
+}
+
+void FrameGraph::Reset()
+{
+	passes.clear();
+	textures.clear();
+	order.clear();
+	physicalTextures.clear();
+	physicalLastUse.clear();
+	culledPasses = 0;
+}
+
+int FrameGraph::CreateTexture(const char* name, FrameGraphTextureDesc desc)
+{
+	Texture t;
+	t.name = name;
+	t.desc = desc;
+	t.imported = false;
+	t.firstUse = -1;
+	t.lastUse = -1;
+	t.physical = -1;
+	textures.push_back(t);
+	return (int)textures.size() - 1;
+}
+
+int FrameGraph::ImportTexture(const char* name)
+{
+	FrameGraphTextureDesc none = {};
+	int texture = CreateTexture(name, none);
+	textures[texture].imported = true;
+	return texture;
+}
+
+int FrameGraph::AddPass(const char* name, function<void()> execute)
+{
+	Pass p;
+	p.name = name;
+	p.profileName = Profiler::Intern(p.name);
+	p.execute = execute;
+	p.needed = false;
+	passes.push_back(p);
+	return (int)passes.size() - 1;
+}
+
+void FrameGraph::Read(int pass, int texture)
+{
+	passes[pass].reads.push_back(texture);
+}
+
+void FrameGraph::Write(int pass, int texture)
+{
+	passes[pass].writes.push_back(texture);
+}
+
+bool FrameGraph::Compile()
+{
+	order.clear();
+	physicalTextures.clear();
+	physicalLastUse.clear();
+
+	//Needed passes write something outside the graph, or something a
+	//needed pass reads.  Graphs are small, so just repeat until nothing changes
+	for (size_t p = 0; p < passes.size(); p++)
+	{
+		passes[p].needed = false;
+		for (size_t w = 0; w < passes[p].writes.size(); w++)
+			passes[p].needed |= textures[passes[p].writes[w]].imported;
+	}
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (size_t p = 0; p < passes.size(); p++)
+		{
+			if (passes[p].needed)
+				continue;
+			for (size_t w = 0; w < passes[p].writes.size() && !passes[p].needed; w++)
+			{
+				for (size_t q = 0; q < passes.size() && !passes[p].needed; q++)
+				{
+					if (!passes[q].needed)
+						continue;
+					for (size_t r = 0; r < passes[q].reads.size(); r++)
+					{
+						if (passes[q].reads[r] == passes[p].writes[w])
+						{
+							passes[p].needed = true;
+							changed = true;
+							break;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	//A read sees the last write declared before it, or any write if there
+	//isn't one (so a pass can be declared before its inputs).  Writes to the
+	//same texture stay in declaration order.  Of the passes that are ready,
+	//the first declared goes next, so a sensibly declared graph stays as it is
+	culledPasses = 0;
+	int neededCount = 0;
+	for (size_t p = 0; p < passes.size(); p++)
+	{
+		if (passes[p].needed) neededCount++;
+		else culledPasses++;
+	}
+	vector<bool> placed(passes.size(), false);
+	while ((int)order.size() < neededCount)
+	{
+		int next = -1;
+		for (int p = 0; p < (int)passes.size() && next < 0; p++)
+		{
+			if (!passes[p].needed || placed[p])
+				continue;
+			if (IsReady(p, placed))
+				next = p;
+		}
+		if (next < 0)
+			return false;
+		placed[next] = true;
+		order.push_back(next);
+	}
+
+	//Lifetimes, in compiled pass order
+	for (size_t t = 0; t < textures.size(); t++)
+	{
+		textures[t].firstUse = -1;
+		textures[t].lastUse = -1;
+		textures[t].physical = -1;
+	}
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		Pass& p = passes[order[i]];
+		for (int k = 0; k < 2; k++)
+		{
+			vector<int>& used = k == 0 ? p.reads : p.writes;
+			for (size_t u = 0; u < used.size(); u++)
+			{
+				Texture& t = textures[used[u]];
+				if (t.firstUse < 0) t.firstUse = (int)i;
+				t.lastUse = (int)i;
+			}
+		}
+	}
+
+	//Hand out slots in the order textures start being used, reusing any
+	//matching slot whose last texture is finished with by then
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		for (size_t t = 0; t < textures.size(); t++)
+		{
+			Texture& tex = textures[t];
+			if (tex.imported || tex.firstUse != (int)i)
+				continue;
+
+			for (size_t s = 0; s < physicalTextures.size() && tex.physical < 0; s++)
+			{
+				if (physicalLastUse[s] < tex.firstUse && SameDesc(physicalTextures[s], tex.desc))
+					tex.physical = (int)s;
+			}
+			if (tex.physical < 0)
+			{
+				tex.physical = (int)physicalTextures.size();
+				physicalTextures.push_back(tex.desc);
+				physicalLastUse.push_back(-1);
+			}
+			physicalLastUse[tex.physical] = tex.lastUse;
+		}
+	}
+
+	return true;
+}
+
+bool FrameGraph::IsReady(int pass, const vector<bool>& placed)
+{
+	Pass& p = passes[pass];
+	for (size_t r = 0; r < p.reads.size(); r++)
+	{
+		bool earlierWriter = false;
+		for (int q = 0; q < pass && !earlierWriter; q++)
+			earlierWriter = passes[q].needed && Writes(q, p.reads[r]);
+
+		for (int q = 0; q < (int)passes.size(); q++)
+		{
+			if (q == pass || placed[q] || !passes[q].needed || (earlierWriter && q > pass))
+				continue;
+			if (Writes(q, p.reads[r]))
+				return false;
+		}
+	}
+	for (size_t w = 0; w < p.writes.size(); w++)
+	{
+		for (int q = 0; q < pass; q++)
+		{
+			if (!placed[q] && passes[q].needed && Writes(q, p.writes[w]))
+				return false;
+		}
+	}
+	return true;
+}
+
+bool FrameGraph::Writes(int pass, int texture)
+{
+	for (size_t w = 0; w < passes[pass].writes.size(); w++)
+	{
+		if (passes[pass].writes[w] == texture)
+			return true;
+	}
+	return false;
+}
+
+void FrameGraph::Execute()
+{
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		if (passes[order[i]].execute)
+		{
+			PROFILE_SCOPE(passes[order[i]].profileName);
+			passes[order[i]].execute();
+		}
+	}
+}
+
+int FrameGraph::GetPhysicalTexture(int texture)
+{
+	return textures[texture].physical;
+}
+
+int FrameGraph::GetPhysicalCount()
+{
+	return (int)physicalTextures.size();
+}
+
+FrameGraphTextureDesc FrameGraph::GetPhysicalDesc(int physical)
+{
+	return physicalTextures[physical];
+}
+
+const vector<int>& FrameGraph::GetOrder()
+{
+	return order;
+}
+
+const char* FrameGraph::GetPassName(int pass)
+{
+	return passes[pass].name.c_str();
+}
+
+int FrameGraph::GetPassCount()
+{
+	return (int)passes.size();
+}
+
+int FrameGraph::GetCulledPassCount()
+{
+	return culledPasses;
+}
+
+int FrameGraph::GetPeakTransientBytes()
+{
+	int bytes = 0;
+	for (size_t s = 0; s < physicalTextures.size(); s++)
+		bytes += SizeOf(physicalTextures[s]);
+	return bytes;
+}
+
+int FrameGraph::GetUnaliasedTransientBytes()
+{
+	int bytes = 0;
+	for (size_t t = 0; t < textures.size(); t++)
+	{
+		if (!textures[t].imported && textures[t].physical >= 0)
+			bytes += SizeOf(textures[t].desc);
+	}
+	return bytes;
+}
+
+int FrameGraph::SizeOf(const FrameGraphTextureDesc& desc)
+{
+	return desc.Width * desc.Height * desc.BytesPerPixel;
+}
+
+bool FrameGraph::SameDesc(const FrameGraphTextureDesc& a, const FrameGraphTextureDesc& b)
+{
+	return a.Width == b.Width && a.Height == b.Height && a.Format == b.Format && a.BytesPerPixel == b.BytesPerPixel;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+
+using namespace std;
+
+//Size and format of a texture the graph makes.  Format is whatever the
+//renderer uses (a DXGI_FORMAT in this game), the graph only compares it
+struct FrameGraphTextureDesc
+{
+	int Width;
+	int Height;
+	int Format;
+	int BytesPerPixel;
+};
+
+// --------------------------------------------------------
+// Describes a frame as passes that read and write textures,
+// and works out what has to run and where each texture lives.
+//
+// Compile drops passes nothing needs (only passes that write
+// an imported texture, like the back buffer, are needed for
+// their own sake), orders the rest so every texture is written
+// before it's read, and gives each transient texture a physical
+// slot.  Textures whose lifetimes don't overlap share a slot
+// when their descs match.  The renderer makes one real texture
+// per slot, so nothing here needs a device.
+// --------------------------------------------------------
+class FrameGraph
+{
+public:
+	FrameGraph();
+	~FrameGraph();
+
+	//Forgets every pass and texture, for describing the next frame
+	void Reset();
+
+	//Textures only used inside the frame
+	int CreateTexture(const char* name, FrameGraphTextureDesc desc);
+
+	//Textures that belong to someone else, never aliased
+	int ImportTexture(const char* name);
+
+	int AddPass(const char* name, function<void()> execute);
+	void Read(int pass, int texture);
+	void Write(int pass, int texture);
+
+	//False if the passes can't be ordered, because they read each other's
+	//output.  Reading a texture nothing writes is fine, it's just empty
+	bool Compile();
+
+	//Runs the compiled passes in order
+	void Execute();
+
+	//Slot a transient texture was given, -1 for imported or unused ones
+	int GetPhysicalTexture(int texture);
+	int GetPhysicalCount();
+	FrameGraphTextureDesc GetPhysicalDesc(int physical);
+
+	//Results of the last Compile
+	const vector<int>& GetOrder();
+	const char* GetPassName(int pass);
+	int GetPassCount();
+	int GetCulledPassCount();
+	int GetPeakTransientBytes();
+	int GetUnaliasedTransientBytes();
+
+private:
+	struct Pass
+	{
+		string name;
+		const char* profileName;
+		function<void()> execute;
+		vector<int> reads;
+		vector<int> writes;
+		bool needed;
+	};
+
+	struct Texture
+	{
+		string name;
+		FrameGraphTextureDesc desc;
+		bool imported;
+		int firstUse;
+		int lastUse;
+		int physical;
+	};
+
+	vector<Pass> passes;
+	vector<Texture> textures;
+	vector<int> order;
+	vector<FrameGraphTextureDesc> physicalTextures;
+	vector<int> physicalLastUse;
+	int culledPasses;
+
+	bool IsReady(int pass, const vector<bool>& placed);
+	bool Writes(int pass, int texture);
+	static int SizeOf(const FrameGraphTextureDesc& desc);
+	static bool SameDesc(const FrameGraphTextureDesc& a, const FrameGraphTextureDesc& b);
+};
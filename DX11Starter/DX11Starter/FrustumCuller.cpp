@@ -0,0 +1,168 @@
+#include "FrustumCuller.h"
+#include <xmmintrin.h>
+#include <float.h>
+
+FrustumCuller::FrustumCuller(JobSystem* jobSystem)
+{
+	this->jobSystem = jobSystem;
+	count = 0;
+	visibleCount = 0;
+}
+
+FrustumCuller::~FrustumCuller()
+{
+}
+
+void FrustumCuller::Clear()
+{
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	radius.clear();
+	count = 0;
+	visibility.clear();
+	visibleCount = 0;
+}
+
+int FrustumCuller::Add(XMFLOAT3 center, float radius)
+{
+	//Grow a word at a time, padding with spheres of negative infinite radius
+	if (count == (int)centerX.size())
+	{
+		centerX.resize(count + 32, 0.0f);
+		centerY.resize(count + 32, 0.0f);
+		centerZ.resize(count + 32, 0.0f);
+		this->radius.resize(count + 32, -FLT_MAX);
+	}
+
+	centerX[count] = center.x;
+	centerY[count] = center.y;
+	centerZ[count] = center.z;
+	this->radius[count] = radius;
+	return count++;
+}
+
+int FrustumCuller::GetCount()
+{
+	return count;
+}
+
+void FrustumCuller::Cull(const XMFLOAT4* planes)
+{
+	int words = (int)centerX.size() / 32;
+	visibility.resize(words);
+
+	//Every word is written by exactly one chunk, so chunks can't collide
+	int chunkCount = jobSystem ? (int)jobSystem->GetThreadCount() : 1;
+	if (chunkCount > words / minChunkWords)
+		chunkCount = words / minChunkWords;
+	if (chunkCount > 1)
+	{
+		int chunkWords = (words + chunkCount - 1) / chunkCount;
+		jobSystem->ParallelFor(chunkCount, [&](unsigned int chunk)
+		{
+			int first = chunk * chunkWords;
+			int last = first + chunkWords < words ? first + chunkWords : words;
+			CullWords(planes, first, last);
+		});
+	}
+	else CullWords(planes, 0, words);
+
+	RecountVisible();
+}
+
+void FrustumCuller::RecountVisible()
+{
+	visibleCount = 0;
+	for (size_t i = 0; i < visibility.size(); i++)
+	{
+		//Count set bits
+		unsigned int v = visibility[i];
+		v = v - ((v >> 1) & 0x55555555);
+		v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+		visibleCount += (int)((((v + (v >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+	}
+}
+
+void FrustumCuller::CullWords(const XMFLOAT4* planes, int firstWord, int lastWord)
+{
+	__m128 px[6], py[6], pz[6], pw[6];
+	for (int p = 0; p < 6; p++)
+	{
+		px[p] = _mm_set1_ps(planes[p].x);
+		py[p] = _mm_set1_ps(planes[p].y);
+		pz[p] = _mm_set1_ps(planes[p].z);
+		pw[p] = _mm_set1_ps(planes[p].w);
+	}
+	__m128 zero = _mm_setzero_ps();
+
+	for (int word = firstWord; word < lastWord; word++)
+	{
+		unsigned int bits = 0;
+		for (int group = 0; group < 8; group++)
+		{
+			int i = word * 32 + group * 4;
+			__m128 x = _mm_loadu_ps(&centerX[i]);
+			__m128 y = _mm_loadu_ps(&centerY[i]);
+			__m128 z = _mm_loadu_ps(&centerZ[i]);
+			__m128 negRadius = _mm_sub_ps(zero, _mm_loadu_ps(&radius[i]));
+
+			//Signed distance to each plane has to be at least -radius
+			__m128 inside = _mm_cmpge_ps(zero, zero);
+			for (int p = 0; p < 6; p++)
+			{
+				__m128 d = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)),
+					_mm_add_ps(_mm_mul_ps(pz[p], z), pw[p]));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negRadius));
+			}
+
+			bits |= (unsigned int)_mm_movemask_ps(inside) << (group * 4);
+		}
+		visibility[word] = bits;
+	}
+}
+
+int FrustumCuller::VerifyAgainstScalar(const XMFLOAT4* planes)
+{
+	int wrong = 0;
+	for (int i = 0; i < count; i++)
+	{
+		bool visible = true;
+		for (int p = 0; p < 6 && visible; p++)
+		{
+			float d = planes[p].x * centerX[i] + planes[p].y * centerY[i] + planes[p].z * centerZ[i] + planes[p].w;
+			visible = d >= -radius[i];
+		}
+		if (visible != IsVisible(i))
+			wrong++;
+	}
+	return wrong;
+}
+
+bool FrustumCuller::IsVisible(int index)
+{
+	if (index < 0 || index / 32 >= (int)visibility.size())
+		return false;
+	return (visibility[index / 32] >> (index % 32)) & 1;
+}
+
+int FrustumCuller::GetVisibleCount()
+{
+	return visibleCount;
+}
+
+XMFLOAT4 FrustumCuller::GetSphere(int index)
+{
+	return XMFLOAT4(centerX[index], centerY[index], centerZ[index], radius[index]);
+}
+
+void FrustumCuller::Hide(int index)
+{
+	visibility[index / 32] &= ~(1u << (index % 32));
+}
+
+const vector<unsigned int>& FrustumCuller::GetVisibility()
+{
+	return visibility;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include "Portable.h"
+#include "JobSystem.h"
+
+using namespace std;
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Tests a list of bounding spheres against the camera frustum.
+// Spheres are kept as one array per component, so each step
+// of the plane test covers four spheres with SSE.  The result
+// is one visibility bit per sphere, in the order they were
+// added, which the draw path and the particle system read
+// instead of doing their own plane tests.
+// --------------------------------------------------------
+class FrustumCuller
+{
+public:
+	//Big lists are split across the job system, if there is one
+	FrustumCuller(JobSystem* jobSystem = nullptr);
+	~FrustumCuller();
+
+	void Clear();
+
+	//Returns the sphere's index, which is its bit in the visibility list
+	int Add(XMFLOAT3 center, float radius);
+	int GetCount();
+
+	//Planes as Camera::GetFrustumPlanes gives them.  A sphere is visible
+	//unless it's completely behind one of them
+	void Cull(const XMFLOAT4* planes);
+
+	//Tests every sphere again, one plane and one sphere at a time, and
+	//returns how many disagree with the last Cull
+	int VerifyAgainstScalar(const XMFLOAT4* planes);
+
+	bool IsVisible(int index);
+	int GetVisibleCount();
+
+	//Center and radius of a sphere, for later passes that refine the result
+	XMFLOAT4 GetSphere(int index);
+
+	//Clears a sphere's bit.  Safe from several threads as long as they work
+	//on different words, but the visible count is only right after a Recount
+	void Hide(int index);
+	void RecountVisible();
+
+	//Bit i % 32 of word i / 32 is sphere i
+	const vector<unsigned int>& GetVisibility();
+
+private:
+	JobSystem* jobSystem;
+
+	//Padded to a whole number of visibility words with spheres that can
+	//never be visible, so Cull never has to deal with leftovers
+	vector<float> centerX;
+	vector<float> centerY;
+	vector<float> centerZ;
+	vector<float> radius;
+	int count;
+
+	vector<unsigned int> visibility;
+	int visibleCount;
+
+	void CullWords(const XMFLOAT4* planes, int firstWord, int lastWord);
+
+	//Below this many words per chunk it's not worth splitting
+	const int minChunkWords = 256;
+};
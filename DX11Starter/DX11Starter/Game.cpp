@@ -2,8 +2,13 @@
 #include "Vertex.h"
 #include "WICTextureLoader.h"
 #include "DDSTextureLoader.h"
+#include "Profiler.h"
+#include "ShaderConstantsCheck.h"
 #include <math.h>
+#include <stdio.h>
+#include <chrono>
 #include <string>
+#include <algorithm>
 
 // For the DirectX Math library
 using namespace DirectX;
@@ -64,15 +69,10 @@ Game::~Game()
 	ppSampler->Release();
 
 	//Clean up Game Objects
-	while (entities.size() > 0)
-	{
-		delete entities[entities.size()-1];
-		entities.pop_back();
-	}
-
-	delete targetManager;
-	delete fireManager;
+	delete simulation;
 	delete lightManager;
+	delete entityRenderer;
+	reticuleBlendState->Release();
 
 	skybox->depthState->Release();
 	skybox->rasterState->Release();
@@ -81,20 +81,27 @@ Game::~Game()
 	//Get rid of particle stuff
 	fire->Release();
 	additiveBlendState->Release();
+	alphaBlendState->Release();
 	particleDepthState->Release();
-	delete smoke;
-	delete leftThruster;
-	delete rightThruster;
-	delete thruster;
+	delete particleRenderer;
+	delete renderQueue;
+	delete frustumCuller;
+	delete occlusionCuller;
+	delete jobSystem;
+	Profiler::Shutdown();
 
 	//Clean up render targets
-	delete baseTarget;
-	delete bloomTarget;
-	delete bloomTarget2;
-	delete radialTarget;
+	for (size_t i = 0; i < postTargets.size(); i++)
+	{
+		delete postTargets[i];
+	}
+	delete frameGraph;
 
 	//Clean up camera
 	delete camera;
+	delete frameConstants;
+	delete stateCache;
+	delete stateTarget;
 
 	//Clean up UI
 	delete spriteBatch;
@@ -126,7 +133,7 @@ void Game::Init()
 	// geometry to draw and some simple camera matrices.
 	//  - You'll be expanding and/or replacing these later
 	LoadResources();
-	PrepPostProcessing();
+	frameGraph = new FrameGraph();
 	SetupGameWorld();
 
 	// Tell the input assembler stage of the pipeline what kind of
@@ -159,6 +166,14 @@ void Game::LoadResources()
 	shipPS->LoadShaderFile(L"ShipPS.cso");
 	pixelShaders.insert(pair<char*, SimplePixelShader*>("shipPS", shipPS));
 
+	SimpleVertexShader* shipInstancedVS = new SimpleVertexShader(device, context);
+	shipInstancedVS->LoadShaderFile(L"ShipInstancedVS.cso");
+	vertexShaders.insert(pair<char*, SimpleVertexShader*>("shipInstancedVS", shipInstancedVS));
+
+	SimplePixelShader* shipInstancedPS = new SimplePixelShader(device, context);
+	shipInstancedPS->LoadShaderFile(L"ShipInstancedPS.cso");
+	pixelShaders.insert(pair<char*, SimplePixelShader*>("shipInstancedPS", shipInstancedPS));
+
 	SimpleVertexShader* skyboxVS = new SimpleVertexShader(device, context);
 	skyboxVS->LoadShaderFile(L"SkyboxVS.cso");
 	vertexShaders.insert(pair<char*, SimpleVertexShader*>("skyboxVS", skyboxVS));
@@ -175,6 +190,14 @@ void Game::LoadResources()
 	bulletPS->LoadShaderFile(L"BulletPS.cso");
 	pixelShaders.insert(pair<char*, SimplePixelShader*>("bulletPS", bulletPS));
 
+	SimpleVertexShader* bulletInstancedVS = new SimpleVertexShader(device, context);
+	bulletInstancedVS->LoadShaderFile(L"BulletInstancedVS.cso");
+	vertexShaders.insert(pair<char*, SimpleVertexShader*>("bulletInstancedVS", bulletInstancedVS));
+
+	SimplePixelShader* bulletInstancedPS = new SimplePixelShader(device, context);
+	bulletInstancedPS->LoadShaderFile(L"BulletInstancedPS.cso");
+	pixelShaders.insert(pair<char*, SimplePixelShader*>("bulletInstancedPS", bulletInstancedPS));
+
 	SimpleVertexShader* PPVS = new SimpleVertexShader(device, context);
 	PPVS->LoadShaderFile(L"PPVS.cso");
 	vertexShaders.insert(pair<char*, SimpleVertexShader*>("PPVS", PPVS));
@@ -203,6 +226,28 @@ void Game::LoadResources()
 	radialPS->LoadShaderFile(L"RadialPS.cso");
 	pixelShaders.insert(pair<char*, SimplePixelShader*>("radialPS", radialPS));
 
+#if defined(DEBUG) || defined(_DEBUG)
+	//The generated cbuffer structs have to match what the compiler made
+	if (CheckShaderConstants() > 0)
+		printf("\nShaderConstants.h doesn't match the compiled shaders, rerun Tools/GenerateShaderConstants.py\n");
+#endif
+
+	//Every shader with a perFrame cbuffer reads the same one, and binds
+	//through the same state cache
+	frameConstants = new FrameConstants(device);
+	stateTarget = new D3DStateTarget(context);
+	stateCache = new StateCache(stateTarget);
+	for (pair<char* const, SimpleVertexShader*> &vertexShader : vertexShaders)
+	{
+		frameConstants->Attach(vertexShader.second);
+		vertexShader.second->SetStateCache(stateCache);
+	}
+	for (pair<char* const, SimplePixelShader*> &pixelShader : pixelShaders)
+	{
+		frameConstants->Attach(pixelShader.second);
+		pixelShader.second->SetStateCache(stateCache);
+	}
+
 	//Load textures
 	ID3D11ShaderResourceView* marble = 0;
 	ID3D11ShaderResourceView* playerTex = 0;
@@ -252,6 +297,12 @@ void Game::LoadResources()
 	materials.insert(pair<char*, Material*>("bullet", new Material(vertexShaders.find("bulletVS")->second, pixelShaders.find("bulletPS")->second, marble, sampler)));
 	materials.insert(pair<char*, Material*>("crosshairs", new Material(vertexShaders.find("basicVertexShader")->second, pixelShaders.find("basicPixelShader")->second, crosshairs, sampler)));
 
+	//Instanced versions for the materials lots of entities share
+	materials.insert(pair<char*, Material*>("enemy1Instanced", new Material(vertexShaders.find("shipInstancedVS")->second, pixelShaders.find("shipInstancedPS")->second, enemy1, enemyNorm, sampler)));
+	materials.insert(pair<char*, Material*>("bulletInstanced", new Material(vertexShaders.find("bulletInstancedVS")->second, pixelShaders.find("bulletInstancedPS")->second, marble, sampler)));
+	materials.find("enemy1")->second->SetInstanced(materials.find("enemy1Instanced")->second);
+	materials.find("bullet")->second->SetInstanced(materials.find("bulletInstanced")->second);
+
 	//Release DirX stuff (references are added in each material)
 	marble->Release();
 	playerTex->Release();
@@ -276,43 +327,60 @@ void Game::LoadResources()
 
 void Game::PrepPostProcessing()
 {
-	//Create 2DTexture to render to
-	D3D11_TEXTURE2D_DESC ppTexDesc = {};
-	ppTexDesc.Width = width;
-	ppTexDesc.Height = height;
-	ppTexDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	ppTexDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-	ppTexDesc.ArraySize = 1;
-	ppTexDesc.MipLevels = 1;
-	ppTexDesc.CPUAccessFlags = 0;
-	ppTexDesc.MiscFlags = 0;
-	ppTexDesc.SampleDesc.Count = 1;
-	ppTexDesc.SampleDesc.Quality = 0;
-	ppTexDesc.Usage = D3D11_USAGE_DEFAULT;
-
-	//Create RTV
-	D3D11_RENDER_TARGET_VIEW_DESC ppRTVDesc = {};
-	ppRTVDesc.Format = ppTexDesc.Format;
-	ppRTVDesc.Texture2D.MipSlice = 0;
-	ppRTVDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
-
-	//Create SRV
-	D3D11_SHADER_RESOURCE_VIEW_DESC ppSRVDesc = {};
-	ppSRVDesc.Format = ppTexDesc.Format;
-	ppSRVDesc.Texture2D.MipLevels = 1;
-	ppSRVDesc.Texture2D.MostDetailedMip = 0;
-	ppSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-
-	//Base target to render scene to
-	baseTarget = new DXRenderTarget(device, ppTexDesc, ppRTVDesc, ppSRVDesc);
-
-	//Light Bloom targets
-	bloomTarget = new DXRenderTarget(device, ppTexDesc, ppRTVDesc, ppSRVDesc);
-	bloomTarget2 = new DXRenderTarget(device, ppTexDesc, ppRTVDesc, ppSRVDesc);
-
-	//Radial blur target
-	radialTarget = new DXRenderTarget(device, ppTexDesc, ppRTVDesc, ppSRVDesc);
+	//Only remade when the graph's slots change (a resize, or an effect
+	//turned on or off), so a frame like the last one allocates nothing
+	bool same = postTargetDescs.size() == (size_t)frameGraph->GetPhysicalCount();
+	for (size_t i = 0; i < postTargetDescs.size() && same; i++)
+	{
+		FrameGraphTextureDesc desc = frameGraph->GetPhysicalDesc((int)i);
+		same = desc.Width == postTargetDescs[i].Width &&
+			desc.Height == postTargetDescs[i].Height &&
+			desc.Format == postTargetDescs[i].Format;
+	}
+	if (same)
+		return;
+
+	for (size_t i = 0; i < postTargets.size(); i++)
+	{
+		delete postTargets[i];
+	}
+	postTargets.clear();
+	postTargetDescs.clear();
 
+	for (int i = 0; i < frameGraph->GetPhysicalCount(); i++)
+	{
+		FrameGraphTextureDesc desc = frameGraph->GetPhysicalDesc(i);
+
+		//Create 2DTexture to render to
+		D3D11_TEXTURE2D_DESC ppTexDesc = {};
+		ppTexDesc.Width = desc.Width;
+		ppTexDesc.Height = desc.Height;
+		ppTexDesc.Format = (DXGI_FORMAT)desc.Format;
+		ppTexDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+		ppTexDesc.ArraySize = 1;
+		ppTexDesc.MipLevels = 1;
+		ppTexDesc.CPUAccessFlags = 0;
+		ppTexDesc.MiscFlags = 0;
+		ppTexDesc.SampleDesc.Count = 1;
+		ppTexDesc.SampleDesc.Quality = 0;
+		ppTexDesc.Usage = D3D11_USAGE_DEFAULT;
+
+		//Create RTV
+		D3D11_RENDER_TARGET_VIEW_DESC ppRTVDesc = {};
+		ppRTVDesc.Format = ppTexDesc.Format;
+		ppRTVDesc.Texture2D.MipSlice = 0;
+		ppRTVDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+
+		//Create SRV
+		D3D11_SHADER_RESOURCE_VIEW_DESC ppSRVDesc = {};
+		ppSRVDesc.Format = ppTexDesc.Format;
+		ppSRVDesc.Texture2D.MipLevels = 1;
+		ppSRVDesc.Texture2D.MostDetailedMip = 0;
+		ppSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+
+		postTargets.push_back(new DXRenderTarget(device, ppTexDesc, ppRTVDesc, ppSRVDesc));
+		postTargetDescs.push_back(desc);
+	}
 }
 
 // --------------------------------------------------------
@@ -321,69 +389,64 @@ void Game::PrepPostProcessing()
 void Game::SetupGameWorld()
 {
 	//Set up lights and sky
-	lightManager = new LightManager();
+	lightManager = new LightManager(device);
 	skybox = new Skybox();
 
-	//Create smoke for targets
-	smoke = new ParticleEmitter(
-		500,							// Max particles
-		50,							// Particles per second
-		0.5f,								// Particle lifetime
-		1,							// Start size
-		0.1f,							// End size
-		XMFLOAT4(1, 0.5f, 0, 0.6f),	// Start color
-		XMFLOAT4(0, 0, 0, 0.5f),		// End color
-		XMFLOAT3(0, 1, 0),				// Start velocity
-		XMFLOAT3(0, 0, 0),				// Start position
-		XMFLOAT3(0, 2, 0),				// Start acceleration
-		device,
-		vertexShaders.find("particleVS")->second,
-		pixelShaders.find("particlePS")->second,
-		fire,
-		2);
-
-	thruster = new ParticleEmitter(
-		500,							// Max particles
-		50,							// Particles per second
-		0.5f,								// Particle lifetime
-		0.5,							// Start size
-		0.15f,							// End size
-		XMFLOAT4(0.4f, 0.4f, 0.4f, 0.6f),	// Start color
-		XMFLOAT4(0, 0, 0, 0.5f),		// End color
-		XMFLOAT3(0, 0, 1),				// Start velocity
-		XMFLOAT3(0, 0, 0),				// Start position
-		XMFLOAT3(0, 0, 3),				// Start acceleration
-		device,
-		vertexShaders.find("particleVS")->second,
-		pixelShaders.find("particlePS")->second,
-		fire,
-		NULL);
-
-	//Make target field
-	targetManager = new TargetManager(meshes.find("enemy1")->second, materials.find("enemy1")->second, smoke, thruster, device);
-	for each (Entity* e in targetManager->GetTargets())
-	{
-		entities.push_back(e);
-		lightManager->pointLights.push_back(((Target*) e)->GetEngine());
-	}
+	//Worker threads and the particle scheduler that uses them
+	jobSystem = new JobSystem();
+	entityRenderer = new EntityRenderer();
+	renderQueue = new RenderQueue(jobSystem, device, entityRenderer);
+	frustumCuller = new FrustumCuller(jobSystem);
+	occlusionCuller = new OcclusionCuller(jobSystem);
+	particleRenderer = new ParticleRenderer(jobSystem, device);
+
+	//The simulation only gets handles, meshes and materials stay with us
+	SimulationAssets assets = {};
+	Mesh* enemyMesh = meshes.find("enemy1")->second;
+	assets.Target.Mesh = entityRenderer->AddMesh(enemyMesh);
+	assets.Target.Material = entityRenderer->AddMaterial(materials.find("enemy1")->second);
+	assets.Target.Radius = enemyMesh->GetRadius();
+	Mesh* playerMesh = meshes.find("player")->second;
+	assets.Player.Mesh = entityRenderer->AddMesh(playerMesh);
+	assets.Player.Material = entityRenderer->AddMaterial(materials.find("playerTex")->second);
+	assets.Player.Radius = playerMesh->GetRadius();
+	Mesh* bulletMesh = meshes.find("sphere")->second;
+	assets.Bullet.Mesh = entityRenderer->AddMesh(bulletMesh);
+	assets.Bullet.Material = entityRenderer->AddMaterial(materials.find("bullet")->second);
+	assets.Bullet.Radius = bulletMesh->GetRadius();
+	Mesh* reticuleMesh = meshes.find("plane")->second;
+	assets.Reticule.Mesh = entityRenderer->AddMesh(reticuleMesh);
+	assets.Reticule.Material = entityRenderer->AddMaterial(materials.find("crosshairs")->second);
+	assets.Reticule.Radius = reticuleMesh->GetRadius();
+	assets.Particles = particleRenderer->AddMaterial(vertexShaders.find("particleVS")->second, pixelShaders.find("particlePS")->second, fire);
+
+	//Emitters just claim a slice of the particle pool now, so creating them should be cheap
+	std::chrono::high_resolution_clock::time_point emitterStart = std::chrono::high_resolution_clock::now();
+
+	//Gameplay, moved along by Update
+	simulation = new Simulation(assets, jobSystem, camera, worldSeed);
 
-	//Make player
-	player = new Player(meshes.find("player")->second, materials.find("playerTex")->second);
-	lightManager->pointLights.push_back(player->GetLeftEngine());
-	lightManager->pointLights.push_back(player->GetRightEngine());
-	entities.push_back(player);
+#if defined(DEBUG) || defined(_DEBUG)
+	std::chrono::duration<double, std::milli> emitterTime = std::chrono::high_resolution_clock::now() - emitterStart;
+	printf("\nCreated %d particle emitters in %.3f ms, %d KB particle pool",
+		simulation->GetParticleSystem()->GetEmitterCount(),
+		emitterTime.count(),
+		simulation->GetParticleSystem()->GetPoolBytes() / 1024);
+#endif
 
-	//Make fire control
-	fireManager = new FireManager(meshes.find("sphere")->second, materials.find("bullet")->second);
-	for each (Bullet* b in fireManager->GetBullets())
+	//Every light in the world
+	for (Entity* e : simulation->GetTargetManager()->GetTargets())
+	{
+		lightManager->pointLights.push_back(((Target*) e)->GetEngine());
+	}
+	lightManager->pointLights.push_back(simulation->GetPlayer()->GetLeftEngine());
+	lightManager->pointLights.push_back(simulation->GetPlayer()->GetRightEngine());
+	for (Entity* b : simulation->GetFireManager()->GetBullets())
 	{
-		entities.push_back(b);
-		b->Link(player);
-		lightManager->pointLights.push_back(b->GetLaser());
+		lightManager->pointLights.push_back(((Bullet*) b)->GetLaser());
 	}
 
-	//Make reticule
-	ID3D11BlendState* rb;
+	//Reticule blends over the scene
 	D3D11_BLEND_DESC reticuleBlend = {};
 	reticuleBlend.AlphaToCoverageEnable = false;
 	reticuleBlend.IndependentBlendEnable = false;
@@ -395,10 +458,7 @@ void Game::SetupGameWorld()
 	reticuleBlend.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
 	reticuleBlend.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
 	reticuleBlend.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
-	device->CreateBlendState(&reticuleBlend, &rb);
-	reticule = new Reticule(meshes.find("plane")->second, materials.find("crosshairs")->second, player, targetManager, rb, fireManager->GetBullets().at(0)->GetRadius());
-	reticule->SetActive(true);
-	entities.push_back(reticule);
+	device->CreateBlendState(&reticuleBlend, &reticuleBlendState);
 
 	DirectionalLight d = DirectionalLight();
 	d.AmbientColor = XMFLOAT4(+0.2f, +0.2f, +0.2f, 1.0f);
@@ -444,24 +504,13 @@ void Game::SetupGameWorld()
 	blend.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
 	device->CreateBlendState(&blend, &additiveBlendState);
 
-	// Set up particles for player engines
-	leftThruster = new ParticleEmitter(
-		500,							// Max particles
-		50,							// Particles per second
-		0.5f,								// Particle lifetime
-		0.2f,							// Start size
-		0.1f,							// End size
-		XMFLOAT4(0, 0.5f, 1, 0.6f),	// Start color
-		XMFLOAT4(0, 0.5f, 1, 0.2f),		// End color
-		XMFLOAT3(0, 0, -1),				// Start velocity
-		XMFLOAT3(0, 0, 0),				// Start position
-		XMFLOAT3(0, 0, -5),				// Start acceleration
-		device,
-		vertexShaders.find("particleVS")->second,
-		pixelShaders.find("particlePS")->second,
-		fire,
-		NULL);
-	rightThruster = leftThruster->Clone(device);
+	// Blend for alpha blended particles, the particle shader already
+	// multiplies its color by alpha so the source side is just ONE
+	blend.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+	blend.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+	blend.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+	blend.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+	device->CreateBlendState(&blend, &alphaBlendState);
 }
 
 
@@ -487,185 +536,670 @@ void Game::Update(float deltaTime, float totalTime)
 	if (GetAsyncKeyState(VK_ESCAPE))
 		Quit();
 
-	//Chech if player is firing
-	if (GetAsyncKeyState(VK_SPACE) & 0x8000)
+	//Move everything along, collide, and wrap the level
+	simulation->Step(ReadInput(), deltaTime, totalTime);
+}
+
+#if defined(DEBUG) || defined(_DEBUG)
+// --------------------------------------------------------
+// Debug keys for stats and toggles.  Called once per drawn
+// frame, however many simulation steps Update ran
+// --------------------------------------------------------
+void Game::HandleDebugKeys()
+{
+	//Report particle timings for the current thread count and move on to the next one
+	if (GetAsyncKeyState('T') & 0x8000)
 	{
-		fireManager->Fire(deltaTime, totalTime, true);
+		if (!threadKeyDown)
+		{
+			ParticleSystem* particleSystem = simulation->GetParticleSystem();
+			unsigned int threads = jobSystem->GetThreadCount();
+			printf("\nParticles: %d live, %.4f ms/frame on %u thread(s), %d bytes uploaded in %d draw(s) last frame",
+				particleSystem->GetAverageParticleCount(),
+				particleSystem->GetAverageUpdateTime(),
+				threads,
+				particleUploadBytes,
+				particleRenderer->GetLastDrawCalls());
+			printf("\nEmitters: %d active, %d sleeping, %d culled, %d KB of shared GPU buffers",
+				particleSystem->GetActiveEmitterCount(),
+				particleSystem->GetSleepingEmitterCount(),
+				particleSystem->GetCulledEmitterCount(),
+				particleRenderer->GetGpuBytes() / 1024);
+			if (particleRenderer->IsSorting())
+				printf(", sorting %.0f particles/ms", particleRenderer->GetAverageSortRate());
+			printf("\nLights: %d sent, %d culled across %d entities, %d bytes of light data uploaded last frame",
+				lightManager->GetSentLightCount(),
+				lightManager->GetCulledLightCount(),
+				(int)simulation->GetEntities().size(),
+				lightManager->GetLightUploadBytes());
+			const SimpleBufferStats& bufferStats = ISimpleShader::GetLastFrameStats();
+			printf("\nConstant buffers: %u uploaded (%u bytes), %u unchanged and skipped last frame",
+				bufferStats.BuffersUploaded,
+				bufferStats.BytesUploaded,
+				bufferStats.BuffersSkipped);
+			int draws = renderQueue->GetDrawCount();
+			printf("\nShader data last frame: %d bytes per frame, %d material binds, %u bytes of per object data (%u per draw)",
+				frameConstants->GetUploadBytes(),
+				Material::GetBindCount(),
+				bufferStats.ObjectBytesUploaded,
+				draws > 0 ? bufferStats.ObjectBytesUploaded / draws : 0);
+			printf("\nState changes: %d issued, %d filtered as redundant last frame%s",
+				stateCache->GetIssuedCalls(),
+				stateCache->GetFilteredCalls(),
+				stateCache->IsFiltering() ? "" : " (filtering off)");
+			printf("\nRender queue: %d draws, %d state changes, %.4f ms sorting last frame",
+				renderQueue->GetDrawCount(),
+				renderQueue->GetStateChanges(),
+				renderQueue->GetSortTime());
+			printf("\nFrustum culling: %d of %d entities in view last frame",
+				frustumCuller->GetVisibleCount(),
+				frustumCuller->GetCount());
+			if (occlusionCulling)
+				printf("\nOcclusion culling: %d hidden behind %d occluders in %.4f ms last frame",
+					occlusionCuller->GetHiddenCount(),
+					occlusionCuller->GetOccluderCount(),
+					occlusionCuller->GetTime());
+			printf("\nFrame graph: %d passes (%d culled), %d targets, %d KB peak vs %d KB without aliasing",
+				frameGraph->GetPassCount() - frameGraph->GetCulledPassCount(),
+				frameGraph->GetCulledPassCount(),
+				frameGraph->GetPhysicalCount(),
+				frameGraph->GetPeakTransientBytes() / 1024,
+				frameGraph->GetUnaliasedTransientBytes() / 1024);
+			printf("\nInstancing: %d entities in batches, %d bytes of instance data last frame%s",
+				renderQueue->GetInstancedCount(),
+				renderQueue->GetInstanceUploadBytes(),
+				renderQueue->IsInstancing() ? "" : " (instancing off)");
+
+			jobSystem->SetThreadCount(threads % JobSystem::GetHardwareThreadCount() + 1);
+			particleSystem->ResetTimings();
+			particleRenderer->ResetTimings();
+		}
+		threadKeyDown = true;
 	}
-	else fireManager->Fire(deltaTime, totalTime, false);
+	else threadKeyDown = false;
 
-	//Player movement control
-	float aX = 0.0f;
-	float aY = 0.0f;
-	if (GetAsyncKeyState(VK_LEFT) & 0x8000 || GetAsyncKeyState('A') & 0x8000)
+	//Toggle back to front particle sorting
+	if (GetAsyncKeyState('Y') & 0x8000)
 	{
-		//move left
-		//player->Move(-3 * deltaTime, 0, 0);
-		aX = -player->accelRate * deltaTime;
+		if (!sortKeyDown)
+		{
+			particleRenderer->SetSorting(!particleRenderer->IsSorting());
+			particleRenderer->ResetTimings();
+			printf("\nParticle sorting %s", particleRenderer->IsSorting() ? "on" : "off");
+		}
+		sortKeyDown = true;
 	}
-	if (GetAsyncKeyState(VK_RIGHT) & 0x8000 || GetAsyncKeyState('D') & 0x8000)
+	else sortKeyDown = false;
+
+	//Check clustered light assignment against brute force
+	if (GetAsyncKeyState('L') & 0x8000)
 	{
-		//move right
-		//player->Move(3 * deltaTime, 0, 0);
-		aX = player->accelRate * deltaTime;
+		if (!clusterKeyDown)
+			TestLightClusters();
+		clusterKeyDown = true;
 	}
-	if (GetAsyncKeyState(VK_DOWN) & 0x8000 || GetAsyncKeyState('S') & 0x8000)
+	else clusterKeyDown = false;
+
+	//Turn redundant state filtering off and on, to check the frame looks the same
+	if (GetAsyncKeyState('C') & 0x8000)
+	{
+		if (!cacheKeyDown)
+		{
+			stateCache->SetFiltering(!stateCache->IsFiltering());
+			printf("\nState filtering %s", stateCache->IsFiltering() ? "on" : "off");
+		}
+		cacheKeyDown = true;
+	}
+	else cacheKeyDown = false;
+
+	//Turn instancing off and on, to compare against one draw per entity
+	if (GetAsyncKeyState('I') & 0x8000)
 	{
-		//move up (lean back)
-		//player->Move(0, 3 * deltaTime, 0);
-		aY = player->accelRate * deltaTime;
+		if (!instanceKeyDown)
+		{
+			renderQueue->SetInstancing(!renderQueue->IsInstancing());
+			printf("\nInstancing %s", renderQueue->IsInstancing() ? "on" : "off");
+		}
+		instanceKeyDown = true;
 	}
+	else instanceKeyDown = false;
+
+	//Turn occlusion culling off and on, to see what it hides
+	if (GetAsyncKeyState('O') & 0x8000)
+	{
+		if (!occlusionKeyDown)
+		{
+			occlusionCulling = !occlusionCulling;
+			printf("\nOcclusion culling %s", occlusionCulling ? "on" : "off");
+		}
+		occlusionKeyDown = true;
+	}
+	else occlusionKeyDown = false;
+
+	//Turn the postprocessing effects off and on, passes and targets go with them
+	if (GetAsyncKeyState('B') & 0x8000)
+	{
+		if (!bloomKeyDown)
+		{
+			bloom = !bloom;
+			printf("\nBloom %s", bloom ? "on" : "off");
+		}
+		bloomKeyDown = true;
+	}
+	else bloomKeyDown = false;
+
+	if (GetAsyncKeyState('R') & 0x8000)
+	{
+		if (!radialKeyDown)
+		{
+			radialBlur = !radialBlur;
+			printf("\nRadial blur %s", radialBlur ? "on" : "off");
+		}
+		radialKeyDown = true;
+	}
+	else radialKeyDown = false;
+
+	//Cycle the simulation rate, to check the game plays the same at each
+	if (GetAsyncKeyState('F') & 0x8000)
+	{
+		if (!rateKeyDown)
+		{
+			float rate = GetSimulationRate();
+			rate = rate == 60.0f ? 20.0f : (rate == 20.0f ? 144.0f : (rate == 144.0f ? 0.0f : 60.0f));
+			SetSimulationRate(rate);
+			if (rate > 0.0f)
+				printf("\nSimulation at %.0f Hz", rate);
+			else printf("\nSimulation once per frame");
+		}
+		rateKeyDown = true;
+	}
+	else rateKeyDown = false;
+
+	//Start a profiler capture, then stop it and write it out for chrome://tracing
+	if (GetAsyncKeyState('P') & 0x8000)
+	{
+		if (!profileKeyDown)
+		{
+			if (!Profiler::IsCapturing())
+			{
+				//Measured once, the first time it's needed, for the overhead in PrintProfile
+				if (Profiler::GetZoneCost() == 0.0)
+					printf("\nProfiler zones cost %.5f ms each", Profiler::Calibrate());
+				Profiler::BeginCapture();
+				printf("\nProfiler capture started");
+			}
+			else
+			{
+				bool saved = Profiler::EndCapture("trace.json");
+				printf("\nProfiler capture %s", saved ? "written to trace.json" : "couldn't be written");
+				if (Profiler::GetDroppedCount() > 0)
+					printf(", %d zones were dropped", Profiler::GetDroppedCount());
+				PrintProfile();
+			}
+		}
+		profileKeyDown = true;
+	}
+	else profileKeyDown = false;
+
+	//Time shader binding, culling and post processing against their old versions.
+	//They take a while, so only when asked rather than on every launch
+	if (GetAsyncKeyState('H') & 0x8000)
+	{
+		if (!benchmarkKeyDown)
+		{
+			BenchmarkShaderBinding();
+			BenchmarkFrustumCulling();
+			BenchmarkOcclusionCulling();
+			BenchmarkPostProcessing();
+		}
+		benchmarkKeyDown = true;
+	}
+	else benchmarkKeyDown = false;
+}
+#endif
+
+// --------------------------------------------------------
+// Turns the keys held right now into input for the simulation
+// --------------------------------------------------------
+GameInput Game::ReadInput()
+{
+	GameInput input = {};
+	if (GetAsyncKeyState(VK_LEFT) & 0x8000 || GetAsyncKeyState('A') & 0x8000)
+		input.MoveX = -1.0f;
+	if (GetAsyncKeyState(VK_RIGHT) & 0x8000 || GetAsyncKeyState('D') & 0x8000)
+		input.MoveX = 1.0f;
+
+	//Down leans back, up leans forward
+	if (GetAsyncKeyState(VK_DOWN) & 0x8000 || GetAsyncKeyState('S') & 0x8000)
+		input.MoveY = 1.0f;
 	if (GetAsyncKeyState(VK_UP) & 0x8000 || GetAsyncKeyState('W') & 0x8000)
+		input.MoveY = -1.0f;
+
+	input.Fire = (GetAsyncKeyState(VK_SPACE) & 0x8000) != 0;
+	return input;
+}
+
+#if defined(DEBUG) || defined(_DEBUG)
+// --------------------------------------------------------
+// Builds light clusters for the current view, once with the
+// game's lights and once with a few thousand made up ones,
+// and checks both against testing every light in every cluster
+// --------------------------------------------------------
+void Game::TestLightClusters()
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	lightManager->BuildClusters(camera->GetView(), camera->GetProj());
+	std::chrono::duration<double, std::milli> buildTime = std::chrono::high_resolution_clock::now() - start;
+
+	LightClusters* clusters = lightManager->GetClusters();
+	printf("\nLight clusters: %d lights, %d assignments in %.3f ms, %d clusters differ from brute force",
+		(int)lightManager->pointLights.size(),
+		(int)clusters->GetLightIndices().size(),
+		buildTime.count(),
+		clusters->VerifyAgainstBruteForce());
+
+	//Stress test, scattered around the camera
+	Random random(worldSeed);
+	XMFLOAT3 eye = camera->GetCamPosition();
+	vector<PointLight> stressLights(4096);
+	vector<PointLight*> stressPointers(stressLights.size());
+	for (size_t i = 0; i < stressLights.size(); i++)
 	{
-		//move down (lean forward)
-		//player->Move(0, -3 * deltaTime, 0);
-		aY = -player->accelRate * deltaTime;
+		stressLights[i].Position = XMFLOAT3(eye.x + random.Range(-40.0f, 40.0f), eye.y + random.Range(-20.0f, 20.0f), eye.z + random.Range(-5.0f, 100.0f));
+		stressLights[i].Radius = random.Range(0.0f, 0.01f);
+		stressPointers[i] = &stressLights[i];
 	}
-	player->Accelerate(aX, aY, 0);
-	XMFLOAT3 v = player->velocity;
-	player->Move(v.x, v.y, v.z);
-	player->Decelerate(player->decelRate * deltaTime);
 
-	//Update Camera
-	camera->SetPosition(player->GetPosition().x / 4.0f, player->GetPosition().y / 4.0f, player->GetPosition().z - 4.0f);
-	camera->Update(deltaTime, totalTime, player->GetPosition());
+	LightClusters stress;
+	start = std::chrono::high_resolution_clock::now();
+	stress.Build(camera->GetView(), camera->GetProj(), stressPointers);
+	buildTime = std::chrono::high_resolution_clock::now() - start;
 
-	//Keep thrusters close to player
-	leftThruster->SetEmitterPosition(XMFLOAT3(player->GetPosition().x + 0.16f, player->GetPosition().y + 0.15f, player->GetPosition().z - 0.8f));
-	leftThruster->Update(deltaTime);
+	printf("\nLight clusters: %d lights, %d assignments in %.3f ms, %d clusters differ from brute force",
+		(int)stressLights.size(),
+		(int)stress.GetLightIndices().size(),
+		buildTime.count(),
+		stress.VerifyAgainstBruteForce());
+}
 
-	rightThruster->SetEmitterPosition(XMFLOAT3(player->GetPosition().x - 0.16f, player->GetPosition().y + 0.15f, player->GetPosition().z - 0.8f));
-	rightThruster->Update(deltaTime);
+// --------------------------------------------------------
+// Times the per object variables a ship draw sets, by name
+// and by handle, to see what the lookups were costing
+// --------------------------------------------------------
+void Game::BenchmarkShaderBinding()
+{
+	const int iterations = 100000;
+	Material* material = materials.find("enemy1")->second;
+	SimpleVertexShader* vShader = material->GetVertexShader();
+	SimplePixelShader* pShader = material->GetPixelShader();
+	const MaterialHandles& h = material->GetHandles();
+
+	XMFLOAT4X4 matrix = camera->GetView();
+	unsigned int lightIndices[LightManager::maxLightsPerObject] = {};
+	int lightCount = 0;
 
-	//Update Entities
-	for each (Entity* e in entities)
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++)
 	{
-		e->Update(deltaTime, totalTime);
+		vShader->SetMatrix4x4("world", matrix);
+		vShader->SetMatrix4x4("normalWorld", matrix);
+		pShader->SetData("lightIndices", lightIndices, sizeof(unsigned int) * LightManager::maxLightsPerObject);
+		pShader->SetData("pointLightCount", &lightCount, sizeof(int));
 	}
+	std::chrono::duration<double, std::nano> nameTime = std::chrono::high_resolution_clock::now() - start;
 
-	//Collision detection
-	CheckForCollisions(fireManager->GetBullets(), targetManager->GetTargets());
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		vShader->SetMatrix4x4(h.World, matrix);
+		vShader->SetMatrix4x4(h.NormalWorld, matrix);
+		pShader->SetData(h.LightIndices, lightIndices, sizeof(unsigned int) * LightManager::maxLightsPerObject);
+		pShader->SetInt(h.PointLightCount, lightCount);
+	}
+	std::chrono::duration<double, std::nano> handleTime = std::chrono::high_resolution_clock::now() - start;
 
-	//Reset level when player passes end
-	if (player->GetPosition().z > 350.0f) {
-		targetManager->ResetTargets();
-		player->SetPosition(player->GetPosition().x, player->GetPosition().y, -50.0f);
+	printf("\nShader variable sets: %.1f ns by name, %.1f ns by handle",
+		nameTime.count() / (iterations * 4),
+		handleTime.count() / (iterations * 4));
+}
+
+// --------------------------------------------------------
+// Culls 100k spheres scattered around the camera with the SIMD
+// culler, then again one at a time, and checks they agree
+// --------------------------------------------------------
+void Game::BenchmarkFrustumCulling()
+{
+	const int sphereCount = 100000;
+
+	//Look straight down the level from wherever the camera is, which is what
+	//the spheres are scattered around.  Draw points it back at the player after
+	XMFLOAT3 eye = camera->GetCamPosition();
+	camera->LookTo(eye, XMFLOAT3(0.0f, 0.0f, 1.0f));
+	XMFLOAT4 planes[6];
+	camera->GetFrustumPlanes(planes);
+
+	Random random(worldSeed);
+	FrustumCuller culler(jobSystem);
+	for (int i = 0; i < sphereCount; i++)
+	{
+		XMFLOAT3 center(eye.x + random.Range(-150.0f, 150.0f), eye.y + random.Range(-50.0f, 50.0f), eye.z + random.Range(-100.0f, 200.0f));
+		culler.Add(center, random.Range(0.1f, 3.0f));
 	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	culler.Cull(planes);
+	std::chrono::duration<double, std::milli> simdTime = std::chrono::high_resolution_clock::now() - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	int wrong = culler.VerifyAgainstScalar(planes);
+	std::chrono::duration<double, std::milli> scalarTime = std::chrono::high_resolution_clock::now() - start;
+
+	printf("\nFrustum culling: %d spheres, %d visible, %.3f ms SIMD vs %.3f ms scalar, %d disagree",
+		sphereCount,
+		culler.GetVisibleCount(),
+		simdTime.count(),
+		scalarTime.count(),
+		wrong);
+
+	//A view that sees all or nothing would agree with the scalar test anyway
+	if (culler.GetVisibleCount() == 0 || culler.GetVisibleCount() == sphereCount)
+		printf("\nFrustum culling FAILED: the view should see some of the spheres but not all");
 }
 
-void Game::CheckForCollisions(vector<Entity*> l1, vector<Entity*> l2)
+// --------------------------------------------------------
+// Builds a made up field of ships in front of the camera,
+// occludes it with the nearest ones, and checks the result
+// against testing every pixel against every occluder
+// --------------------------------------------------------
+void Game::BenchmarkOcclusionCulling()
 {
-	for (Entity* e1 : l1) {
-		if (e1->IsActive()) {
-			for (Entity* e2 : l2) {
-				if (e2->IsActive()) {
-					float distX = e1->GetPosition().x - e2->GetPosition().x;
-					float distY = e1->GetPosition().y - e2->GetPosition().y;
-					float distZ = e1->GetPosition().z - e2->GetPosition().z;
-
-					float distV = pow(distX, 2) + pow(distY, 2) + pow(distZ, 2);
-					if (distV < pow((e1->GetRadius() + e2->GetRadius()), 2)) {
-						e1->Collides();
-						e2->Collides();
-						score++;
-					}
-				}
+	const int sphereCount = 20000;
+	const int occluderCount = 64;
+
+	//Same view as BenchmarkFrustumCulling, everything is placed in front of it
+	XMFLOAT3 eye = camera->GetCamPosition();
+	camera->LookTo(eye, XMFLOAT3(0.0f, 0.0f, 1.0f));
+	XMFLOAT4 planes[6];
+	camera->GetFrustumPlanes(planes);
+
+	Random random(worldSeed);
+	FrustumCuller culler(jobSystem);
+	for (int i = 0; i < sphereCount; i++)
+	{
+		XMFLOAT3 center(eye.x + random.Range(-20.0f, 20.0f), eye.y + random.Range(-10.0f, 10.0f), eye.z + random.Range(2.0f, 95.0f));
+		culler.Add(center, random.Range(0.1f, 2.0f));
+	}
+	culler.Cull(planes);
+	int inView = culler.GetVisibleCount();
+
+	//Occluders closer in, like the first ships of a wave
+	OcclusionCuller occlusion(jobSystem);
+	occlusion.Begin(camera->GetView(), camera->GetProj());
+	for (int i = 0; i < occluderCount; i++)
+	{
+		XMFLOAT3 center(eye.x + random.Range(-6.0f, 6.0f), eye.y + random.Range(-3.0f, 3.0f), eye.z + random.Range(3.0f, 15.0f));
+		occlusion.AddOccluder(center, random.Range(0.5f, 1.5f));
+	}
+
+	occlusion.Rasterize();
+	occlusion.Cull(&culler);
+
+	printf("\nOcclusion culling: %d of %d spheres hidden by %d occluders in %.3f ms, %d disagree with brute force",
+		occlusion.GetHiddenCount(),
+		inView,
+		occlusion.GetOccluderCount(),
+		occlusion.GetTime(),
+		occlusion.VerifyAgainstBruteForce(&culler));
+
+	//With no occluders in front of the near plane nothing is hidden, and
+	//agreeing with brute force means nothing
+	if (occlusion.GetOccluderCount() == 0 || occlusion.GetHiddenCount() == 0)
+		printf("\nOcclusion culling FAILED: expected occluders in view and some spheres hidden behind them");
+}
+
+// --------------------------------------------------------
+// Runs the post processing chain on the CPU over a made up
+// frame (dim noise with bright spots, like lasers and engines
+// on a dark sky), then cheaper versions of it, and prints how
+// long each took and how far it is from the full one
+// --------------------------------------------------------
+void Game::BenchmarkPostProcessing()
+{
+	Random random(worldSeed);
+	FloatImage scene;
+	scene.Width = width;
+	scene.Height = height;
+	scene.Pixels.resize(width * height * 4);
+	random.FillFloats(&scene.Pixels[0], (int)scene.Pixels.size(), 0.0f, 0.4f);
+	for (int i = 0; i < 200; i++)
+	{
+		int cx = (int)random.NextInt(width);
+		int cy = (int)random.NextInt(height);
+		int r = 1 + (int)random.NextInt(6);
+		for (int y = cy - r; y <= cy + r; y++)
+		{
+			for (int x = cx - r; x <= cx + r; x++)
+			{
+				if (x < 0 || y < 0 || x >= (int)width || y >= (int)height)
+					continue;
+				float* p = &scene.Pixels[(y * width + x) * 4];
+				p[0] = p[1] = p[2] = 1.0f;
 			}
 		}
 	}
+
+	SoftwarePostProcess software(jobSystem);
+	SoftwarePostProcess::Settings settings;
+	settings.ClipValue = clipValue;
+	FloatImage reference;
+	software.Run(scene, reference, settings);
+	printf("\nCPU post processing: %dx%d in %.3f ms", width, height, software.GetTime());
+
+	int taps[3] = { 15, 9, 5 };
+	int downsample[3] = { 1, 2, 4 };
+	FloatImage result;
+	for (int t = 0; t < 3; t++)
+	{
+		for (int d = 0; d < 3; d++)
+		{
+			if (t == 0 && d == 0)
+				continue;
+
+			SoftwarePostProcess::Settings cheaper = settings;
+			cheaper.BlurTaps = taps[t];
+			cheaper.BloomDownsample = downsample[d];
+			software.Run(scene, result, cheaper);
+
+			float maxError;
+			float rms = SoftwarePostProcess::Compare(reference, result, &maxError);
+			printf("\n  %d taps, 1/%d bloom: %.3f ms, rms error %.4f, max %.4f",
+				taps[t], downsample[d], software.GetTime(), rms, maxError);
+		}
+	}
 }
 
+// --------------------------------------------------------
+// Prints the zones of the last profiled frame as a tree, and
+// roughly how much of the frame the zones themselves took
+// --------------------------------------------------------
+void Game::PrintProfile()
+{
+	vector<ProfileNode> nodes;
+	Profiler::GetLastFrame(nodes);
+	if (nodes.empty())
+		return;
+
+	double frameTime = Profiler::GetLastFrameTime();
+	printf("\nLast frame: %.3f ms", frameTime);
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		printf("\n  %*s%-*s %8.3f ms %8.3f ms self",
+			nodes[i].Depth * 2, "",
+			24 - nodes[i].Depth * 2, nodes[i].Name,
+			nodes[i].TotalMs,
+			nodes[i].SelfMs);
+		if (nodes[i].Count > 1)
+			printf(" x%d", nodes[i].Count);
+	}
+
+	int zones = Profiler::GetLastFrameZoneCount();
+	double overhead = zones * Profiler::GetZoneCost();
+	printf("\nProfiler overhead: %d zones, about %.4f ms (%.2f%% of the frame)",
+		zones,
+		overhead,
+		frameTime > 0.0 ? overhead / frameTime * 100.0 : 0.0);
+}
+#endif
+
 // --------------------------------------------------------
 // Clear the screen, redraw everything, present to the user
 // --------------------------------------------------------
 void Game::Draw(float deltaTime, float totalTime)
 {
-	// Background color (Cornflower Blue in this case) for clearing
-	const float color[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-	UINT stride = sizeof(Vertex);
-	UINT offset = 0;
-	ID3D11Buffer* nothing = 0;
+#if defined(DEBUG) || defined(_DEBUG)
+	HandleDebugKeys();
+#endif
 
-	//Set Target for base render
-	if (postProcessing)
-	{
-		ID3D11RenderTargetView* baseRTV = baseTarget->GetRTV();
-		context->OMSetRenderTargets(1, &baseRTV, depthStencilView);
-	}
-	else {
-		context->OMSetRenderTargets(1, &backBufferRTV, depthStencilView);
-	}
+	//Draw part way between the last two simulation steps, camera included
+	simulation->SetRenderBlend(GetInterpolation());
+	simulation->FollowPlayer(simulation->GetPlayer()->GetRenderPosition(), deltaTime, totalTime);
 
-	// Clear the render target and depth buffer (erases what's on the screen)
-	//  - Do this ONCE PER FRAME
-	//  - At the beginning of Draw (before drawing *anything*)
-	context->ClearRenderTargetView(backBufferRTV, color);
-	context->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f,	0);
+	//Decide which lights each entity gets this frame, where it's drawn rather
+	//than where the last step left it.  Once a frame however many steps ran
+	lightManager->CullLights(simulation->GetEntities());
 
-	//Draw everything
-	DrawScene(deltaTime, totalTime);
+	//Lights, camera and sun are shared by every draw, so they go up once
+	lightManager->UpdateLightBuffer(context);
+	frameConstants->Update(context, camera, lightManager->dirLight);
+	Material::ResetBinding();
+	Material::ResetBindCount();
 
-	// Turn off vertex and index buffers 
-	context->IASetVertexBuffers(0, 1, &nothing, &stride, &offset);
-	context->IASetIndexBuffer(0, DXGI_FORMAT_R32_UINT, 0);
+	//Describe the frame, then let the graph work out what runs and where
+	{
+		PROFILE_SCOPE("Frame graph setup");
+		BuildFrameGraph(deltaTime, totalTime);
+		frameGraph->Compile();
+		PrepPostProcessing();
+	}
 
-	//Postprocssing effects
-	DrawPostProcessing();
+	//Draw everything, then the postprocessing effects that are on
+	frameGraph->Execute();
 
 	//Turn off srvs to prevent DX errors
-	context->PSSetShaderResources(0, 16, nullSRVs);
+	stateCache->PSClearShaderResources();
 
 	//Draw ui
 	DrawScore();
 
+	//Constant buffer uploads and state changes for this frame are done
+	ISimpleShader::EndFrame();
+	stateCache->EndFrame();
+
 	// Present the back buffer to the user
 	//  - Puts the final frame we're drawing into the window so the user can see it
 	//  - Do this exactly ONCE PER FRAME (always at the very end of the frame)
+	PROFILE_SCOPE("Present");
 	swapChain->Present(0, 0);
 }
 
 void Game::DrawScene(float deltaTime, float totalTime)
 {
+	vector<Entity*> targets = simulation->GetTargetManager()->GetTargets();
+	vector<Entity*> bullets = simulation->GetFireManager()->GetBullets();
+	Player* player = simulation->GetPlayer();
+	int playerSphere;
+
+	{
+		PROFILE_SCOPE("Culling");
+
+		//Cull everything that's drawn as an entity in one go, where it's drawn.
+		//Spheres are added in the same order the visibility bits are read back below
+		XMFLOAT4 planes[6];
+		camera->GetFrustumPlanes(planes);
+		frustumCuller->Clear();
+		for (size_t i = 0; i < targets.size(); i++)
+			frustumCuller->Add(targets[i]->GetRenderPosition(), targets[i]->GetRadius());
+		for (size_t i = 0; i < bullets.size(); i++)
+			frustumCuller->Add(bullets[i]->GetRenderPosition(), bullets[i]->GetRadius());
+		playerSphere = frustumCuller->Add(player->GetRenderPosition(), player->GetRadius());
+		frustumCuller->Cull(planes);
+
+		//Then drop whatever is behind the biggest ships on screen
+		if (occlusionCulling)
+		{
+			occlusionCuller->Begin(camera->GetView(), camera->GetProj());
+			for (size_t i = 0; i < targets.size(); i++)
+			{
+				if (targets[i]->IsActive() && frustumCuller->IsVisible((int)i))
+					occlusionCuller->AddOccluder(targets[i]->GetRenderPosition(), targets[i]->GetRadius() * occluderCoreScale);
+			}
+			if (player->IsActive())
+				occlusionCuller->AddOccluder(player->GetRenderPosition(), player->GetRadius() * occluderCoreScale);
+			occlusionCuller->Rasterize();
+			occlusionCuller->Cull(frustumCuller);
+		}
+	}
 
-	//Draw all Targets
-	for (size_t i = 0; i < targetManager->GetTargets().size(); i++)
 	{
-		((Target*)targetManager->GetTargets()[i])->Draw(context, camera, lightManager);
+		PROFILE_SCOPE("Render queue");
+
+		//Queue up whatever is alive and in view
+		int sphere = 0;
+		renderQueue->Begin(camera);
+		for (size_t i = 0; i < targets.size(); i++, sphere++)
+		{
+			if (targets[i]->IsActive() && frustumCuller->IsVisible(sphere))
+				renderQueue->Add(targets[i], RENDER_PASS_OPAQUE);
+		}
+
+		//Bullets are drawn inside out
+		for (size_t i = 0; i < bullets.size(); i++, sphere++)
+		{
+			if (bullets[i]->IsActive() && frustumCuller->IsVisible(sphere))
+				renderQueue->Add(bullets[i], RENDER_PASS_OPAQUE, skybox->rasterState);
+		}
+
+		if (player->IsActive() && frustumCuller->IsVisible(playerSphere))
+			renderQueue->Add(player, RENDER_PASS_OPAQUE);
+
+		//Reticule is transparent so has to go after skybox
+		renderQueue->Add(simulation->GetReticule(), RENDER_PASS_TRANSPARENT, 0, reticuleBlendState);
+		renderQueue->Sort();
 	}
 
-	//Draw Bullets
-	context->RSSetState(skybox->rasterState);
-	for (size_t i = 0; i < fireManager->GetBullets().size(); i++)
 	{
-		((Bullet*)fireManager->GetBullets()[i])->Draw(context, camera, lightManager);
+		PROFILE_SCOPE("Opaque");
+		renderQueue->Submit(context, stateCache, lightManager, RENDER_PASS_OPAQUE);
 	}
-	context->RSSetState(0);
 
-	//Draw Player
-	player->Draw(context, camera, lightManager);
+	//Draw Skybox after everything opaque
+	{
+		PROFILE_SCOPE("Skybox");
+		DrawSkybox(skybox);
+		Material::ResetBinding();
+	}
 
-	//Draw Skybox next to last
-	DrawSkybox(skybox);
+	{
+		PROFILE_SCOPE("Transparent");
+		renderQueue->Submit(context, stateCache, lightManager, RENDER_PASS_TRANSPARENT);
+		ClearBlending();
+	}
 
-	//Draw reticule (transparent so has to go after skybox
-	context->OMSetBlendState(reticule->GetBlend(), 0, 0xffffffff);
-	reticule->Draw(context, camera, lightManager);
-	ClearBlending();
+	PROFILE_SCOPE("Particles");
 
 	//Draw Particles! This is a three step process, so here's what you do:
 	//Step 1: Set up your first blend state, like additive blending
 	SetAdditiveBlending();
 	
 
-	//Step 2: Draw the emitters using that blend state
-	leftThruster->Draw(context, camera);
-	rightThruster->Draw(context, camera);
-	for (size_t i = 0; i < targetManager->GetTargets().size(); i++)
-	{
-		((Target*)targetManager->GetTargets()[i])->DrawEmitter(context, camera);
-	}
+	//Step 2: Draw the emitters using that blend state (every emitter lives in
+	//the particle system's shared buffer, so this is one draw per texture)
+	particleUploadBytes = particleRenderer->Upload(context, camera, simulation->GetParticleSystem());
+	particleRenderer->Draw(context, PARTICLE_BLEND_ADDITIVE);
 
 	//Repeat steps 1 & 2 for other blending states
+	SetAlphaBlending();
+	particleRenderer->Draw(context, PARTICLE_BLEND_ALPHA);
 
 	//Step 3: Reset to default states for next frame
 	ClearBlending();
@@ -674,16 +1208,23 @@ void Game::DrawScene(float deltaTime, float totalTime)
 void Game::SetAdditiveBlending()
 {
 	float blend[4] = { 1,1,1,1 };
-	context->OMSetBlendState(additiveBlendState, blend, 0xffffffff);  // Additive blending
-	context->OMSetDepthStencilState(particleDepthState, 0);			// No depth WRITING
+	stateCache->OMSetBlendState(additiveBlendState, blend, 0xffffffff);  // Additive blending
+	stateCache->OMSetDepthStencilState(particleDepthState, 0);			// No depth WRITING
+}
+
+void Game::SetAlphaBlending()
+{
+	float blend[4] = { 1,1,1,1 };
+	stateCache->OMSetBlendState(alphaBlendState, blend, 0xffffffff);  // Premultiplied alpha blending
+	stateCache->OMSetDepthStencilState(particleDepthState, 0);			// No depth WRITING
 }
 
 void Game::ClearBlending()
 {
 	// Reset to default states for next frame
 	float blend[4] = { 1,1,1,1 };
-	context->OMSetBlendState(0, blend, 0xffffffff);
-	context->OMSetDepthStencilState(0, 0);
+	stateCache->OMSetBlendState(0, blend, 0xffffffff);
+	stateCache->OMSetDepthStencilState(0, 0);
 }
 
 void Game::DrawSkybox(Skybox* sky)
@@ -697,10 +1238,7 @@ void Game::DrawSkybox(Skybox* sky)
 	vShader->SetShader();
 	pShader->SetShader();
 
-	//Set Shader variables
-	vShader->SetMatrix4x4("view", camera->GetView());
-	vShader->SetMatrix4x4("projection", camera->GetProj());
-	
+	//Set Shader variables (view and projection are in the per frame buffer)
 	pShader->SetShaderResourceView("skyboxTexture", material->GetTexture());
 	pShader->SetSamplerState("basicSampler", material->GetSampler());
 
@@ -715,121 +1253,196 @@ void Game::DrawSkybox(Skybox* sky)
 	context->IASetIndexBuffer(mesh->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
 
 	//Set rasterizer and depth states
-	context->RSSetState(sky->rasterState);
-	context->OMSetDepthStencilState(sky->depthState, 0);
+	stateCache->RSSetState(sky->rasterState);
+	stateCache->OMSetDepthStencilState(sky->depthState, 0);
 
 	//DRAW!
 	context->DrawIndexed(mesh->GetIndexCount(), 0, 0);
 
 	//Reset states
-	context->RSSetState(0);
-	context->OMSetDepthStencilState(0, 0);
+	stateCache->RSSetState(0);
+	stateCache->OMSetDepthStencilState(0, 0);
 }
 
-void Game::DrawPostProcessing()
+// --------------------------------------------------------
+// Declares this frame's passes.  The scene goes straight to the
+// back buffer when no effect is on, otherwise to a target the
+// effects read.  Passes for effects that are off are never
+// added, so they cost neither time nor memory
+// --------------------------------------------------------
+void Game::BuildFrameGraph(float deltaTime, float totalTime)
 {
-	const float color[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-
-	//Begin postprocessing
-	SimpleVertexShader* ppVS = vertexShaders.find("PPVS")->second; //This should work for all draws to textures
-	ppVS->SetShader();
-
-	//Extract bright areas to bloom target
-	ID3D11RenderTargetView* bloomRTV = bloomTarget->GetRTV();
-	context->OMSetRenderTargets(1, &bloomRTV, 0);
-	context->ClearRenderTargetView(bloomRTV, color);
-
-	SimplePixelShader* bloomPS = pixelShaders.find("bloomPS")->second;
-	bloomPS->SetShader();
-
-	bloomPS->SetFloat("clipValue", clipValue);
-	bloomPS->CopyAllBufferData();
-
-	bloomPS->SetShaderResourceView("BasePixels", baseTarget->GetSRV());
-	bloomPS->SetSamplerState("Sampler", ppSampler);
-
-	context->Draw(3, 0);
+	frameGraph->Reset();
+	backBufferTexture = frameGraph->ImportTexture("BackBuffer");
 
-	//Blur horizontally to bloomTarget2
-	ID3D11RenderTargetView* bloomRTV2 = bloomTarget2->GetRTV();
-	context->OMSetRenderTargets(1, &bloomRTV2, 0);
-	context->ClearRenderTargetView(bloomRTV2, color);
+	FrameGraphTextureDesc fullScreen = {};
+	fullScreen.Width = width;
+	fullScreen.Height = height;
+	fullScreen.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	fullScreen.BytesPerPixel = 4;
 
-	SimplePixelShader* blurPS = pixelShaders.find("blurPS")->second;
-	blurPS->SetShader();
+	bool doBloom = postProcessing && bloom;
+	bool doRadial = postProcessing && radialBlur;
+	int scene = doBloom || doRadial ? frameGraph->CreateTexture("Scene", fullScreen) : backBufferTexture;
 
-	blurPS->SetFloat2("passDir", horizontDir);
-	blurPS->SetFloat("pixelWidth", 1.0f / width);
-	blurPS->SetFloat("pixelHeight", 1.0f / height);
-	blurPS->CopyAllBufferData();
-
-	blurPS->SetShaderResourceView("BasePixels", bloomTarget->GetSRV());
-	blurPS->SetSamplerState("Sampler", ppSampler);
-
-	context->Draw(3, 0);
-
-	//Turn off srvs to prevent DX errors
-	context->PSSetShaderResources(0, 16, nullSRVs);
-
-	//Blur vertically back to bloomTarget
-	context->OMSetRenderTargets(1, &bloomRTV, 0);
-	context->ClearRenderTargetView(bloomRTV, color);
-
-	blurPS->SetFloat2("passDir", verticalDir);
-	blurPS->CopyAllBufferData();
-
-	blurPS->SetShaderResourceView("BasePixels", bloomTarget2->GetSRV());
-	blurPS->SetSamplerState("Sampler", ppSampler);
-
-	context->Draw(3, 0);
-
-	//Blur edges of screen to raidalTarget
-	ID3D11RenderTargetView* radialRTV = radialTarget->GetRTV();
-	context->OMSetRenderTargets(1, &radialRTV, depthStencilView);
-	context->ClearRenderTargetView(radialRTV, color);
-	
-	SimplePixelShader* radialPS = pixelShaders.find("radialPS")->second;
-	radialPS->SetShader();
-	radialPS->SetSamplerState("Sampler", ppSampler);
-	radialPS->SetShaderResourceView("BasePixels", baseTarget->GetSRV());
+	int scenePass = frameGraph->AddPass("Scene", [=]()
+	{
+		const float color[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		ID3D11RenderTargetView* rtv = GetPassRTV(scene);
+		stateCache->OMSetRenderTargets(1, &rtv, depthStencilView);
+		context->ClearRenderTargetView(rtv, color);
+		context->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+		DrawScene(deltaTime, totalTime);
+
+		// Turn off vertex and index buffers 
+		UINT stride = sizeof(Vertex);
+		UINT offset = 0;
+		ID3D11Buffer* nothing = 0;
+		context->IASetVertexBuffers(0, 1, &nothing, &stride, &offset);
+		context->IASetIndexBuffer(0, DXGI_FORMAT_R32_UINT, 0);
+	});
+	frameGraph->Write(scenePass, scene);
+
+	if (scene == backBufferTexture)
+		return;
+
+	//Extract bright areas, then blur them horizontally and vertically
+	int bloomResult = -1;
+	if (doBloom)
+	{
+		int bright = frameGraph->CreateTexture("BloomBright", fullScreen);
+		int blurred = frameGraph->CreateTexture("BloomBlurH", fullScreen);
+		bloomResult = frameGraph->CreateTexture("BloomBlurV", fullScreen);
+
+		int extract = frameGraph->AddPass("BloomExtract", [=]()
+		{
+			BeginPostPass(bright, false);
+			SimplePixelShader* bloomPS = pixelShaders.find("bloomPS")->second;
+			bloomPS->SetShader();
+			bloomPS->SetFloat("clipValue", clipValue);
+			bloomPS->CopyAllBufferData();
+			bloomPS->SetShaderResourceView("BasePixels", GetPassSRV(scene));
+			bloomPS->SetSamplerState("Sampler", ppSampler);
+			context->Draw(3, 0);
+		});
+		frameGraph->Read(extract, scene);
+		frameGraph->Write(extract, bright);
+
+		int blurSources[2] = { bright, blurred };
+		int blurTargets[2] = { blurred, bloomResult };
+		for (int i = 0; i < 2; i++)
+		{
+			int source = blurSources[i];
+			int target = blurTargets[i];
+			float* dir = i == 0 ? horizontDir : verticalDir;
+			int blur = frameGraph->AddPass(i == 0 ? "BloomBlurH" : "BloomBlurV", [=]()
+			{
+				BeginPostPass(target, false);
+				SimplePixelShader* blurPS = pixelShaders.find("blurPS")->second;
+				blurPS->SetShader();
+
+				BlurPS::Data blurData = {};
+				blurData.passDir = XMFLOAT2(dir[0], dir[1]);
+				blurData.pixelWidth = 1.0f / width;
+				blurData.pixelHeight = 1.0f / height;
+				blurPS->SetBufferData("Data", &blurData, sizeof(blurData));
+				blurPS->CopyAllBufferData();
+
+				blurPS->SetShaderResourceView("BasePixels", GetPassSRV(source));
+				blurPS->SetSamplerState("Sampler", ppSampler);
+				context->Draw(3, 0);
+			});
+			frameGraph->Read(blur, source);
+			frameGraph->Write(blur, target);
+		}
+	}
 
-	radialPS->CopyAllBufferData();
+	//Blur edges of screen
+	int radial = -1;
+	if (doRadial)
+	{
+		radial = frameGraph->CreateTexture("Radial", fullScreen);
+		int radialPass = frameGraph->AddPass("RadialBlur", [=]()
+		{
+			BeginPostPass(radial, true);
+			SimplePixelShader* radialPS = pixelShaders.find("radialPS")->second;
+			radialPS->SetShader();
+			radialPS->SetSamplerState("Sampler", ppSampler);
+			radialPS->SetShaderResourceView("BasePixels", GetPassSRV(scene));
+			radialPS->CopyAllBufferData();
+			context->Draw(3, 0);
+		});
+		frameGraph->Read(radialPass, scene);
+		frameGraph->Write(radialPass, radial);
+	}
 
-	context->Draw(3, 0);
+	//Combine into the back buffer.  Without radial blur the scene itself is
+	//the base, and without bloom there's nothing to add on top
+	int base = doRadial ? radial : scene;
+	int combine = frameGraph->AddPass("Combine", [=]()
+	{
+		BeginPostPass(backBufferTexture, true);
+		context->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+		SimplePixelShader* ppPS = pixelShaders.find("PPPS")->second;
+		ppPS->SetShader();
+		ppPS->SetShaderResourceView("BasePixels", GetPassSRV(scene));
+		ppPS->SetShaderResourceView("LightBloom", doBloom ? GetPassSRV(bloomResult) : 0);
+		ppPS->SetShaderResourceView("RadialBlur", GetPassSRV(base));
+		ppPS->SetSamplerState("Sampler", ppSampler);
+		context->Draw(3, 0);
+	});
+	frameGraph->Read(combine, scene);
+	frameGraph->Read(combine, base);
+	if (doBloom)
+		frameGraph->Read(combine, bloomResult);
+	frameGraph->Write(combine, backBufferTexture);
+}
 
-	//End Postprocessing
+// --------------------------------------------------------
+// Unbinds whatever the last pass read, then sets and clears a
+// full screen pass's target
+// --------------------------------------------------------
+void Game::BeginPostPass(int target, bool depth)
+{
+	const float color[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	stateCache->PSClearShaderResources();
 
-	//Set OMRTV to back buffer for final draw
-	context->OMSetRenderTargets(1, &backBufferRTV, depthStencilView);
-	context->ClearRenderTargetView(backBufferRTV, color);
-	context->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
+	ID3D11RenderTargetView* rtv = GetPassRTV(target);
+	stateCache->OMSetRenderTargets(1, &rtv, depth ? depthStencilView : 0);
+	context->ClearRenderTargetView(rtv, color);
 
-	//Combine postprocessing targets
-	SimplePixelShader* ppPS = pixelShaders.find("PPPS")->second;
+	//This should work for all draws to textures
+	vertexShaders.find("PPVS")->second->SetShader();
+}
 
-	ppPS->SetShader();
-	ppPS->SetShaderResourceView("BasePixels", baseTarget->GetSRV());
-	ppPS->SetShaderResourceView("LightBloom", bloomTarget->GetSRV());
-	ppPS->SetShaderResourceView("RadialBlur", radialTarget->GetSRV());
-	ppPS->SetSamplerState("Sampler", ppSampler);
+ID3D11RenderTargetView* Game::GetPassRTV(int texture)
+{
+	if (texture == backBufferTexture)
+		return backBufferRTV;
+	return postTargets[frameGraph->GetPhysicalTexture(texture)]->GetRTV();
+}
 
-	//Draw to back buffer
-	context->Draw(3, 0);
+ID3D11ShaderResourceView* Game::GetPassSRV(int texture)
+{
+	return postTargets[frameGraph->GetPhysicalTexture(texture)]->GetSRV();
 }
 
 void Game::DrawScore()
 {
 	//Draw text
-	wstring scoreText = L"SCORE: " + to_wstring(score);
+	wstring scoreText = L"SCORE: " + to_wstring(simulation->GetScore());
 	spriteBatch->Begin();
 	spriteFont->DrawString(spriteBatch, scoreText.c_str(), XMFLOAT2(10.0f, (float)height - 50.0f));
 	spriteBatch->End();
 
-	// Reset any and all render states that sprite batch has changed
+	// Reset any and all render states that sprite batch has changed,
+	// none of which went through the state cache
+	stateCache->Invalidate();
 	float blendFactors[4] = { 1,1,1,1 };
-	context->OMSetBlendState(0, blendFactors, 0xFFFFFFFF);
-	context->RSSetState(0);
-	context->OMSetDepthStencilState(0, 0);
+	stateCache->OMSetBlendState(0, blendFactors, 0xFFFFFFFF);
+	stateCache->RSSetState(0);
+	stateCache->OMSetDepthStencilState(0, 0);
 }
 
 #pragma region Mouse Input
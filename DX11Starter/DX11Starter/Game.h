@@ -17,6 +17,19 @@
 #include "Skybox.h"
 #include "Reticule.h"
 #include "ParticleEmitter.h"
+#include "ParticleSystem.h"
+#include "ParticleRenderer.h"
+#include "EntityRenderer.h"
+#include "JobSystem.h"
+#include "FrameConstants.h"
+#include "StateCache.h"
+#include "D3DStateTarget.h"
+#include "RenderQueue.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "FrameGraph.h"
+#include "SoftwarePostProcess.h"
+#include "Simulation.h"
 #include <vector>
 #include "SpriteBatch.h"
 #include "SpriteFont.h"
@@ -36,14 +49,25 @@ public:
 	void Init();
 	void OnResize();
 	void Update(float deltaTime, float totalTime);
-	void CheckForCollisions(vector<Entity*> l1, vector<Entity*> l2);
 	void Draw(float deltaTime, float totalTime);
+
 	void DrawSkybox(Skybox* sky);
 	void DrawScene(float deltaTime, float totalTime);
 	void DrawScore();
 	void SetAdditiveBlending();
+	void SetAlphaBlending();
+	void HandleDebugKeys();
+	void TestLightClusters();
+	void BenchmarkShaderBinding();
+	void BenchmarkFrustumCulling();
+	void BenchmarkOcclusionCulling();
+	void BenchmarkPostProcessing();
+	void PrintProfile();
 	void ClearBlending();
-	void DrawPostProcessing();
+	void BuildFrameGraph(float deltaTime, float totalTime);
+	void BeginPostPass(int target, bool depth);
+	ID3D11RenderTargetView* GetPassRTV(int texture);
+	ID3D11ShaderResourceView* GetPassSRV(int texture);
 
 	// Overridden mouse input helper methods
 	void OnMouseDown (WPARAM buttonState, int x, int y);
@@ -56,14 +80,11 @@ private:
 	void LoadResources();
 	void SetupGameWorld();
 	void PrepPostProcessing();
+	GameInput ReadInput();
 
-	//Game Objects
-	vector<Entity*> entities;
-	FireManager* fireManager;
-	TargetManager* targetManager;
+	//Game Objects, the simulation owns everything that moves
+	Simulation* simulation;
 	LightManager* lightManager;
-	Player* player;
-	Reticule* reticule;
 	Skybox* skybox;
 
 	//Resource Collections
@@ -78,29 +99,68 @@ private:
 	//Camera object
 	Camera* camera;
 
+	//View, projection, camera and sun, shared by every shader
+	FrameConstants* frameConstants;
+
+	//Drops binds that wouldn't change anything
+	D3DStateTarget* stateTarget;
+	StateCache* stateCache;
+
+	//Worker threads shared by the frame's systems
+	JobSystem* jobSystem;
+
+	//Meshes and materials for the handles entities carry
+	EntityRenderer* entityRenderer;
+	ID3D11BlendState* reticuleBlendState;
+
+	//Entities are drawn through this, sorted by state and depth
+	RenderQueue* renderQueue;
+
+	//Which entities are in view this frame
+	FrustumCuller* frustumCuller;
+
+	//Hides entities behind nearby ships.  Ships are far from round, so only
+	//the middle of their bounding sphere is counted as solid
+	OcclusionCuller* occlusionCuller;
+	const float occluderCoreScale = 0.4f;
+	bool occlusionCulling = true;
+
 	// Particle stuff
+	ParticleRenderer* particleRenderer;
+	const unsigned long long worldSeed = Simulation::defaultSeed;
+	int particleUploadBytes = 0;
 	ID3D11ShaderResourceView* fire = 0;
 	ID3D11DepthStencilState* particleDepthState;
 	ID3D11BlendState* additiveBlendState;
-	ParticleEmitter* leftThruster;
-	ParticleEmitter* rightThruster;
-	ParticleEmitter* smoke;
-	ParticleEmitter* thruster;
+	ID3D11BlendState* alphaBlendState;
 
-	//Postprocessing data
+	//Postprocessing data.  The frame graph decides which passes run and how
+	//many targets they need, postTargets has one per slot it handed out
 	bool postProcessing = true;
-	DXRenderTarget* baseTarget; //Render scene to here (pre-postprocessing)
-	DXRenderTarget* bloomTarget; //Render light bloom effects to here
-	DXRenderTarget* bloomTarget2;
-	DXRenderTarget* radialTarget;
+	bool bloom = true;
+	bool radialBlur = true;
+	FrameGraph* frameGraph;
+	int backBufferTexture;
+	vector<DXRenderTarget*> postTargets;
+	vector<FrameGraphTextureDesc> postTargetDescs;
 	float clipValue = 0.72f;
 	float verticalDir[2] = { 0.0f, 1.0f };
 	float horizontDir[2] = { 1.0f, 0.0f };
 
-	ID3D11ShaderResourceView* nullSRVs[16] = {};
+	//Debug key for cycling the worker thread count
+	bool threadKeyDown = false;
+	bool sortKeyDown = false;
+	bool clusterKeyDown = false;
+	bool cacheKeyDown = false;
+	bool instanceKeyDown = false;
+	bool occlusionKeyDown = false;
+	bool bloomKeyDown = false;
+	bool radialKeyDown = false;
+	bool rateKeyDown = false;
+	bool profileKeyDown = false;
+	bool benchmarkKeyDown = false;
 
 	//UI stuff
-	int score = 0;
 	SpriteBatch* spriteBatch;
 	SpriteFont* spriteFont;
 
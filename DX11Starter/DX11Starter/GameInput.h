@@ -0,0 +1,14 @@
+#pragma once
+
+// --------------------------------------------------------
+// What the player is asking for this step.  Filled from the
+// keyboard by the game, or from an InputScript when running
+// without anyone playing.
+// --------------------------------------------------------
+struct GameInput
+{
+	//-1, 0 or 1.  Positive x is right, positive y pulls back (down the screen)
+	float MoveX;
+	float MoveY;
+	bool Fire;
+};
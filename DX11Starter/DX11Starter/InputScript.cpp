@@ -0,0 +1,34 @@
+#include "InputScript.h"
+
+InputScript::InputScript(unsigned long long seed) : random(seed)
+{
+	current.MoveX = 0.0f;
+	current.MoveY = 0.0f;
+	current.Fire = false;
+	moveTimer = 0.0f;
+	fireTimer = 0.0f;
+}
+
+InputScript::~InputScript()
+{
+}
+
+GameInput InputScript::Next(float deltaTime)
+{
+	moveTimer -= deltaTime;
+	if (moveTimer <= 0.0f)
+	{
+		current.MoveX = (float)random.NextInt(3) - 1.0f;
+		current.MoveY = (float)random.NextInt(3) - 1.0f;
+		moveTimer = random.Range(0.25f, 1.5f);
+	}
+
+	fireTimer -= deltaTime;
+	if (fireTimer <= 0.0f)
+	{
+		current.Fire = !current.Fire;
+		fireTimer = current.Fire ? random.Range(0.5f, 2.0f) : random.Range(0.1f, 1.0f);
+	}
+
+	return current;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "GameInput.h"
+#include "Random.h"
+
+// --------------------------------------------------------
+// Made up but repeatable play for benchmarking.  Holds a
+// direction for a random while, then picks another, and
+// fires in bursts.  The same seed always plays the same way.
+// --------------------------------------------------------
+class InputScript
+{
+public:
+	InputScript(unsigned long long seed);
+	~InputScript();
+
+	GameInput Next(float deltaTime);
+
+private:
+	Random random;
+	GameInput current;
+	float moveTimer;
+	float fireTimer;
+};
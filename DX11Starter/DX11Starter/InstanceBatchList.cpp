@@ -0,0 +1,55 @@
+#include "InstanceBatchList.h"
+
+InstanceBatchList::InstanceBatchList()
+{
+	batchEnded = true;
+}
+
+InstanceBatchList::~InstanceBatchList()
+{
+}
+
+void InstanceBatchList::Begin()
+{
+	batches.clear();
+	entities.clear();
+	batchEnded = true;
+}
+
+int InstanceBatchList::Add(Entity* entity)
+{
+	bool join = !batchEnded && !batches.empty() &&
+		batches.back().mesh == entity->GetMesh() &&
+		batches.back().material == entity->GetMaterial();
+
+	if (!join)
+	{
+		InstanceBatch batch;
+		batch.mesh = entity->GetMesh();
+		batch.material = entity->GetMaterial();
+		batch.firstInstance = (int)entities.size();
+		batch.instanceCount = 0;
+		batches.push_back(batch);
+		batchEnded = false;
+	}
+
+	entities.push_back(entity);
+	batches.back().instanceCount++;
+
+	return (int)batches.size() - 1;
+}
+
+void InstanceBatchList::EndBatch()
+{
+	batchEnded = true;
+}
+
+const vector<InstanceBatch>& InstanceBatchList::GetBatches()
+{
+	return batches;
+}
+
+const vector<Entity*>& InstanceBatchList::GetEntities()
+{
+	return entities;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include "Entity.h"
+
+using namespace std;
+
+//A run of instances drawn with one call
+struct InstanceBatch
+{
+	int mesh;
+	int material;
+	int firstInstance;
+	int instanceCount;
+};
+
+// --------------------------------------------------------
+// The device-free half of instancing: groups entities added
+// one after another that share a mesh and material into
+// batches, and keeps the entities in instance order.  The
+// InstanceBatcher writes and draws the instances.
+// --------------------------------------------------------
+class InstanceBatchList
+{
+public:
+	InstanceBatchList();
+	~InstanceBatchList();
+
+	void Begin();
+
+	//Adds an entity to the last batch if it has the same mesh and material,
+	//otherwise starts a new one.  Returns the batch it went in
+	int Add(Entity* entity);
+
+	//The next Add starts a new batch whatever it is
+	void EndBatch();
+
+	const vector<InstanceBatch>& GetBatches();
+
+	//Every entity added, in instance order, so a batch's entities are
+	//firstInstance to firstInstance + instanceCount
+	const vector<Entity*>& GetEntities();
+
+private:
+	vector<InstanceBatch> batches;
+	vector<Entity*> entities;
+	bool batchEnded;
+};
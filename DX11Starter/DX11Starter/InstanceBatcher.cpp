@@ -0,0 +1,119 @@
+#include "InstanceBatcher.h"
+#include <string.h>
+
+InstanceBatcher::InstanceBatcher(ID3D11Device* device, EntityRenderer* entityRenderer)
+{
+	this->device = device;
+	this->entityRenderer = entityRenderer;
+	instanceBuffer = nullptr;
+	capacity = 0;
+	uploadBytes = 0;
+	CreateInstanceBuffer(64);
+}
+
+InstanceBatcher::~InstanceBatcher()
+{
+	instanceBuffer->Release();
+}
+
+void InstanceBatcher::Begin()
+{
+	batchList.Begin();
+	instances.clear();
+}
+
+int InstanceBatcher::Add(Entity* entity, LightManager* lightManager)
+{
+	//Instances go in the same order as the list's entities
+	InstanceData instance;
+	entityRenderer->WriteInstance(entity, instance, lightManager);
+	instances.push_back(instance);
+
+	return batchList.Add(entity);
+}
+
+void InstanceBatcher::EndBatch()
+{
+	batchList.EndBatch();
+}
+
+const vector<InstanceBatch>& InstanceBatcher::GetBatches()
+{
+	return batchList.GetBatches();
+}
+
+const vector<InstanceData>& InstanceBatcher::GetInstances()
+{
+	return instances;
+}
+
+void InstanceBatcher::Upload(ID3D11DeviceContext* context)
+{
+	uploadBytes = 0;
+	if (instances.empty())
+		return;
+
+	if ((int)instances.size() > capacity)
+	{
+		int size = capacity;
+		while (size < (int)instances.size())
+			size *= 2;
+		CreateInstanceBuffer(size);
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	context->Map(instanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	memcpy(mapped.pData, &instances[0], sizeof(InstanceData) * instances.size());
+	context->Unmap(instanceBuffer, 0);
+
+	uploadBytes = sizeof(InstanceData) * (int)instances.size();
+}
+
+void InstanceBatcher::Draw(ID3D11DeviceContext* context, int batch, LightManager* lightManager)
+{
+	const InstanceBatch& b = batchList.GetBatches()[batch];
+	Material* material = entityRenderer->GetMaterial(b.material)->GetInstanced();
+	Mesh* mesh = entityRenderer->GetMesh(b.mesh);
+
+	//Lights come from the shared buffers, so only need setting with the material
+	if (material->Bind())
+	{
+		SimplePixelShader* pShader = material->GetPixelShader();
+		const MaterialHandles& h = material->GetHandles();
+		pShader->SetShaderResourceView(h.Lights, lightManager->GetLightSRV());
+		pShader->SetShaderResourceView(h.LightIndexList, lightManager->GetLightIndexSRV());
+	}
+
+	//Mesh in slot 0, instances in slot 1 (where SimpleShader puts *_PER_INSTANCE inputs)
+	ID3D11Buffer* buffers[2] = { *mesh->GetVertexBuffer(), instanceBuffer };
+	UINT strides[2] = { sizeof(Vertex), sizeof(InstanceData) };
+	UINT offsets[2] = { 0, 0 };
+	context->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+	context->IASetIndexBuffer(mesh->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
+
+	context->DrawIndexedInstanced(
+		mesh->GetIndexCount(),
+		b.instanceCount,
+		0,
+		0,
+		b.firstInstance);
+}
+
+int InstanceBatcher::GetUploadBytes()
+{
+	return uploadBytes;
+}
+
+void InstanceBatcher::CreateInstanceBuffer(int capacity)
+{
+	if (instanceBuffer) instanceBuffer->Release();
+	this->capacity = capacity;
+
+	// DYNAMIC vertex buffer, rewritten every frame
+	D3D11_BUFFER_DESC desc = {};
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.ByteWidth = sizeof(InstanceData) * capacity;
+	device->CreateBuffer(&desc, 0, &instanceBuffer);
+}
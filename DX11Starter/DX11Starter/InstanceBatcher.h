@@ -0,0 +1,57 @@
+#pragma once
+
+#include <d3d11.h>
+#include <vector>
+#include "Entity.h"
+#include "EntityRenderer.h"
+#include "LightManager.h"
+#include "InstanceBatchList.h"
+
+using namespace std;
+
+// --------------------------------------------------------
+// Groups entities that share a mesh and material into batches
+// (with an InstanceBatchList, which doesn't need the device),
+// writes their world matrices and light lists into one instance
+// buffer a frame, and draws each batch with a single
+// DrawIndexedInstanced using the material's instanced shaders.
+// --------------------------------------------------------
+class InstanceBatcher
+{
+public:
+	InstanceBatcher(ID3D11Device* device, EntityRenderer* entityRenderer);
+	~InstanceBatcher();
+
+	void Begin();
+
+	//Adds an entity to the last batch if it has the same mesh and material,
+	//otherwise starts a new one.  Returns the batch it went in
+	int Add(Entity* entity, LightManager* lightManager);
+
+	//The next Add starts a new batch whatever it is, for when something
+	//between the two draws has to change
+	void EndBatch();
+
+	const vector<InstanceBatch>& GetBatches();
+	const vector<InstanceData>& GetInstances();
+
+	//Copies every instance to the GPU, growing the buffer if it has to
+	void Upload(ID3D11DeviceContext* context);
+
+	//Binds the batch's instanced material and draws all of it
+	void Draw(ID3D11DeviceContext* context, int batch, LightManager* lightManager);
+
+	int GetUploadBytes();
+
+private:
+	InstanceBatchList batchList;
+	vector<InstanceData> instances;
+
+	ID3D11Device* device;
+	EntityRenderer* entityRenderer;
+	ID3D11Buffer* instanceBuffer;
+	int capacity;
+	int uploadBytes;
+
+	void CreateInstanceBuffer(int capacity);
+};
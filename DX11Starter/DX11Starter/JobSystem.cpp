@@ -0,0 +1,130 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+JobSystem::JobSystem(unsigned int threadCount)
+{
+	quit = false;
+	batchJob = nullptr;
+	batchCount = 0;
+	batchGeneration = 0;
+	nextJob = 0;
+	activeWorkers = 0;
+
+	if (threadCount == 0) threadCount = GetHardwareThreadCount();
+	StartWorkers(threadCount - 1);
+}
+
+JobSystem::~JobSystem()
+{
+	StopWorkers();
+}
+
+unsigned int JobSystem::GetHardwareThreadCount()
+{
+	unsigned int cores = std::thread::hardware_concurrency();
+	return cores > 0 ? cores : 1;
+}
+
+unsigned int JobSystem::GetThreadCount()
+{
+	return (unsigned int)workers.size() + 1;
+}
+
+void JobSystem::SetThreadCount(unsigned int threadCount)
+{
+	if (threadCount == 0) threadCount = GetHardwareThreadCount();
+	if (threadCount == GetThreadCount()) return;
+
+	StopWorkers();
+	StartWorkers(threadCount - 1);
+}
+
+void JobSystem::ParallelFor(unsigned int jobCount, const std::function<void(unsigned int)>& job)
+{
+	if (jobCount == 0) return;
+
+	//Nothing to share the work with, so skip the hand-off entirely
+	if (workers.empty() || jobCount == 1)
+	{
+		for (unsigned int i = 0; i < jobCount; i++)
+			job(i);
+		return;
+	}
+
+	//Publish the batch and wake everyone up
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		batchJob = &job;
+		batchCount = jobCount;
+		nextJob = 0;
+		activeWorkers = (unsigned int)workers.size();
+		batchGeneration++;
+	}
+	wake.notify_all();
+
+	//Caller helps out, then waits for stragglers
+	RunJobs();
+
+	std::unique_lock<std::mutex> wait(lock);
+	done.wait(wait, [this] { return activeWorkers == 0; });
+	batchJob = nullptr;
+}
+
+void JobSystem::StartWorkers(unsigned int workerCount)
+{
+	quit = false;
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		//Hand over the current generation so a slow starting worker can't miss the first batch
+		workers.push_back(std::thread(&JobSystem::WorkerLoop, this, batchGeneration));
+	}
+}
+
+void JobSystem::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+	}
+	wake.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+	workers.clear();
+}
+
+void JobSystem::WorkerLoop(unsigned int seenGeneration)
+{
+	while (true)
+	{
+		//Sleep until there is a new batch (or we are shutting down)
+		{
+			std::unique_lock<std::mutex> wait(lock);
+			wake.wait(wait, [&] { return quit || batchGeneration != seenGeneration; });
+			if (quit) return;
+			seenGeneration = batchGeneration;
+		}
+
+		RunJobs();
+
+		//Last one out lets the caller know
+		std::lock_guard<std::mutex> guard(lock);
+		activeWorkers--;
+		if (activeWorkers == 0)
+			done.notify_one();
+	}
+}
+
+void JobSystem::RunJobs()
+{
+	PROFILE_SCOPE("Jobs");
+
+	//Grab jobs until the batch is exhausted
+	unsigned int i;
+	while ((i = nextJob.fetch_add(1)) < batchCount)
+	{
+		(*batchJob)(i);
+	}
+}
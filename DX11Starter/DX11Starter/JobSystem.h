@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// Small fixed-size worker pool for splitting per-frame work
+// across cores.  The calling thread always takes part in the
+// work, so a pool with a thread count of 1 runs everything
+// inline on the caller with no synchronization.
+// --------------------------------------------------------
+class JobSystem
+{
+public:
+	// threadCount - total threads including the caller, 0 = one per hardware core
+	JobSystem(unsigned int threadCount = 0);
+	~JobSystem();
+
+	// Runs job(i) for every i in [0, jobCount) and blocks until all are done
+	void ParallelFor(unsigned int jobCount, const std::function<void(unsigned int)>& job);
+
+	unsigned int GetThreadCount();
+	void SetThreadCount(unsigned int threadCount);
+
+	static unsigned int GetHardwareThreadCount();
+
+private:
+	void StartWorkers(unsigned int workerCount);
+	void StopWorkers();
+	void WorkerLoop(unsigned int seenGeneration);
+	void RunJobs();
+
+	std::vector<std::thread> workers;
+	std::mutex lock;
+	std::condition_variable wake;
+	std::condition_variable done;
+	bool quit;
+
+	// Current batch of work
+	const std::function<void(unsigned int)>* batchJob;
+	unsigned int batchCount;
+	unsigned int batchGeneration;
+	std::atomic<unsigned int> nextJob;
+	unsigned int activeWorkers;
+};
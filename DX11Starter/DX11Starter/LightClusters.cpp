@@ -0,0 +1,240 @@
+#include "LightClusters.h"
+#include <math.h>
+
+LightClusters::LightClusters(int tilesX, int tilesY, int slices)
+{
+	this->tilesX = tilesX;
+	this->tilesY = tilesY;
+	this->slices = slices;
+
+	nearClip = 0.0f;
+	farClip = 0.0f;
+	tanX = 0.0f;
+	tanY = 0.0f;
+}
+
+LightClusters::~LightClusters()
+{
+}
+
+void LightClusters::Build(XMFLOAT4X4 view, XMFLOAT4X4 projection, const vector<PointLight*>& lights)
+{
+	//Pull the frustum back out of the (transposed, left handed) projection
+	float a = projection._33;
+	float b = projection._34;
+	float n = -b / a;
+	float f = b / (1.0f - a);
+	float tx = 1.0f / projection._11;
+	float ty = 1.0f / projection._22;
+
+	//Cluster bounds only depend on the projection, so they're kept until it changes
+	if (clusterMin.empty() || n != nearClip || f != farClip || tx != tanX || ty != tanY)
+		BuildBounds(n, f, tx, ty);
+
+	TransformLights(view, lights);
+
+	pairs.clear();
+	for (size_t i = 0; i < spheres.size(); i++)
+	{
+		XMFLOAT4 s = spheres[i];
+		if (s.w <= 0.0f || s.z + s.w < nearClip || s.z - s.w > farClip)
+			continue;
+
+		//Slices from depth, one either side in case the log and the
+		//slice boundaries round differently.  The exact test sorts it out
+		int firstSlice = SliceOf(s.z - s.w) - 1;
+		int lastSlice = SliceOf(s.z + s.w) + 1;
+		if (firstSlice < 0) firstSlice = 0;
+		if (lastSlice > slices - 1) lastSlice = slices - 1;
+
+		for (int z = firstSlice; z <= lastSlice; z++)
+		{
+			//Columns and rows whose extents overlap the sphere's box
+			float* cMin = &columnMin[z * tilesX];
+			float* cMax = &columnMax[z * tilesX];
+			int x0 = 0;
+			while (x0 < tilesX && cMax[x0] < s.x - s.w) x0++;
+			int x1 = tilesX - 1;
+			while (x1 >= x0 && cMin[x1] > s.x + s.w) x1--;
+
+			float* rMin = &rowMin[z * tilesY];
+			float* rMax = &rowMax[z * tilesY];
+			int y0 = 0;
+			while (y0 < tilesY && rMax[y0] < s.y - s.w) y0++;
+			int y1 = tilesY - 1;
+			while (y1 >= y0 && rMin[y1] > s.y + s.w) y1--;
+
+			for (int y = y0; y <= y1; y++)
+			{
+				for (int x = x0; x <= x1; x++)
+				{
+					int cluster = GetClusterIndex(x, y, z);
+					if (SphereTouchesCluster(s, cluster))
+						pairs.push_back(pair<unsigned int, unsigned int>(cluster, (unsigned int)i));
+				}
+			}
+		}
+	}
+
+	//Group by cluster with a counting sort, lights stay in index order
+	ClusterRange empty = { 0, 0 };
+	clusters.assign(tilesX * tilesY * slices, empty);
+	for (size_t i = 0; i < pairs.size(); i++)
+		clusters[pairs[i].first].count++;
+
+	unsigned int offset = 0;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		clusters[c].offset = offset;
+		offset += clusters[c].count;
+		clusters[c].count = 0;
+	}
+
+	lightIndices.resize(pairs.size());
+	for (size_t i = 0; i < pairs.size(); i++)
+	{
+		ClusterRange& range = clusters[pairs[i].first];
+		lightIndices[range.offset + range.count] = pairs[i].second;
+		range.count++;
+	}
+}
+
+int LightClusters::VerifyAgainstBruteForce()
+{
+	int mismatches = 0;
+	vector<unsigned int> expected;
+	for (int c = 0; c < (int)clusters.size(); c++)
+	{
+		expected.clear();
+		for (size_t i = 0; i < spheres.size(); i++)
+		{
+			if (spheres[i].w > 0.0f && SphereTouchesCluster(spheres[i], c))
+				expected.push_back((unsigned int)i);
+		}
+
+		bool same = expected.size() == clusters[c].count;
+		for (size_t i = 0; same && i < expected.size(); i++)
+			same = expected[i] == lightIndices[clusters[c].offset + i];
+
+		if (!same)
+			mismatches++;
+	}
+	return mismatches;
+}
+
+int LightClusters::GetClusterIndex(int x, int y, int z)
+{
+	return x + tilesX * (y + tilesY * z);
+}
+
+const vector<LightClusters::ClusterRange>& LightClusters::GetClusters()
+{
+	return clusters;
+}
+
+const vector<unsigned int>& LightClusters::GetLightIndices()
+{
+	return lightIndices;
+}
+
+int LightClusters::GetTilesX()
+{
+	return tilesX;
+}
+
+int LightClusters::GetTilesY()
+{
+	return tilesY;
+}
+
+int LightClusters::GetSliceCount()
+{
+	return slices;
+}
+
+//Slices are spaced exponentially, so near ones are thin and far ones are thick
+float LightClusters::GetSliceDepth(int slice)
+{
+	return nearClip * powf(farClip / nearClip, (float)slice / slices);
+}
+
+void LightClusters::BuildBounds(float nearClip, float farClip, float tanX, float tanY)
+{
+	this->nearClip = nearClip;
+	this->farClip = farClip;
+	this->tanX = tanX;
+	this->tanY = tanY;
+
+	int count = tilesX * tilesY * slices;
+	clusterMin.resize(count);
+	clusterMax.resize(count);
+	columnMin.resize(tilesX * slices);
+	columnMax.resize(tilesX * slices);
+	rowMin.resize(tilesY * slices);
+	rowMax.resize(tilesY * slices);
+
+	for (int z = 0; z < slices; z++)
+	{
+		float zNear = GetSliceDepth(z);
+		float zFar = GetSliceDepth(z + 1);
+
+		//Each tile edge is a plane through the eye, x = edge * depth, so the
+		//box around a froxel takes whichever end of the slice is wider
+		for (int x = 0; x < tilesX; x++)
+		{
+			float left = (-1.0f + 2.0f * x / tilesX) * tanX;
+			float right = (-1.0f + 2.0f * (x + 1) / tilesX) * tanX;
+			columnMin[z * tilesX + x] = left < 0 ? left * zFar : left * zNear;
+			columnMax[z * tilesX + x] = right < 0 ? right * zNear : right * zFar;
+		}
+		for (int y = 0; y < tilesY; y++)
+		{
+			float bottom = (-1.0f + 2.0f * y / tilesY) * tanY;
+			float top = (-1.0f + 2.0f * (y + 1) / tilesY) * tanY;
+			rowMin[z * tilesY + y] = bottom < 0 ? bottom * zFar : bottom * zNear;
+			rowMax[z * tilesY + y] = top < 0 ? top * zNear : top * zFar;
+		}
+
+		for (int y = 0; y < tilesY; y++)
+		{
+			for (int x = 0; x < tilesX; x++)
+			{
+				int c = GetClusterIndex(x, y, z);
+				clusterMin[c] = XMFLOAT3(columnMin[z * tilesX + x], rowMin[z * tilesY + y], zNear);
+				clusterMax[c] = XMFLOAT3(columnMax[z * tilesX + x], rowMax[z * tilesY + y], zFar);
+			}
+		}
+	}
+}
+
+void LightClusters::TransformLights(XMFLOAT4X4 view, const vector<PointLight*>& lights)
+{
+	//Rows of the transposed view matrix take a point straight to view space
+	spheres.resize(lights.size());
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		XMFLOAT3 p = lights[i]->Position;
+		spheres[i].x = view._11 * p.x + view._12 * p.y + view._13 * p.z + view._14;
+		spheres[i].y = view._21 * p.x + view._22 * p.y + view._23 * p.z + view._24;
+		spheres[i].z = view._31 * p.x + view._32 * p.y + view._33 * p.z + view._34;
+		spheres[i].w = GetPointLightRange(lights[i]);
+	}
+}
+
+int LightClusters::SliceOf(float depth)
+{
+	if (depth <= nearClip)
+		return 0;
+	return (int)(logf(depth / nearClip) / logf(farClip / nearClip) * slices);
+}
+
+bool LightClusters::SphereTouchesCluster(XMFLOAT4 sphere, int cluster)
+{
+	//Distance from the center to the closest point of the box
+	XMFLOAT3 lo = clusterMin[cluster];
+	XMFLOAT3 hi = clusterMax[cluster];
+	float dx = sphere.x < lo.x ? lo.x - sphere.x : (sphere.x > hi.x ? sphere.x - hi.x : 0.0f);
+	float dy = sphere.y < lo.y ? lo.y - sphere.y : (sphere.y > hi.y ? sphere.y - hi.y : 0.0f);
+	float dz = sphere.z < lo.z ? lo.z - sphere.z : (sphere.z > hi.z ? sphere.z - hi.z : 0.0f);
+	return dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w;
+}
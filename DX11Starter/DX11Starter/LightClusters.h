@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include "Portable.h"
+#include "Lights.h"
+
+using namespace std;
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Bins point lights into a grid of view space froxels (screen
+// tiles, cut into depth slices that get thicker further out).
+// The result is one flat list of light indices plus an offset
+// and count per cluster, so a shader can look up the lights for
+// a pixel from its tile and depth.
+//
+// Only uses the camera matrices, so it can be built and checked
+// against the brute force version without a device.
+// --------------------------------------------------------
+class LightClusters
+{
+public:
+	LightClusters(int tilesX = 16, int tilesY = 9, int slices = 24);
+	~LightClusters();
+
+	//Where one cluster's lights are in the index list
+	struct ClusterRange
+	{
+		unsigned int offset;
+		unsigned int count;
+	};
+
+	//view and projection are transposed, the way Camera stores them.
+	//Lights with no radius are skipped, ranges come from GetPointLightRange
+	void Build(XMFLOAT4X4 view, XMFLOAT4X4 projection, const vector<PointLight*>& lights);
+
+	//Tests every light from the last Build against every cluster and compares
+	//with what Build came up with, returns how many clusters disagree
+	int VerifyAgainstBruteForce();
+
+	//Cluster (x, y, z) is at x + tilesX * (y + tilesY * z).  Tile rows
+	//start at the bottom of the screen, slices at the near plane
+	int GetClusterIndex(int x, int y, int z);
+	const vector<ClusterRange>& GetClusters();
+	const vector<unsigned int>& GetLightIndices();
+
+	int GetTilesX();
+	int GetTilesY();
+	int GetSliceCount();
+	float GetSliceDepth(int slice);
+
+private:
+	int tilesX;
+	int tilesY;
+	int slices;
+
+	//Projection the cluster bounds were made for
+	float nearClip;
+	float farClip;
+	float tanX;
+	float tanY;
+
+	//View space bounding box of each cluster
+	vector<XMFLOAT3> clusterMin;
+	vector<XMFLOAT3> clusterMax;
+
+	//Per slice, the x and y extents of each column/row of clusters.  Both
+	//edges grow with the index, which lets a light find its tiles quickly
+	vector<float> columnMin;
+	vector<float> columnMax;
+	vector<float> rowMin;
+	vector<float> rowMax;
+
+	//View space light spheres for this build
+	vector<XMFLOAT4> spheres;
+
+	//Output
+	vector<ClusterRange> clusters;
+	vector<unsigned int> lightIndices;
+
+	//(cluster, light) pairs before they're grouped by cluster
+	vector<pair<unsigned int, unsigned int>> pairs;
+
+	void BuildBounds(float nearClip, float farClip, float tanX, float tanY);
+	void TransformLights(XMFLOAT4X4 view, const vector<PointLight*>& lights);
+	int SliceOf(float depth);
+	bool SphereTouchesCluster(XMFLOAT4 sphere, int cluster);
+};
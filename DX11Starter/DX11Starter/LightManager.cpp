@@ -1,17 +1,314 @@
 #include "LightManager.h"
+#include "Entity.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
 
 
 
-LightManager::LightManager()
+LightManager::LightManager(ID3D11Device* device)
 {
+	lightsPerObject = 16;
+	culledLights = 0;
+	sentLights = 0;
+
+	this->device = device;
+	lightBuffer = nullptr;
+	lightSRV = nullptr;
+	bufferCapacity = 0;
+	uploadBytes = 0;
+	CreateLightBuffer(maxLightsPerObject);
+
+	lightIndexBuffer = nullptr;
+	lightIndexSRV = nullptr;
+	indexCapacity = 0;
+	CreateLightIndexBuffer(maxLightsPerObject * 4);
 }
 
 
 LightManager::~LightManager()
 {
+	lightSRV->Release();
+	lightBuffer->Release();
+	lightIndexSRV->Release();
+	lightIndexBuffer->Release();
+
 	while (pointLights.size() > 0)
 	{
 		delete pointLights[pointLights.size() - 1];
 		pointLights.pop_back();
 	}
 }
+
+void LightManager::CullLights(const vector<Entity*>& entities)
+{
+	PROFILE_SCOPE("Light culling");
+
+	//Lights that are switched off go now
+	candidates.clear();
+	for (size_t i = 0; i < pointLights.size(); i++)
+	{
+		PointLight* l = pointLights[i];
+		if (l->Radius <= 0.0f)
+			continue;
+
+		LightCandidate c;
+		c.light = (int)i;
+		c.position = l->Position;
+		c.range = GetPointLightRange(l);
+
+		//Brightest channel of whatever the light adds, scaled by its falloff
+		float diffuse = l->DiffuseColor.x > l->DiffuseColor.y ? l->DiffuseColor.x : l->DiffuseColor.y;
+		diffuse = diffuse > l->DiffuseColor.z ? diffuse : l->DiffuseColor.z;
+		float ambient = l->AmbientColor.x > l->AmbientColor.y ? l->AmbientColor.x : l->AmbientColor.y;
+		ambient = ambient > l->AmbientColor.z ? ambient : l->AmbientColor.z;
+		c.brightness = (diffuse + ambient) * l->Radius / 0.04f;
+		candidates.push_back(c);
+	}
+
+	lightLists.resize(entities.size());
+	lightSlots.clear();
+	lightIndices.clear();
+	culledLights = 0;
+	sentLights = 0;
+
+	for (size_t e = 0; e < entities.size(); e++)
+	{
+		Entity* entity = entities[e];
+		lightSlots[entity] = (int)e;
+		lightLists[e].first = (int)lightIndices.size();
+		lightLists[e].count = 0;
+
+		if (!entity->IsActive())
+			continue;
+
+		//Sphere against sphere, scoring by the light's strength at the closest
+		//point of the entity's bounds
+		XMFLOAT3 center = entity->GetRenderPosition();
+		float radius = entity->GetRadius();
+		scratch.clear();
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			float dx = candidates[i].position.x - center.x;
+			float dy = candidates[i].position.y - center.y;
+			float dz = candidates[i].position.z - center.z;
+			float reach = candidates[i].range + radius;
+			float distSq = dx * dx + dy * dy + dz * dz;
+			if (distSq > reach * reach)
+			{
+				culledLights++;
+				continue;
+			}
+
+			float gap = sqrtf(distSq) - radius;
+			if (gap < 0.1f) gap = 0.1f;
+			scratch.push_back(pair<float, int>(candidates[i].brightness / (gap * gap), candidates[i].light));
+		}
+
+		//Keep the strongest few
+		int keep = (int)scratch.size() < lightsPerObject ? (int)scratch.size() : lightsPerObject;
+		partial_sort(scratch.begin(), scratch.begin() + keep, scratch.end(),
+			[](const pair<float, int>& a, const pair<float, int>& b) { return a.first > b.first; });
+		culledLights += (int)scratch.size() - keep;
+
+		for (int i = 0; i < keep; i++)
+			lightIndices.push_back(scratch[i].second);
+		lightLists[e].count = keep;
+		sentLights += keep;
+	}
+}
+
+int LightManager::GatherLightIndices(Entity* entity, unsigned int* out, int maxLights)
+{
+	//Entities that weren't in the last cull don't get any point lights
+	int slot = GetLightSlot(entity);
+	if (slot < 0)
+		return 0;
+
+	LightList list = lightLists[slot];
+	int count = list.count < maxLights ? list.count : maxLights;
+	for (int i = 0; i < count; i++)
+	{
+		out[i] = (unsigned int)lightIndices[list.first + i];
+	}
+
+	//The whole index array goes up with the draw, whatever the count
+	uploadBytes += sizeof(unsigned int) * maxLights;
+	return count;
+}
+
+void LightManager::GetLightList(Entity* entity, unsigned int& first, unsigned int& count)
+{
+	first = 0;
+	count = 0;
+	int slot = GetLightSlot(entity);
+	if (slot < 0)
+		return;
+
+	first = (unsigned int)lightLists[slot].first;
+	count = (unsigned int)lightLists[slot].count;
+}
+
+int LightManager::GetLightSlot(Entity* entity)
+{
+	unordered_map<Entity*, int>::iterator it = lightSlots.find(entity);
+	return it != lightSlots.end() ? it->second : -1;
+}
+
+int LightManager::FindLight(PointLight* light)
+{
+	for (size_t i = 0; i < pointLights.size(); i++)
+	{
+		if (pointLights[i] == light)
+			return (int)i;
+	}
+	return -1;
+}
+
+void LightManager::SetLightsPerObject(int count)
+{
+	if (count < 0) count = 0;
+	if (count > maxLightsPerObject) count = maxLightsPerObject;
+	lightsPerObject = count;
+}
+
+void LightManager::UpdateLightBuffer(ID3D11DeviceContext* context)
+{
+	PROFILE_SCOPE("Light packing");
+	uploadBytes = 0;
+
+	//Index list first, it doesn't depend on whether any light moved
+	bool indicesDirty = lightIndices.size() != uploadedIndices.size();
+	if ((int)lightIndices.size() > indexCapacity)
+	{
+		int capacity = indexCapacity;
+		while (capacity < (int)lightIndices.size())
+			capacity *= 2;
+		CreateLightIndexBuffer(capacity);
+		indicesDirty = true;
+	}
+	if (!indicesDirty && !lightIndices.empty())
+		indicesDirty = memcmp(&lightIndices[0], &uploadedIndices[0], sizeof(int) * lightIndices.size()) != 0;
+	if (indicesDirty && !lightIndices.empty())
+	{
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		context->Map(lightIndexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+		memcpy(mapped.pData, &lightIndices[0], sizeof(int) * lightIndices.size());
+		context->Unmap(lightIndexBuffer, 0);
+
+		uploadedIndices = lightIndices;
+		uploadBytes += sizeof(int) * (int)lightIndices.size();
+	}
+
+	//Light buffer order matches pointLights, so culled indices point straight into it
+	packedLights.resize(pointLights.size());
+	for (size_t i = 0; i < pointLights.size(); i++)
+	{
+		packedLights[i] = *(pointLights[i]);
+	}
+
+	bool dirty = packedLights.size() != uploadedLights.size();
+	if ((int)packedLights.size() > bufferCapacity)
+	{
+		int capacity = bufferCapacity;
+		while (capacity < (int)packedLights.size())
+			capacity *= 2;
+		CreateLightBuffer(capacity);
+		dirty = true;
+	}
+	if (!dirty && !packedLights.empty())
+		dirty = memcmp(&packedLights[0], &uploadedLights[0], sizeof(PointLight) * packedLights.size()) != 0;
+	if (!dirty || packedLights.empty())
+		return;
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	context->Map(lightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	memcpy(mapped.pData, &packedLights[0], sizeof(PointLight) * packedLights.size());
+	context->Unmap(lightBuffer, 0);
+
+	uploadedLights = packedLights;
+	uploadBytes += sizeof(PointLight) * (int)packedLights.size();
+}
+
+ID3D11ShaderResourceView* LightManager::GetLightSRV()
+{
+	return lightSRV;
+}
+
+ID3D11ShaderResourceView* LightManager::GetLightIndexSRV()
+{
+	return lightIndexSRV;
+}
+
+int LightManager::GetLightUploadBytes()
+{
+	return uploadBytes;
+}
+
+void LightManager::CreateLightBuffer(int capacity)
+{
+	if (lightSRV) lightSRV->Release();
+	if (lightBuffer) lightBuffer->Release();
+	bufferCapacity = capacity;
+
+	// DYNAMIC structured buffer, rewritten whenever a light changes
+	D3D11_BUFFER_DESC desc = {};
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	desc.StructureByteStride = sizeof(PointLight);
+	desc.ByteWidth = sizeof(PointLight) * capacity;
+	device->CreateBuffer(&desc, 0, &lightBuffer);
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = capacity;
+	device->CreateShaderResourceView(lightBuffer, &srvDesc, &lightSRV);
+}
+
+void LightManager::CreateLightIndexBuffer(int capacity)
+{
+	if (lightIndexSRV) lightIndexSRV->Release();
+	if (lightIndexBuffer) lightIndexBuffer->Release();
+	indexCapacity = capacity;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	desc.StructureByteStride = sizeof(unsigned int);
+	desc.ByteWidth = sizeof(unsigned int) * capacity;
+	device->CreateBuffer(&desc, 0, &lightIndexBuffer);
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = capacity;
+	device->CreateShaderResourceView(lightIndexBuffer, &srvDesc, &lightIndexSRV);
+}
+
+void LightManager::BuildClusters(XMFLOAT4X4 view, XMFLOAT4X4 projection)
+{
+	clusters.Build(view, projection, pointLights);
+}
+
+LightClusters* LightManager::GetClusters()
+{
+	return &clusters;
+}
+
+int LightManager::GetCulledLightCount()
+{
+	return culledLights;
+}
+
+int LightManager::GetSentLightCount()
+{
+	return sentLights;
+}
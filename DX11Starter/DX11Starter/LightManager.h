@@ -1,15 +1,113 @@
 #pragma once
 #include<vector>
+#include<unordered_map>
+#include <d3d11.h>
 #include "Lights.h"
+#include "LightClusters.h"
+#include "ShaderConstants.h"
 
 using namespace std;
 
+class Entity;
+
 class LightManager
 {
 public:
-	LightManager();
+	LightManager(ID3D11Device* device);
 	~LightManager();
 	DirectionalLight dirLight;
 	vector<PointLight*> pointLights;
+
+	//Most lights a single draw will get, and the size of the shaders' light index array
+	static const int maxLightsPerObject = 64;
+
+	//Packs every point light into one structured buffer, once a frame.
+	//Nothing is uploaded if no light changed since last time
+	void UpdateLightBuffer(ID3D11DeviceContext* context);
+	ID3D11ShaderResourceView* GetLightSRV();
+
+	//Every entity's culled light indices in one list, for instanced draws that
+	//can't take a per object array.  Sent along with the light buffer
+	ID3D11ShaderResourceView* GetLightIndexSRV();
+
+	//Works out which lights touch each entity, once a frame after the render
+	//blend is set, from where each entity is drawn.  Each entity keeps the
+	//strongest lightsPerObject of them
+	void CullLights(const vector<Entity*>& entities);
+
+	//Copies the indices (into the light buffer) of an entity's lights into out,
+	//strongest first, and returns how many.  Never writes more than maxLights
+	int GatherLightIndices(Entity* entity, unsigned int* out, int maxLights);
+
+	//Where an entity's lights are in the light index list instead
+	void GetLightList(Entity* entity, unsigned int& first, unsigned int& count);
+
+	//Index of a light in the light buffer, -1 if it isn't one of ours
+	int FindLight(PointLight* light);
+
+	void SetLightsPerObject(int count);
+
+	//Bins every point light into the camera's view space clusters
+	void BuildClusters(XMFLOAT4X4 view, XMFLOAT4X4 projection);
+	LightClusters* GetClusters();
+
+	//Last cull's totals, for checking it's doing something
+	int GetCulledLightCount();
+	int GetSentLightCount();
+
+	//Light buffer plus per draw index bytes since the last UpdateLightBuffer
+	int GetLightUploadBytes();
+
+private:
+	//A light that might reach something this frame
+	struct LightCandidate
+	{
+		int light;
+		XMFLOAT3 position;
+		float range;
+		float brightness;
+	};
+
+	//One entity's lights are lightIndices[first .. first + count)
+	struct LightList
+	{
+		int first;
+		int count;
+	};
+
+	int lightsPerObject;
+	vector<LightCandidate> candidates;
+	vector<LightList> lightLists;
+	unordered_map<Entity*, int> lightSlots;
+	vector<int> lightIndices;
+	vector<pair<float, int>> scratch;
+	int culledLights;
+	int sentLights;
+
+	LightClusters clusters;
+
+	//Packed lights on the GPU, and a copy of what was last sent for dirty checks
+	ID3D11Device* device;
+	ID3D11Buffer* lightBuffer;
+	ID3D11ShaderResourceView* lightSRV;
+	int bufferCapacity;
+	vector<PointLight> packedLights;
+	vector<PointLight> uploadedLights;
+	int uploadBytes;
+
+	//Same again for the light index list
+	ID3D11Buffer* lightIndexBuffer;
+	ID3D11ShaderResourceView* lightIndexSRV;
+	int indexCapacity;
+	vector<int> uploadedIndices;
+
+	//Where an entity's list is in lightLists, -1 if it wasn't in the last cull
+	int GetLightSlot(Entity* entity);
+
+	void CreateLightBuffer(int capacity);
+	void CreateLightIndexBuffer(int capacity);
 };
 
+//The ship shader's light index array has to hold maxLightsPerObject indices
+static_assert(sizeof(ShipPS::perObject::lightIndices) == sizeof(unsigned int) * LightManager::maxLightsPerObject,
+	"ShipPS lightIndices doesn't match LightManager::maxLightsPerObject");
@@ -1,7 +1,7 @@
 #pragma once
 
-#include <d3d11.h>
-#include <DirectXMath.h>
+#include <math.h>
+#include "Portable.h"
 
 using namespace DirectX;
 
@@ -20,4 +20,15 @@ struct PointLight
 	XMFLOAT4 SpecularColor;
 	XMFLOAT3 Position;
 	float Radius;
-};
\ No newline at end of file
+};
+
+//How far a point light reaches before it drops below 1% strength, 0 if it's
+//off.  Lights fall off as radius / (0.04 * d^2), so solve for where that
+//drops below the cutoff
+inline float GetPointLightRange(const PointLight* light)
+{
+	const float cutoff = 0.01f;
+	if (light->Radius <= 0.0f)
+		return 0.0f;
+	return sqrtf(light->Radius / (0.04f * cutoff));
+}
@@ -1,6 +1,7 @@
 
 #include <Windows.h>
 #include "Game.h"
+#include "SimulationBenchmark.h"
 
 // --------------------------------------------------------
 // Entry point for a graphical (non-console) Windows application
@@ -44,6 +45,23 @@ int WINAPI WinMain(
 		}
 	}
 
+	// "-benchmark" steps the simulation without playing or drawing,
+	// optionally followed by how many steps (a minute at 60Hz by default).
+	// It never makes a window or a device, just a console for the results
+	char* benchmarkArg = strstr(lpCmdLine, "-benchmark");
+	if (benchmarkArg)
+	{
+		int benchmarkSteps = atoi(benchmarkArg + strlen("-benchmark"));
+		if (benchmarkSteps <= 0)
+			benchmarkSteps = 3600;
+
+		AllocConsole();
+		FILE* stream;
+		freopen_s(&stream, "CONOUT$", "w", stdout);
+		freopen_s(&stream, "CONOUT$", "w", stderr);
+		return RunSimulationBenchmark(benchmarkSteps, "Assets");
+	}
+
 	// Create the Game object using
 	// the app handle we got from WinMain
 	Game dxGame(hInstance);
@@ -1,5 +1,8 @@
 #include "Material.h"
 
+Material* Material::boundMaterial = nullptr;
+int Material::bindCount = 0;
+
 Material::Material(SimpleVertexShader* vertexShader, SimplePixelShader* pixelShader, ID3D11ShaderResourceView* texture, ID3D11SamplerState* sampler)
 {
 	this->vertexShader = vertexShader;
@@ -9,6 +12,8 @@ Material::Material(SimpleVertexShader* vertexShader, SimplePixelShader* pixelSha
 
 	texture->AddRef();
 	sampler->AddRef();
+
+	FindHandles();
 }
 
 Material::Material(SimpleVertexShader* vertexShader, SimplePixelShader* pixelShader, ID3D11ShaderResourceView* texture, ID3D11ShaderResourceView* normalMap, ID3D11SamplerState* sampler) : Material(vertexShader, pixelShader, texture, sampler)
@@ -50,4 +55,69 @@ ID3D11ShaderResourceView* Material::GetNormal()
 ID3D11SamplerState* Material::GetSampler()
 {
 	return sampler;
-}
\ No newline at end of file
+}
+
+const MaterialHandles& Material::GetHandles()
+{
+	return handles;
+}
+
+void Material::SetInstanced(Material* instanced)
+{
+	this->instanced = instanced;
+}
+
+Material* Material::GetInstanced()
+{
+	return instanced;
+}
+
+void Material::FindHandles()
+{
+	handles.VertexObjectBuffer = vertexShader->GetBufferHandle("perObject");
+	handles.PixelObjectBuffer = pixelShader->GetBufferHandle("perObject");
+
+	handles.World = vertexShader->GetVariableHandle("world");
+	handles.NormalWorld = vertexShader->GetVariableHandle("normalWorld");
+
+	handles.LightIndices = pixelShader->GetVariableHandle("lightIndices");
+	handles.PointLightCount = pixelShader->GetVariableHandle("pointLightCount");
+	handles.BulletLight = pixelShader->GetVariableHandle("bulletLight");
+	handles.Lights = pixelShader->GetShaderResourceViewHandle("lights");
+	handles.LightIndexList = pixelShader->GetShaderResourceViewHandle("lightIndexList");
+	handles.DiffuseTexture = pixelShader->GetShaderResourceViewHandle("diffuseTexture");
+	handles.NormalMap = pixelShader->GetShaderResourceViewHandle("normalMap");
+	handles.BasicSampler = pixelShader->GetSamplerHandle("basicSampler");
+}
+
+bool Material::Bind()
+{
+	if (boundMaterial == this)
+		return false;
+
+	vertexShader->SetShader();
+	pixelShader->SetShader();
+	pixelShader->SetShaderResourceView(handles.DiffuseTexture, texture);
+	if (normalMap != 0)
+		pixelShader->SetShaderResourceView(handles.NormalMap, normalMap);
+	pixelShader->SetSamplerState(handles.BasicSampler, sampler);
+
+	boundMaterial = this;
+	bindCount++;
+	return true;
+}
+
+void Material::ResetBinding()
+{
+	boundMaterial = nullptr;
+}
+
+int Material::GetBindCount()
+{
+	return bindCount;
+}
+
+void Material::ResetBindCount()
+{
+	bindCount = 0;
+}
@@ -1,8 +1,33 @@
 #pragma once
 
 #include "SimpleShader.h"
+#include "ShaderConstants.h"
 #include <memory>
 
+//Handles for everything the entity shaders get set per draw or per material,
+//looked up once when the material is made.  Anything the shaders don't have
+//stays invalid.  Per frame data lives in FrameConstants instead
+struct MaterialHandles
+{
+	//perObject cbuffers, for filling with a ShaderConstants.h struct
+	SimpleShaderHandle VertexObjectBuffer;
+	SimpleShaderHandle PixelObjectBuffer;
+
+	//Vertex shader
+	SimpleShaderHandle World;
+	SimpleShaderHandle NormalWorld;
+
+	//Pixel shader
+	SimpleShaderHandle LightIndices;
+	SimpleShaderHandle PointLightCount;
+	SimpleShaderHandle BulletLight;
+	SimpleShaderHandle Lights;
+	SimpleShaderHandle LightIndexList;
+	SimpleShaderHandle DiffuseTexture;
+	SimpleShaderHandle NormalMap;
+	SimpleShaderHandle BasicSampler;
+};
+
 class Material
 {
 public:
@@ -14,6 +39,24 @@ public:
 	ID3D11ShaderResourceView* GetTexture();
 	ID3D11ShaderResourceView* GetNormal();
 	ID3D11SamplerState* GetSampler();
+	const MaterialHandles& GetHandles();
+
+	//Same textures with instanced shaders, for drawing many entities at once.
+	//Null if this material can only draw one at a time
+	void SetInstanced(Material* instanced);
+	Material* GetInstanced();
+
+	//Sets the shaders, textures and sampler, unless this material is still
+	//bound from the last draw.  Returns true if it had to bind, so callers
+	//can set any other per material resources
+	bool Bind();
+
+	//Forgets the bound material, for when something else changed shaders
+	static void ResetBinding();
+
+	//Times Bind actually bound since the last ResetBindCount
+	static int GetBindCount();
+	static void ResetBindCount();
 private:
 	//Shader
 	SimpleVertexShader* vertexShader = 0;
@@ -23,4 +66,11 @@ private:
 	ID3D11ShaderResourceView* texture = 0;
 	ID3D11ShaderResourceView* normalMap = 0;
 	ID3D11SamplerState* sampler = 0;
+
+	MaterialHandles handles;
+	Material* instanced = 0;
+	void FindHandles();
+
+	static Material* boundMaterial;
+	static int bindCount;
 };
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <fstream>
 #include <DirectXMath.h>
 #include "Vertex.h"
+#include "MeshData.h"
 
 using namespace DirectX;
 
@@ -32,6 +33,5 @@ private:
 	//Helpers
 	void CreateBuffers(Vertex verticies[], int vertexCount, unsigned int indices[], int indexCount, ID3D11Device* device);
 	void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices);
-	void CalcSphere(Vertex verticies[], int vertexCount);
 };
 
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+#include "Portable.h"
+#include "Vertex.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// A model read from an OBJ file into plain arrays, with the
+// radius of its bounding sphere.  Mesh makes its buffers from
+// this, and the simulation only needs the radius, so it can
+// load models without a device.
+// --------------------------------------------------------
+class MeshData
+{
+public:
+	MeshData();
+	~MeshData();
+
+	//False if the file couldn't be opened
+	bool Load(const char* filename);
+
+	std::vector<Vertex> Vertices;
+	std::vector<unsigned int> Indices;
+	float Radius;
+
+	//Furthest any vertex is from the middle of them all
+	static float CalcRadius(const Vertex* vertices, int vertexCount);
+};
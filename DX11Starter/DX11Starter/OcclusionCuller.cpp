@@ -0,0 +1,344 @@
+#include "OcclusionCuller.h"
+#include <xmmintrin.h>
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+
+OcclusionCuller::OcclusionCuller(JobSystem* jobSystem, int width, int height)
+{
+	this->jobSystem = jobSystem;
+
+	//Rows are done four pixels at a time
+	this->width = (width + 3) & ~3;
+	this->height = height;
+	tilesX = (this->width + tileSize - 1) / tileSize;
+	tilesY = (height + tileSize - 1) / tileSize;
+	depth.resize(this->width * height, FLT_MAX);
+	tileMax.resize(tilesX * tilesY, FLT_MAX);
+
+	maxOccluders = 16;
+	scaleX = 1.0f;
+	scaleY = 1.0f;
+	nearClip = 0.01f;
+	hiddenCount = 0;
+	time = 0.0;
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+}
+
+void OcclusionCuller::Begin(XMFLOAT4X4 view, XMFLOAT4X4 projection)
+{
+	this->view = view;
+	occluders.clear();
+
+	//Left handed perspective, so x and y are scaled then divided by view depth
+	scaleX = projection._11;
+	scaleY = projection._22;
+	nearClip = -projection._34 / projection._33;
+}
+
+void OcclusionCuller::AddOccluder(XMFLOAT3 center, float radius)
+{
+	float x = view._11 * center.x + view._12 * center.y + view._13 * center.z + view._14;
+	float y = view._21 * center.x + view._22 * center.y + view._23 * center.z + view._24;
+	float z = view._31 * center.x + view._32 * center.y + view._33 * center.z + view._34;
+	if (z - radius <= nearClip)
+		return;
+
+	//The square inside the slice through the middle of the sphere, at the
+	//middle's depth.  Rounded inwards so it never covers a pixel it shouldn't
+	float half = radius * 0.70710678f;
+	float left = ((x - half) * scaleX / z * 0.5f + 0.5f) * width;
+	float right = ((x + half) * scaleX / z * 0.5f + 0.5f) * width;
+	float top = (0.5f - (y + half) * scaleY / z * 0.5f) * height;
+	float bottom = (0.5f - (y - half) * scaleY / z * 0.5f) * height;
+
+	ScreenRect rect;
+	rect.x0 = (int)ceilf(left);
+	rect.x1 = (int)floorf(right);
+	rect.y0 = (int)ceilf(top);
+	rect.y1 = (int)floorf(bottom);
+	rect.x0 = rect.x0 < 0 ? 0 : rect.x0;
+	rect.y0 = rect.y0 < 0 ? 0 : rect.y0;
+	rect.x1 = rect.x1 > width ? width : rect.x1;
+	rect.y1 = rect.y1 > height ? height : rect.y1;
+	if (rect.x0 >= rect.x1 || rect.y0 >= rect.y1)
+		return;
+
+	rect.depth = z;
+	rect.size = (float)((rect.x1 - rect.x0) * (rect.y1 - rect.y0));
+	occluders.push_back(rect);
+}
+
+void OcclusionCuller::SetMaxOccluders(int count)
+{
+	maxOccluders = count < 0 ? 0 : count;
+}
+
+void OcclusionCuller::Rasterize()
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	//Biggest on screen first
+	if ((int)occluders.size() > maxOccluders)
+	{
+		partial_sort(occluders.begin(), occluders.begin() + maxOccluders, occluders.end(),
+			[](const ScreenRect& a, const ScreenRect& b) { return a.size > b.size; });
+		occluders.resize(maxOccluders);
+	}
+
+	//Each job owns whole rows of tiles, so no two write the same pixel
+	int jobCount = (int)jobSystem->GetThreadCount();
+	jobCount = jobCount > tilesY ? tilesY : jobCount;
+	int tileRowsPerJob = (tilesY + jobCount - 1) / jobCount;
+	jobSystem->ParallelFor(jobCount, [&](unsigned int job)
+	{
+		int firstTileRow = job * tileRowsPerJob;
+		int lastTileRow = firstTileRow + tileRowsPerJob < tilesY ? firstTileRow + tileRowsPerJob : tilesY;
+		if (firstTileRow >= lastTileRow)
+			return;
+
+		int lastRow = lastTileRow * tileSize < height ? lastTileRow * tileSize : height;
+		RasterizeRows(firstTileRow * tileSize, lastRow);
+	});
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	time = elapsed.count();
+}
+
+void OcclusionCuller::RasterizeRows(int firstRow, int lastRow)
+{
+	__m128 far4 = _mm_set1_ps(FLT_MAX);
+	for (int y = firstRow; y < lastRow; y++)
+	{
+		for (int x = 0; x < width; x += 4)
+			_mm_storeu_ps(&depth[y * width + x], far4);
+	}
+
+	__m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	for (size_t i = 0; i < occluders.size(); i++)
+	{
+		const ScreenRect& r = occluders[i];
+		int y0 = r.y0 > firstRow ? r.y0 : firstRow;
+		int y1 = r.y1 < lastRow ? r.y1 : lastRow;
+		if (y0 >= y1)
+			continue;
+
+		//Closest depth wins, with the ends of the span masked off
+		__m128 d = _mm_set1_ps(r.depth);
+		__m128 left = _mm_set1_ps((float)r.x0);
+		__m128 right = _mm_set1_ps((float)r.x1);
+		int xStart = r.x0 & ~3;
+		for (int y = y0; y < y1; y++)
+		{
+			float* row = &depth[y * width];
+			for (int x = xStart; x < r.x1; x += 4)
+			{
+				__m128 px = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+				__m128 inside = _mm_and_ps(_mm_cmpge_ps(px, left), _mm_cmplt_ps(px, right));
+				__m128 old = _mm_loadu_ps(row + x);
+				__m128 closer = _mm_min_ps(old, d);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, old)));
+			}
+		}
+	}
+
+	//Farthest depth in each tile these rows cover
+	for (int ty = firstRow / tileSize; ty * tileSize < lastRow; ty++)
+	{
+		for (int tx = 0; tx < tilesX; tx++)
+		{
+			__m128 m = _mm_setzero_ps();
+			int yEnd = (ty + 1) * tileSize < height ? (ty + 1) * tileSize : height;
+			int xEnd = (tx + 1) * tileSize < width ? (tx + 1) * tileSize : width;
+			for (int y = ty * tileSize; y < yEnd; y++)
+			{
+				for (int x = tx * tileSize; x < xEnd; x += 4)
+					m = _mm_max_ps(m, _mm_loadu_ps(&depth[y * width + x]));
+			}
+
+			float lanesOut[4];
+			_mm_storeu_ps(lanesOut, m);
+			float a = lanesOut[0] > lanesOut[1] ? lanesOut[0] : lanesOut[1];
+			float b = lanesOut[2] > lanesOut[3] ? lanesOut[2] : lanesOut[3];
+			tileMax[ty * tilesX + tx] = a > b ? a : b;
+		}
+	}
+}
+
+bool OcclusionCuller::OccludeeRect(XMFLOAT4 sphere, ScreenRect& rect)
+{
+	float x = view._11 * sphere.x + view._12 * sphere.y + view._13 * sphere.z + view._14;
+	float y = view._21 * sphere.x + view._22 * sphere.y + view._23 * sphere.z + view._24;
+	float z = view._31 * sphere.x + view._32 * sphere.y + view._33 * sphere.z + view._34;
+	float r = sphere.w;
+	if (z - r <= nearClip)
+		return false;
+
+	//The sphere fits in a box, and the box's corners bound its projection
+	float nearZ = z - r;
+	float farZ = z + r;
+	float minX = (x - r) / ((x - r) < 0 ? nearZ : farZ);
+	float maxX = (x + r) / ((x + r) > 0 ? nearZ : farZ);
+	float minY = (y - r) / ((y - r) < 0 ? nearZ : farZ);
+	float maxY = (y + r) / ((y + r) > 0 ? nearZ : farZ);
+
+	//Rounded outwards this time, so every pixel it could touch is checked
+	rect.x0 = (int)floorf((minX * scaleX * 0.5f + 0.5f) * width);
+	rect.x1 = (int)ceilf((maxX * scaleX * 0.5f + 0.5f) * width);
+	rect.y0 = (int)floorf((0.5f - maxY * scaleY * 0.5f) * height);
+	rect.y1 = (int)ceilf((0.5f - minY * scaleY * 0.5f) * height);
+	rect.x0 = rect.x0 < 0 ? 0 : rect.x0;
+	rect.y0 = rect.y0 < 0 ? 0 : rect.y0;
+	rect.x1 = rect.x1 > width ? width : rect.x1;
+	rect.y1 = rect.y1 > height ? height : rect.y1;
+	rect.depth = nearZ;
+	rect.size = 0.0f;
+	return rect.x0 < rect.x1 && rect.y0 < rect.y1;
+}
+
+bool OcclusionCuller::IsHidden(const ScreenRect& rect)
+{
+	//Tiles first, if everything in them is closer then that's the answer
+	bool tilesHide = true;
+	for (int ty = rect.y0 / tileSize; ty * tileSize < rect.y1 && tilesHide; ty++)
+	{
+		for (int tx = rect.x0 / tileSize; tx * tileSize < rect.x1 && tilesHide; tx++)
+			tilesHide = tileMax[ty * tilesX + tx] < rect.depth;
+	}
+	if (tilesHide)
+		return true;
+
+	//Then pixel by pixel, stopping at the first one that can see it
+	__m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	__m128 nearest = _mm_set1_ps(rect.depth);
+	__m128 left = _mm_set1_ps((float)rect.x0);
+	__m128 right = _mm_set1_ps((float)rect.x1);
+	int xStart = rect.x0 & ~3;
+	for (int y = rect.y0; y < rect.y1; y++)
+	{
+		const float* row = &depth[y * width];
+		for (int x = xStart; x < rect.x1; x += 4)
+		{
+			__m128 px = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+			__m128 inside = _mm_and_ps(_mm_cmpge_ps(px, left), _mm_cmplt_ps(px, right));
+			__m128 seen = _mm_and_ps(inside, _mm_cmpge_ps(_mm_loadu_ps(row + x), nearest));
+			if (_mm_movemask_ps(seen))
+				return false;
+		}
+	}
+	return true;
+}
+
+int OcclusionCuller::Cull(FrustumCuller* culler)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	int count = culler->GetCount();
+	hidden.assign(count, 0);
+
+	//Split by visibility word, since that's what Hide writes to
+	int words = (count + 31) / 32;
+	int jobCount = (int)jobSystem->GetThreadCount();
+	jobCount = jobCount > words ? words : jobCount;
+	if (jobCount > 0)
+	{
+		int wordsPerJob = (words + jobCount - 1) / jobCount;
+		jobSystem->ParallelFor(jobCount, [&](unsigned int job)
+		{
+			int first = (int)job * wordsPerJob * 32;
+			int last = ((int)job + 1) * wordsPerJob * 32 < count ? ((int)job + 1) * wordsPerJob * 32 : count;
+			for (int i = first; i < last; i++)
+			{
+				ScreenRect rect;
+				if (!culler->IsVisible(i) || !OccludeeRect(culler->GetSphere(i), rect))
+					continue;
+				if (IsHidden(rect))
+				{
+					culler->Hide(i);
+					hidden[i] = 1;
+				}
+			}
+		});
+	}
+	culler->RecountVisible();
+
+	hiddenCount = 0;
+	for (int i = 0; i < count; i++)
+		hiddenCount += hidden[i];
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	time += elapsed.count();
+	return hiddenCount;
+}
+
+bool OcclusionCuller::IsHiddenBruteForce(const ScreenRect& rect)
+{
+	for (int y = rect.y0; y < rect.y1; y++)
+	{
+		for (int x = rect.x0; x < rect.x1; x++)
+		{
+			//Nearest occluder covering this pixel, if any
+			float closest = FLT_MAX;
+			for (size_t i = 0; i < occluders.size(); i++)
+			{
+				const ScreenRect& o = occluders[i];
+				if (x >= o.x0 && x < o.x1 && y >= o.y0 && y < o.y1 && o.depth < closest)
+					closest = o.depth;
+			}
+			if (closest >= rect.depth)
+				return false;
+		}
+	}
+	return true;
+}
+
+int OcclusionCuller::VerifyAgainstBruteForce(FrustumCuller* culler)
+{
+	int wrong = 0;
+	for (int i = 0; i < (int)hidden.size(); i++)
+	{
+		//Spheres the frustum already dropped were never tested
+		if (!hidden[i] && !culler->IsVisible(i))
+			continue;
+
+		ScreenRect rect;
+		bool expected = OccludeeRect(culler->GetSphere(i), rect) && IsHiddenBruteForce(rect);
+		if (expected != (hidden[i] != 0))
+			wrong++;
+	}
+	return wrong;
+}
+
+int OcclusionCuller::GetOccluderCount()
+{
+	return (int)occluders.size();
+}
+
+int OcclusionCuller::GetHiddenCount()
+{
+	return hiddenCount;
+}
+
+double OcclusionCuller::GetTime()
+{
+	return time;
+}
+
+const vector<float>& OcclusionCuller::GetDepth()
+{
+	return depth;
+}
+
+int OcclusionCuller::GetWidth()
+{
+	return width;
+}
+
+int OcclusionCuller::GetHeight()
+{
+	return height;
+}
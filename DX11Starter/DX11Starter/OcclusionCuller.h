@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include "Portable.h"
+#include "JobSystem.h"
+#include "FrustumCuller.h"
+
+using namespace std;
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Hides spheres that are completely behind big nearby objects.
+// The biggest occluders on screen are drawn into a small depth
+// buffer of view depths, each as the square inside its core
+// sphere's middle slice (which can't overstate what it covers).
+// Spheres that passed the frustum test are then checked against
+// it, first against the farthest depth of each 8x8 tile and
+// then pixel by pixel if that isn't enough.
+//
+// Only needs the camera matrices and spheres, so it can be run
+// on made up scenes and checked against the brute force version
+// without a device.
+// --------------------------------------------------------
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(JobSystem* jobSystem, int width = 320, int height = 184);
+	~OcclusionCuller();
+
+	//view and projection are transposed, the way Camera stores them
+	void Begin(XMFLOAT4X4 view, XMFLOAT4X4 projection);
+
+	//A sphere that's solid all the way through, so usually smaller than
+	//the object's bounding sphere
+	void AddOccluder(XMFLOAT3 center, float radius);
+
+	//Keeps the occluders that cover the most screen, and draws them
+	void Rasterize();
+
+	//Clears the bit of every visible sphere that's hidden, returns how many
+	int Cull(FrustumCuller* culler);
+
+	//Tests the last Cull's spheres against the kept occluders directly, one
+	//pixel at a time, and returns how many came out differently
+	int VerifyAgainstBruteForce(FrustumCuller* culler);
+
+	void SetMaxOccluders(int count);
+
+	//Last frame
+	int GetOccluderCount();
+	int GetHiddenCount();
+	double GetTime();
+
+	const vector<float>& GetDepth();
+	int GetWidth();
+	int GetHeight();
+
+private:
+	JobSystem* jobSystem;
+	int width;
+	int height;
+	int tilesX;
+	int tilesY;
+	const int tileSize = 8;
+	int maxOccluders;
+
+	//Camera
+	XMFLOAT4X4 view;
+	float scaleX;
+	float scaleY;
+	float nearClip;
+
+	//Occluders as pixel rectangles [x0, x1) x [y0, y1) at one depth
+	struct ScreenRect
+	{
+		int x0;
+		int y0;
+		int x1;
+		int y1;
+		float depth;
+		float size;
+	};
+	vector<ScreenRect> occluders;
+
+	//View depth per pixel (row by row), and the farthest depth in each tile
+	vector<float> depth;
+	vector<float> tileMax;
+
+	//Spheres hidden by the last Cull
+	vector<char> hidden;
+	int hiddenCount;
+	double time;
+
+	//Screen bounds of a sphere and its nearest depth.  False if it gets
+	//too close to the camera to say anything about
+	bool OccludeeRect(XMFLOAT4 sphere, ScreenRect& rect);
+	bool IsHidden(const ScreenRect& rect);
+	bool IsHiddenBruteForce(const ScreenRect& rect);
+	void RasterizeRows(int firstRow, int lastRow);
+};
@@ -1,4 +1,6 @@
 #include "ParticleEmitter.h"
+#include "ParticleSystem.h"
+#include <math.h>
 
 
 ParticleEmitter::ParticleEmitter(
@@ -12,17 +14,13 @@ ParticleEmitter::ParticleEmitter(
 	DirectX::XMFLOAT3 startVelocity,
 	DirectX::XMFLOAT3 emitterPosition,
 	DirectX::XMFLOAT3 emitterAcceleration,
-	ID3D11Device* device,
-	SimpleVertexShader* vs,
-	SimplePixelShader* ps,
-	ID3D11ShaderResourceView* texture,
+	ParticleSystem* particleSystem,
+	int material,
 	float emitterMaxLife
 )
 {
 	// Save params
-	this->vs = vs;
-	this->ps = ps;
-	this->texture = texture;
+	this->material = material;
 
 	this->maxParticles = maxParticles;
 	this->lifetime = lifetime;
@@ -35,6 +33,10 @@ ParticleEmitter::ParticleEmitter(
 	this->secondsPerParticle = 1.0f / particlesPerSecond;
 
 	this->emitterPosition = emitterPosition;
+	this->prevEmitterPosition = emitterPosition;
+	this->hasPosition = false;
+	this->localSpace = false;
+	this->blendMode = PARTICLE_BLEND_ADDITIVE;
 	this->emitterAcceleration = emitterAcceleration;
 	this->emitterMaxLife = emitterMaxLife;
 	this->emitterLife = 0;
@@ -42,71 +44,33 @@ ParticleEmitter::ParticleEmitter(
 
 	timeSinceEmit = 0;
 	livingParticleCount = 0;
+	frameTime = 0;
+	sleepTime = 0;
+	detail = 1.0f;
+
+	// Furthest a particle can get: it travels for its whole life with the
+	// largest possible jitter, plus the size of its quad
+	float speed = sqrtf(startVelocity.x * startVelocity.x + startVelocity.y * startVelocity.y + startVelocity.z * startVelocity.z) + 0.35f;
+	float accel = sqrtf(emitterAcceleration.x * emitterAcceleration.x + emitterAcceleration.y * emitterAcceleration.y + emitterAcceleration.z * emitterAcceleration.z);
+	float size = startSize > endSize ? startSize : endSize;
+	boundingRadius = speed * lifetime + 0.5f * accel * lifetime * lifetime + size;
 	firstAliveIndex = 0;
 	firstDeadIndex = 0;
 
-	// Make the particle array
-	particles = new Particle[maxParticles];
-
-	// Create local particle vertices (easier to update)
-	// Do UV's here, as those will never change
-	localParticleVertices = new ParticleVertex[4 * maxParticles];
-	for (int i = 0; i < maxParticles * 4; i += 4)
-	{
-		localParticleVertices[i + 0].UV = XMFLOAT2(0, 0);
-		localParticleVertices[i + 1].UV = XMFLOAT2(1, 0);
-		localParticleVertices[i + 2].UV = XMFLOAT2(1, 1);
-		localParticleVertices[i + 3].UV = XMFLOAT2(0, 1);
-	}
-
-
-	// Create buffers for drawing particles
-
-	// DYNAMIC vertex buffer (no initial data necessary)
-	D3D11_BUFFER_DESC vbDesc = {};
-	vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	vbDesc.Usage = D3D11_USAGE_DYNAMIC;
-	vbDesc.ByteWidth = sizeof(ParticleVertex) * 4 * maxParticles;
-	device->CreateBuffer(&vbDesc, 0, &vertexBuffer);
-
-	// Index buffer data
-	unsigned int* indices = new unsigned int[maxParticles * 6];
-	int indexCount = 0;
-	for (int i = 0; i < maxParticles * 4; i += 4)
-	{
-		indices[indexCount++] = i;
-		indices[indexCount++] = i + 1;
-		indices[indexCount++] = i + 2;
-		indices[indexCount++] = i;
-		indices[indexCount++] = i + 2;
-		indices[indexCount++] = i + 3;
-	}
-	D3D11_SUBRESOURCE_DATA indexData = {};
-	indexData.pSysMem = indices;
-
-	// Regular index buffer
-	D3D11_BUFFER_DESC ibDesc = {};
-	ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	ibDesc.CPUAccessFlags = 0;
-	ibDesc.Usage = D3D11_USAGE_DEFAULT;
-	ibDesc.ByteWidth = sizeof(unsigned int) * maxParticles * 6;
-	device->CreateBuffer(&ibDesc, &indexData, &indexBuffer);
-
-	delete[] indices;
+	// Claim a slice of the shared pool, the ParticleSystem owns
+	// the particle data and the buffers used to draw it
+	this->particleSystem = particleSystem;
+	firstParticle = particleSystem->AddEmitter(this, maxParticles);
 }
 
 ParticleEmitter::~ParticleEmitter()
 {
-	delete[] particles;
-	delete[] localParticleVertices;
-	vertexBuffer->Release();
-	indexBuffer->Release();
+	particleSystem->RemoveEmitter(this, firstParticle, maxParticles);
 }
 
-ParticleEmitter * ParticleEmitter::Clone(ID3D11Device * device)
+ParticleEmitter * ParticleEmitter::Clone()
 {
-	return new ParticleEmitter(this->maxParticles, 
+	ParticleEmitter* clone = new ParticleEmitter(this->maxParticles, 
 		this->particlesPerSecond, 
 		this->lifetime, 
 		this->startSize, 
@@ -116,65 +80,136 @@ ParticleEmitter * ParticleEmitter::Clone(ID3D11Device * device)
 		this->startVelocity,
 		this->emitterPosition,
 		this->emitterAcceleration,
-		device,
-		this->vs,
-		this->ps,
-		this->texture,
+		this->particleSystem,
+		this->material,
 		this->emitterMaxLife);
+	clone->SetLocalSpace(localSpace);
+	clone->SetBlendMode(blendMode);
+	return clone;
 }
 
 void ParticleEmitter::Update(float dt)
+{
+	//Serial path, runs the same phases the ParticleSystem spreads across threads
+	if (BeginUpdate(dt))
+	{
+		UpdateParticles(frameTime, 0, livingParticleCount);
+		EndUpdate(frameTime);
+	}
+}
+
+bool ParticleEmitter::BeginUpdate(float dt)
 {
 	//if we have an active particle emitter, or the particle emitter is infinite, update it
-	if (this->active) {
-		this->emitterLife += dt;
-
-		if (this->emitterMaxLife != NULL && this->emitterLife >= this->emitterMaxLife)
-		{
-			active = false;
-			return;
-		}
-
-		// Update all particles - Check cyclic buffer first
-		if (firstAliveIndex < firstDeadIndex)
-		{
-			// First alive is BEFORE first dead, so the "living" particles are contiguous
-			// 
-			// 0 -------- FIRST ALIVE ----------- FIRST DEAD -------- MAX
-			// |    dead    |            alive       |         dead    |
-
-			// First alive is before first dead, so no wrapping
-			for (int i = firstAliveIndex; i < firstDeadIndex; i++)
-				UpdateSingleParticle(dt, i);
-		}
-		else
-		{
-			// First alive is AFTER first dead, so the "living" particles wrap around
-			// 
-			// 0 -------- FIRST DEAD ----------- FIRST ALIVE -------- MAX
-			// |    alive    |            dead       |         alive   |
-
-			// Update first half (from firstAlive to max particles)
-			for (int i = firstAliveIndex; i < maxParticles; i++)
-				UpdateSingleParticle(dt, i);
-
-			// Update second half (from 0 to first dead)
-			for (int i = 0; i < firstDeadIndex; i++)
-				UpdateSingleParticle(dt, i);
-		}
-
-		// Add to the time
-		timeSinceEmit += dt;
-
-		// Enough time to emit?
-		while (timeSinceEmit > secondsPerParticle)
-		{
-			SpawnParticle();
-			timeSinceEmit -= secondsPerParticle;
-		}
+	if (!this->active)
+		return false;
+
+	//Make up for any frames we slept through
+	frameTime = dt + sleepTime;
+	sleepTime = 0;
+
+	this->emitterLife += frameTime;
+
+	//Finished emitters stop spawning, then go to sleep for good once
+	//their last particles have died out
+	if (this->emitterMaxLife != 0 && this->emitterLife >= this->emitterMaxLife && livingParticleCount == 0)
+	{
+		active = false;
+		return false;
+	}
+
+	return true;
+}
+
+void ParticleEmitter::UpdateParticles(float dt, int first, int count)
+{
+	// Living particles are stored in a cyclic buffer starting at firstAliveIndex,
+	// so "first" is relative to that and wraps around the end of the array
+	// 
+	// 0 -------- FIRST DEAD ----------- FIRST ALIVE -------- MAX
+	// |    alive    |            dead       |         alive   |
+	int index = (firstAliveIndex + first) % maxParticles;
+	for (int i = 0; i < count; i++)
+	{
+		UpdateSingleParticle(dt, index);
+
+		index++;
+		if (index == maxParticles)
+			index = 0;
 	}
 }
 
+void ParticleEmitter::EndUpdate(float dt)
+{
+	// Retire anything that died this frame.  Every particle shares a lifetime
+	// and they are spawned in order, so the dead ones are always at the front
+	std::vector<float>& age = particleSystem->GetStore()->Age;
+	while (livingParticleCount > 0 && age[firstParticle + firstAliveIndex] >= lifetime)
+	{
+		firstAliveIndex++;
+		firstAliveIndex %= maxParticles;
+		livingParticleCount--;
+	}
+
+	// Done emitting?
+	if (this->emitterMaxLife != 0 && this->emitterLife >= this->emitterMaxLife)
+	{
+		prevEmitterPosition = emitterPosition;
+		return;
+	}
+
+	// The next particle is due one period after the last one went out,
+	// lower detail just stretches the period
+	float period = secondsPerParticle / detail;
+	float firstSpawn = period - timeSinceEmit;
+
+	// Add to the time
+	timeSinceEmit += dt;
+
+	// Enough time to emit?
+	int spawnCount = (int)(timeSinceEmit / period);
+	timeSinceEmit -= spawnCount * period;
+	SpawnParticles(spawnCount, dt, firstSpawn, period);
+
+	// Next frame's spawns start from here
+	prevEmitterPosition = emitterPosition;
+}
+
+int ParticleEmitter::GetLivingParticleCount()
+{
+	return livingParticleCount;
+}
+
+float ParticleEmitter::GetFrameTime()
+{
+	return frameTime;
+}
+
+void ParticleEmitter::Sleep(float dt)
+{
+	sleepTime += dt;
+}
+
+void ParticleEmitter::SetDetail(float detail)
+{
+	this->detail = detail;
+}
+
+bool ParticleEmitter::IsSleeping()
+{
+	return sleepTime > 0;
+}
+
+float ParticleEmitter::GetBoundingRadius()
+{
+	return boundingRadius;
+}
+
+XMFLOAT3 ParticleEmitter::GetEmitterPosition()
+{
+	return emitterPosition;
+}
+
 bool ParticleEmitter::IsActive()
 {
 	return active;
@@ -184,165 +219,174 @@ void ParticleEmitter::SetActive(bool active)
 {
 	this->active = active;
 	this->emitterLife = 0.0f;
+	this->sleepTime = 0.0f;
+
+	// Don't smear the first spawns from wherever we were last time
+	this->hasPosition = false;
 }
 
 void ParticleEmitter::UpdateSingleParticle(float dt, int index)
 {
+	ParticleStore* store = particleSystem->GetStore();
+	int p = firstParticle + index;
+
 	// Check for valid particle age before doing anything
-	if (particles[index].Age >= lifetime)
+	if (store->Age[p] >= lifetime)
 		return;
 
-	// Update and check for death
-	particles[index].Age += dt;
-	if (particles[index].Age >= lifetime)
-	{
-		// Recent death, so retire by moving alive count
-		firstAliveIndex++;
-		firstAliveIndex %= maxParticles;
-		livingParticleCount--;
+	// Update and check for death (retired later in EndUpdate, since
+	// this may be running on several threads at once)
+	store->Age[p] += dt;
+	if (store->Age[p] >= lifetime)
 		return;
-	}
 
 	// Calculate age percentage for lerp
-	float agePercent = particles[index].Age / lifetime;
+	float agePercent = store->Age[p] / lifetime;
 
 	// Interpolate the color
-	XMStoreFloat4(
-		&particles[index].Color,
-		XMVectorLerp(
-			XMLoadFloat4(&startColor),
-			XMLoadFloat4(&endColor),
-			agePercent));
+	store->Color[p] = XMFLOAT4(
+		startColor.x + agePercent * (endColor.x - startColor.x),
+		startColor.y + agePercent * (endColor.y - startColor.y),
+		startColor.z + agePercent * (endColor.z - startColor.z),
+		startColor.w + agePercent * (endColor.w - startColor.w));
 
 	// Lerp size
-	particles[index].Size = startSize + agePercent * (endSize - startSize);
+	store->Size[p] = startSize + agePercent * (endSize - startSize);
 
 
-	// Adjust the position
-	XMVECTOR startPos = XMLoadFloat3(&emitterPosition);
-	XMVECTOR startVel = XMLoadFloat3(&particles[index].StartVel);
-	XMVECTOR accel = XMLoadFloat3(&emitterAcceleration);
-	float t = particles[index].Age;
+	// Adjust the position, local particles are stored relative to the emitter
+	XMFLOAT3 startPos = store->StartPos[p];
+	if (localSpace)
+	{
+		startPos.x += emitterPosition.x;
+		startPos.y += emitterPosition.y;
+		startPos.z += emitterPosition.z;
+	}
+	XMFLOAT3& startVel = store->StartVel[p];
+	float t = store->Age[p];
 
 	// Use constant acceleration function
-	XMStoreFloat3(
-		&particles[index].Position,
-		accel * t * t / 2.0f + startVel * t + startPos);
+	store->Position[p] = XMFLOAT3(
+		emitterAcceleration.x * t * t / 2.0f + startVel.x * t + startPos.x,
+		emitterAcceleration.y * t * t / 2.0f + startVel.y * t + startPos.y,
+		emitterAcceleration.z * t * t / 2.0f + startVel.z * t + startPos.z);
 }
 
-void ParticleEmitter::SpawnParticle()
+void ParticleEmitter::SpawnParticles(int count, float dt, float firstSpawn, float spacing)
 {
-	// Any left to spawn?
-	if (livingParticleCount == maxParticles)
+	// Anything due so early that it would already be dead is skipped.  That's
+	// most of them after a long sleep, so work it out rather than count
+	float lastDead = (dt - lifetime - firstSpawn) / spacing;
+	int skip = 0;
+	if (lastDead >= count)
+		skip = count;
+	else if (lastDead >= 0)
+		skip = (int)lastDead + 1;
+
+	// Any room left?  Lower detail also lowers the cap
+	int cap = (int)(maxParticles * detail + 0.5f);
+	if (cap < 1) cap = 1;
+	count -= skip;
+	if (count > cap - livingParticleCount)
+		count = cap - livingParticleCount;
+	if (count <= 0)
 		return;
 
-	// Reset the first dead particle
-	particles[firstDeadIndex].Age = 0;
-	particles[firstDeadIndex].Size = startSize;
-	particles[firstDeadIndex].Color = startColor;
-	particles[firstDeadIndex].Position = emitterPosition;
-	particles[firstDeadIndex].StartVel = startVelocity;
-	particles[firstDeadIndex].StartVel.x += ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
-	particles[firstDeadIndex].StartVel.y += ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
-	particles[firstDeadIndex].StartVel.z += ((float)rand() / RAND_MAX) * 0.4f - 0.2f;
-
-	// Increment and wrap
-	firstDeadIndex++;
-	firstDeadIndex %= maxParticles;
-
-	livingParticleCount++;
-}
+	// Velocity jitter for the whole batch in one pass
+	spawnJitter.resize(count * 3);
+	random.FillFloats(&spawnJitter[0], count * 3, -0.2f, 0.2f);
 
-void ParticleEmitter::CopyParticlesToGPU(ID3D11DeviceContext * context)
-{
-	// Update local buffer (living particles only as a speed up)
+	// World space particles start wherever the emitter was at the moment they
+	// were due, local space ones just start on the emitter
+	XMFLOAT3 from = localSpace ? XMFLOAT3(0, 0, 0) : prevEmitterPosition;
+	XMFLOAT3 to = localSpace ? XMFLOAT3(0, 0, 0) : emitterPosition;
 
-	// Check cyclic buffer status
-	if (firstAliveIndex < firstDeadIndex)
+	ParticleStore* store = particleSystem->GetStore();
+	int index = firstDeadIndex;
+	for (int i = 0; i < count; i++)
 	{
-		for (int i = firstAliveIndex; i < firstDeadIndex; i++)
-			CopyOneParticle(i);
+		float spawnTime = firstSpawn + (skip + i) * spacing;
+		float age = dt - spawnTime;
+		int p = firstParticle + index;
+
+		store->Age[p] = age > 0 ? age : 0;
+		float blend = dt > 0 ? spawnTime / dt : 1.0f;
+		store->StartPos[p] = XMFLOAT3(
+			from.x + blend * (to.x - from.x),
+			from.y + blend * (to.y - from.y),
+			from.z + blend * (to.z - from.z));
+		store->StartVel[p] = startVelocity;
+		store->StartVel[p].x += spawnJitter[i * 3];
+		store->StartVel[p].y += spawnJitter[i * 3 + 1];
+		store->StartVel[p].z += spawnJitter[i * 3 + 2];
+
+		// Fill in color, size and position for the age it already has
+		UpdateSingleParticle(0, index);
+
+		// Increment and wrap
+		index++;
+		if (index == maxParticles)
+			index = 0;
 	}
-	else
-	{
-		// Update first half (from firstAlive to max particles)
-		for (int i = firstAliveIndex; i < maxParticles; i++)
-			CopyOneParticle(i);
 
-		// Update second half (from 0 to first dead)
-		for (int i = 0; i < firstDeadIndex; i++)
-			CopyOneParticle(i);
-	}
+	firstDeadIndex = index;
+	livingParticleCount += count;
+}
 
-	// All particles copied locally - send whole buffer to GPU
-	D3D11_MAPPED_SUBRESOURCE mapped = {};
-	context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+int ParticleEmitter::CopyParticles(ParticleVertex* vertices)
+{
+	// Living particles are unwrapped from the cyclic array on the way
+	// out, so they always land as one contiguous run
+	int index = firstAliveIndex;
+	for (int i = 0; i < livingParticleCount; i++)
+	{
+		CopyOneParticle(index, &vertices[i]);
 
-	memcpy(mapped.pData, localParticleVertices, sizeof(ParticleVertex) * 4 * maxParticles);
+		index++;
+		if (index == maxParticles)
+			index = 0;
+	}
 
-	context->Unmap(vertexBuffer, 0);
+	return livingParticleCount;
 }
 
-void ParticleEmitter::CopyOneParticle(int index)
+void ParticleEmitter::CopyOneParticle(int index, ParticleVertex* vertex)
 {
-	int i = index * 4;
-
-	localParticleVertices[i + 0].Position = particles[index].Position;
-	localParticleVertices[i + 1].Position = particles[index].Position;
-	localParticleVertices[i + 2].Position = particles[index].Position;
-	localParticleVertices[i + 3].Position = particles[index].Position;
-
-	localParticleVertices[i + 0].Size = particles[index].Size;
-	localParticleVertices[i + 1].Size = particles[index].Size;
-	localParticleVertices[i + 2].Size = particles[index].Size;
-	localParticleVertices[i + 3].Size = particles[index].Size;
-
-	localParticleVertices[i + 0].Color = particles[index].Color;
-	localParticleVertices[i + 1].Color = particles[index].Color;
-	localParticleVertices[i + 2].Color = particles[index].Color;
-	localParticleVertices[i + 3].Color = particles[index].Color;
+	ParticleStore* store = particleSystem->GetStore();
+	int p = firstParticle + index;
+	vertex->Position = store->Position[p];
+	vertex->Size = store->Size[p];
+	vertex->Color = store->Color[p];
 }
 
-void ParticleEmitter::Draw(ID3D11DeviceContext * context, Camera * camera)
+void ParticleEmitter::SetEmitterPosition(XMFLOAT3 pos)
 {
-	if (!this->active)
-	{
-		return;
-	}
-	// Copy to dynamic buffer
-	CopyParticlesToGPU(context);
-
-	// Set up buffers
-	UINT stride = sizeof(ParticleVertex);
-	UINT offset = 0;
-	context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-	context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-
-	vs->SetMatrix4x4("view", camera->GetView());
-	vs->SetMatrix4x4("projection", camera->GetProj());
-	vs->SetShader();
-	vs->CopyAllBufferData();
-
-	ps->SetShaderResourceView("particle", texture);
-	ps->SetShader();
-	ps->CopyAllBufferData();
-
-	// Draw the correct parts of the buffer
-	if (firstAliveIndex < firstDeadIndex)
+	emitterPosition = pos;
+
+	// First position since (re)activation, nothing to interpolate from
+	if (!hasPosition)
 	{
-		context->DrawIndexed(livingParticleCount * 6, firstAliveIndex * 6, 0);
+		prevEmitterPosition = pos;
+		hasPosition = true;
 	}
-	else
-	{
-		// Draw first half (0 -> dead)
-		context->DrawIndexed(firstDeadIndex * 6, 0, 0);
+}
 
-		// Draw second half (alive -> max)
-		context->DrawIndexed((maxParticles - firstAliveIndex) * 6, firstAliveIndex * 6, 0);
-	}
+void ParticleEmitter::SetLocalSpace(bool localSpace)
+{
+	this->localSpace = localSpace;
 }
 
-void ParticleEmitter::SetEmitterPosition(XMFLOAT3 pos)
+int ParticleEmitter::GetMaterial()
 {
-	emitterPosition = pos;
+	return material;
+}
+
+void ParticleEmitter::SetBlendMode(ParticleBlendMode blendMode)
+{
+	this->blendMode = blendMode;
+}
+
+ParticleBlendMode ParticleEmitter::GetBlendMode()
+{
+	return blendMode;
 }
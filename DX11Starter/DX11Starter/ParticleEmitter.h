@@ -1,27 +1,27 @@
 #pragma once
 
-#include <d3d11.h>
-#include <DirectXMath.h>
-
-#include "Camera.h"
-#include "SimpleShader.h"
+#include <vector>
+#include "Portable.h"
+#include "ParticleStore.h"
+#include "Random.h"
 using namespace DirectX;
 
-struct Particle
+class ParticleSystem;
+
+//How an emitter's particles get blended.  Alpha blended ones only
+//look right when the particle system is sorting
+enum ParticleBlendMode
 {
-	XMFLOAT3 Position;
-	XMFLOAT4 Color;
-	XMFLOAT3 StartVel;
-	float Size; 
-	float Age;
+	PARTICLE_BLEND_ADDITIVE,
+	PARTICLE_BLEND_ALPHA
 };
 
+//One per particle, the vertex shader builds the quad from SV_VertexID
 struct ParticleVertex
 {
 	XMFLOAT3 Position;
-	XMFLOAT2 UV;
-	XMFLOAT4 Color;
 	float Size;
+	XMFLOAT4 Color;
 };
 
 class ParticleEmitter
@@ -38,29 +38,63 @@ public:
 		XMFLOAT3 startVelocity,
 		XMFLOAT3 emitterPosition,
 		XMFLOAT3 emitterAcceleration,
-		ID3D11Device* device,
-		SimpleVertexShader* vs,
-		SimplePixelShader* ps,
-		ID3D11ShaderResourceView* texture,
+		ParticleSystem* particleSystem,
+		int material,
 		float emitterMaxLife);
 	~ParticleEmitter();
 
 	//Copy constructor, sort of
-	ParticleEmitter* Clone(ID3D11Device* device);
+	ParticleEmitter* Clone();
 
 	void Update(float dt);
 
+	//Update split into phases so the particle work can be spread across threads
+	//BeginUpdate must run on one thread, UpdateParticles may run anywhere and
+	//EndUpdate may run on any thread as long as nothing else touches this emitter.
+	//The later phases take GetFrameTime(), which includes any time spent asleep
+	bool BeginUpdate(float dt);
+	void UpdateParticles(float dt, int first, int count);
+	void EndUpdate(float dt);
+	int GetLivingParticleCount();
+	float GetFrameTime();
+
+	//Skips a frame but remembers the time, so the next update catches up and
+	//the effect looks like it kept running the whole time
+	void Sleep(float dt);
+	bool IsSleeping();
+
+	//Scales spawn rate and particle cap, 1 = full detail
+	void SetDetail(float detail);
+
+	//Roughly how far particles can get from the emitter
+	float GetBoundingRadius();
+	XMFLOAT3 GetEmitterPosition();
+
 	bool IsActive();
 	void SetActive(bool active);
 
 	void UpdateSingleParticle(float dt, int index);
-	void SpawnParticle();
 
-	void CopyParticlesToGPU(ID3D11DeviceContext* context);
-	void CopyOneParticle(int index);
-	void Draw(ID3D11DeviceContext* context, Camera* camera);
+	//Writes count particles as one block after the last live one.  They were due
+	//at firstSpawn, firstSpawn + spacing, ... seconds into a frame
+	//of length dt, so each gets the age and emitter position it would have had
+	void SpawnParticles(int count, float dt, float firstSpawn, float spacing);
+
+	//Writes the living particles out in order, returns how many were written
+	int CopyParticles(ParticleVertex* vertices);
+	void CopyOneParticle(int index, ParticleVertex* vertex);
 	void SetEmitterPosition(XMFLOAT3 pos);
 
+	//Local space particles move with the emitter instead of being left behind
+	void SetLocalSpace(bool localSpace);
+
+	void SetBlendMode(ParticleBlendMode blendMode);
+	ParticleBlendMode GetBlendMode();
+
+	//Handle from the ParticleRenderer for its shaders and texture.
+	//Emitters with the same one get drawn together
+	int GetMaterial();
+
 private:
 	// Emission properties
 	int particlesPerSecond;
@@ -73,27 +107,38 @@ private:
 	float emitterLife;
 	bool active;
 
+	// Sleeping and level of detail
+	float frameTime;
+	float sleepTime;
+	float detail;
+	float boundingRadius;
+
 	DirectX::XMFLOAT3 emitterAcceleration;
 	DirectX::XMFLOAT3 emitterPosition;
+	DirectX::XMFLOAT3 prevEmitterPosition;
+	bool hasPosition;
+	bool localSpace;
 	DirectX::XMFLOAT3 startVelocity;
 	DirectX::XMFLOAT4 startColor;
 	DirectX::XMFLOAT4 endColor;
 	float startSize;
 	float endSize;
 
-	// Particle array
-	Particle* particles;
+	// Own generator so emitters can spawn on any thread,
+	// and scratch space for a frame's worth of velocity jitter
+	Random random;
+	std::vector<float> spawnJitter;
+
+	// Our slice of the shared particle store, the ring
+	// buffer indices below are relative to firstParticle
+	ParticleSystem* particleSystem;
+	int firstParticle;
 	int maxParticles;
 	int firstDeadIndex;
 	int firstAliveIndex;
 
 	// Rendering
-	ParticleVertex* localParticleVertices;
-	ID3D11Buffer* vertexBuffer;
-	ID3D11Buffer* indexBuffer;
-
-	ID3D11ShaderResourceView* texture;
-	SimpleVertexShader* vs;
-	SimplePixelShader* ps;
+	ParticleBlendMode blendMode;
+	int material;
 };
 
@@ -0,0 +1,221 @@
+#include "ParticleRenderer.h"
+#include "Profiler.h"
+#include <chrono>
+
+ParticleRenderer::ParticleRenderer(JobSystem* jobSystem, ID3D11Device* device)
+{
+	this->jobSystem = jobSystem;
+
+	resources = new ParticleResourceCache(device);
+	lastDrawCalls = 0;
+
+	sorter = new RadixSorter(jobSystem);
+	sorting = false;
+
+	ResetTimings();
+}
+
+ParticleRenderer::~ParticleRenderer()
+{
+	delete sorter;
+	delete resources;
+}
+
+int ParticleRenderer::AddMaterial(SimpleVertexShader* vs, SimplePixelShader* ps, ID3D11ShaderResourceView* texture)
+{
+	ParticleMaterial material;
+	material.vs = vs;
+	material.ps = ps;
+	material.texture = texture;
+	materials.push_back(material);
+	return (int)materials.size() - 1;
+}
+
+int ParticleRenderer::Upload(ID3D11DeviceContext* context, Camera* camera, ParticleSystem* particleSystem)
+{
+	PROFILE_SCOPE("Particle upload");
+	lastDrawCalls = 0;
+
+	BuildBatches(particleSystem);
+	if (batches.empty())
+		return 0;
+
+	//Only the live particles are uploaded, so that's all the buffer needs to hold
+	int total = 0;
+	for (size_t b = 0; b < batches.size(); b++)
+		total += batches[b].count;
+	resources->Reserve(total);
+	ID3D11Buffer* particleBuffer = resources->GetParticleBuffer();
+
+	//One upload for everything, each batch ends up as a contiguous run
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	context->Map(particleBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+
+	ParticleVertex* vertices = (ParticleVertex*)mapped.pData;
+	int written = 0;
+	for (size_t b = 0; b < batches.size(); b++)
+	{
+		batches[b].first = written;
+		if (sorting)
+		{
+			WriteSorted((int)b, camera, &vertices[written]);
+			written += batches[b].count;
+			continue;
+		}
+
+		for (size_t i = 0; i < visible.size(); i++)
+		{
+			if (batchOf[i] == (int)b)
+				written += visible[i]->CopyParticles(&vertices[written]);
+		}
+	}
+
+	context->Unmap(particleBuffer, 0);
+
+	return sizeof(ParticleVertex) * written;
+}
+
+void ParticleRenderer::Draw(ID3D11DeviceContext* context, ParticleBlendMode blendMode)
+{
+	if (batches.empty())
+		return;
+
+	//Particle data comes from the structured buffer, so only indices are needed
+	context->IASetIndexBuffer(resources->GetQuadIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
+
+	for (size_t b = 0; b < batches.size(); b++)
+	{
+		if (batches[b].blendMode != blendMode)
+			continue;
+
+		const ParticleMaterial& material = materials[batches[b].material];
+		SimpleVertexShader* vs = material.vs;
+		SimplePixelShader* ps = material.ps;
+
+		//View and projection come from the shared per frame buffer
+		vs->SetShaderResourceView("particles", resources->GetParticleSRV());
+		vs->SetShader();
+		vs->CopyAllBufferData();
+
+		ps->SetShaderResourceView("particle", material.texture);
+		ps->SetShader();
+		ps->CopyAllBufferData();
+
+		//The quad indices for particle n start at 6n and point at vertex ids 4n..4n+3
+		context->DrawIndexed(batches[b].count * 6, batches[b].first * 6, 0);
+		lastDrawCalls++;
+	}
+}
+
+//Writes a batch out farthest particle first
+void ParticleRenderer::WriteSorted(int batch, Camera* camera, ParticleVertex* vertices)
+{
+	int count = batches[batch].count;
+
+	//Gather the batch, since it can be spread over several emitters
+	sortVertices.resize(count);
+	int gathered = 0;
+	for (size_t i = 0; i < visible.size(); i++)
+	{
+		if (batchOf[i] == batch)
+			gathered += visible[i]->CopyParticles(&sortVertices[gathered]);
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	//View space depth is the third column of the view matrix, which is
+	//the third row here since the camera stores it transposed
+	XMFLOAT4X4 view = camera->GetView();
+	sortKeys.resize(count);
+	sortValues.resize(count);
+	unsigned int jobCount = (unsigned int)((count + particlesPerJob - 1) / particlesPerJob);
+	jobSystem->ParallelFor(jobCount, [&](unsigned int job)
+	{
+		int end = (int)(job + 1) * particlesPerJob;
+		if (end > count) end = count;
+		for (int i = job * particlesPerJob; i < end; i++)
+		{
+			XMFLOAT3& p = sortVertices[i].Position;
+			float depth = view._31 * p.x + view._32 * p.y + view._33 * p.z + view._34;
+
+			//Flipped so the farthest particle has the smallest key
+			sortKeys[i] = ~RadixSorter::FloatToKey(depth);
+			sortValues[i] = i;
+		}
+	});
+
+	sorter->Sort(&sortKeys[0], &sortValues[0], count);
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	totalSortTime += elapsed.count();
+	totalSorted += count;
+
+	for (int i = 0; i < count; i++)
+	{
+		vertices[i] = sortVertices[sortValues[i]];
+	}
+}
+
+int ParticleRenderer::GetLastDrawCalls()
+{
+	return lastDrawCalls;
+}
+
+int ParticleRenderer::GetGpuBytes()
+{
+	return resources->GetGpuBytes();
+}
+
+void ParticleRenderer::SetSorting(bool sorting)
+{
+	this->sorting = sorting;
+}
+
+bool ParticleRenderer::IsSorting()
+{
+	return sorting;
+}
+
+float ParticleRenderer::GetAverageSortRate()
+{
+	return totalSortTime > 0.0 ? (float)(totalSorted / totalSortTime) : 0.0f;
+}
+
+void ParticleRenderer::ResetTimings()
+{
+	totalSortTime = 0.0;
+	totalSorted = 0;
+}
+
+//Groups the active emitters with something to draw by material and blend mode
+void ParticleRenderer::BuildBatches(ParticleSystem* particleSystem)
+{
+	batches.clear();
+	batchOf.clear();
+	visible.clear();
+
+	const std::vector<ParticleEmitter*>& emitters = particleSystem->GetEmitters();
+	for (size_t i = 0; i < emitters.size(); i++)
+	{
+		ParticleEmitter* e = emitters[i];
+		if (!e->IsActive() || e->IsSleeping() || e->GetLivingParticleCount() == 0)
+			continue;
+
+		size_t b = 0;
+		while (b < batches.size() &&
+			(batches[b].material != e->GetMaterial() || batches[b].blendMode != e->GetBlendMode()))
+			b++;
+
+		if (b == batches.size())
+		{
+			ParticleBatch batch = {};
+			batch.material = e->GetMaterial();
+			batch.blendMode = e->GetBlendMode();
+			batches.push_back(batch);
+		}
+		batches[b].count += e->GetLivingParticleCount();
+
+		visible.push_back(e);
+		batchOf.push_back((int)b);
+	}
+}
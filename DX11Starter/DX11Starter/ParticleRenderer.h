@@ -0,0 +1,92 @@
+#pragma once
+
+#include <d3d11.h>
+#include <vector>
+#include "Camera.h"
+#include "JobSystem.h"
+#include "SimpleShader.h"
+#include "ParticleEmitter.h"
+#include "ParticleSystem.h"
+#include "ParticleResourceCache.h"
+#include "RadixSorter.h"
+
+// --------------------------------------------------------
+// Draws every emitter in a ParticleSystem.  All of them share
+// one GPU buffer, so drawing is a single upload and one draw per
+// material/blend.  Emitters only hold a material handle, handed
+// out here, so the particle system itself never sees a shader.
+//
+// With sorting on, each batch is written out back to front using
+// view depth keys and a parallel radix sort, which alpha blended
+// emitters need to draw correctly.
+// --------------------------------------------------------
+class ParticleRenderer
+{
+public:
+	ParticleRenderer(JobSystem* jobSystem, ID3D11Device* device);
+	~ParticleRenderer();
+
+	//Returns the handle emitters drawn with these use
+	int AddMaterial(SimpleVertexShader* vs, SimplePixelShader* ps, ID3D11ShaderResourceView* texture);
+
+	//Writes the live particles of every active emitter to the GPU once a
+	//frame, returns the bytes uploaded
+	int Upload(ID3D11DeviceContext* context, Camera* camera, ParticleSystem* particleSystem);
+
+	//Draws the emitters using a blend mode, with the matching blend state
+	//already set.  Upload has to be called first
+	void Draw(ID3D11DeviceContext* context, ParticleBlendMode blendMode);
+	int GetLastDrawCalls();
+
+	//Whatever the resource cache has grown to so far
+	int GetGpuBytes();
+
+	void SetSorting(bool sorting);
+	bool IsSorting();
+
+	//Particles per millisecond, averaged since the last reset
+	float GetAverageSortRate();
+	void ResetTimings();
+
+private:
+	struct ParticleMaterial
+	{
+		SimpleVertexShader* vs;
+		SimplePixelShader* ps;
+		ID3D11ShaderResourceView* texture;
+	};
+
+	//Emitters that share a material and blend mode
+	struct ParticleBatch
+	{
+		int material;
+		ParticleBlendMode blendMode;
+		int first;
+		int count;
+	};
+
+	JobSystem* jobSystem;
+	std::vector<ParticleMaterial> materials;
+
+	//Shared GPU buffers
+	ParticleResourceCache* resources;
+	std::vector<ParticleBatch> batches;
+	std::vector<int> batchOf;
+	std::vector<ParticleEmitter*> visible;
+	int lastDrawCalls;
+
+	//Sorting
+	RadixSorter* sorter;
+	bool sorting;
+	std::vector<ParticleVertex> sortVertices;
+	std::vector<unsigned int> sortKeys;
+	std::vector<unsigned int> sortValues;
+	double totalSortTime;
+	long long totalSorted;
+
+	//Same job size as the particle update
+	const int particlesPerJob = 256;
+
+	void BuildBatches(ParticleSystem* particleSystem);
+	void WriteSorted(int batch, Camera* camera, ParticleVertex* vertices);
+};
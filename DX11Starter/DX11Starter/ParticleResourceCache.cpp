@@ -0,0 +1,114 @@
+#include "ParticleResourceCache.h"
+
+ParticleResourceCache::ParticleResourceCache(ID3D11Device* device)
+{
+	this->device = device;
+	quadIndexBuffer = nullptr;
+	particleBuffer = nullptr;
+	particleSRV = nullptr;
+	capacity = 0;
+}
+
+ParticleResourceCache::~ParticleResourceCache()
+{
+	Release();
+}
+
+void ParticleResourceCache::Reserve(int particleCount)
+{
+	if (particleCount <= capacity)
+		return;
+
+	int newCapacity = capacity > minCapacity ? capacity : minCapacity;
+	while (newCapacity < particleCount)
+		newCapacity *= 2;
+
+	Release();
+	capacity = newCapacity;
+	CreateQuadIndexBuffer();
+	CreateParticleBuffer();
+}
+
+ID3D11Buffer* ParticleResourceCache::GetQuadIndexBuffer()
+{
+	return quadIndexBuffer;
+}
+
+ID3D11Buffer* ParticleResourceCache::GetParticleBuffer()
+{
+	return particleBuffer;
+}
+
+ID3D11ShaderResourceView* ParticleResourceCache::GetParticleSRV()
+{
+	return particleSRV;
+}
+
+int ParticleResourceCache::GetCapacity()
+{
+	return capacity;
+}
+
+int ParticleResourceCache::GetGpuBytes()
+{
+	return capacity * (int)(sizeof(ParticleVertex) + sizeof(unsigned int) * 6);
+}
+
+void ParticleResourceCache::CreateQuadIndexBuffer()
+{
+	// Index buffer data, two triangles per particle
+	unsigned int* indices = new unsigned int[capacity * 6];
+	int indexCount = 0;
+	for (int i = 0; i < capacity * 4; i += 4)
+	{
+		indices[indexCount++] = i;
+		indices[indexCount++] = i + 1;
+		indices[indexCount++] = i + 2;
+		indices[indexCount++] = i;
+		indices[indexCount++] = i + 2;
+		indices[indexCount++] = i + 3;
+	}
+	D3D11_SUBRESOURCE_DATA indexData = {};
+	indexData.pSysMem = indices;
+
+	// Regular index buffer
+	D3D11_BUFFER_DESC ibDesc = {};
+	ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	ibDesc.CPUAccessFlags = 0;
+	ibDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	ibDesc.ByteWidth = sizeof(unsigned int) * capacity * 6;
+	device->CreateBuffer(&ibDesc, &indexData, &quadIndexBuffer);
+
+	delete[] indices;
+}
+
+void ParticleResourceCache::CreateParticleBuffer()
+{
+	// DYNAMIC structured buffer, one element per particle
+	D3D11_BUFFER_DESC pbDesc = {};
+	pbDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	pbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	pbDesc.Usage = D3D11_USAGE_DYNAMIC;
+	pbDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	pbDesc.StructureByteStride = sizeof(ParticleVertex);
+	pbDesc.ByteWidth = sizeof(ParticleVertex) * capacity;
+	device->CreateBuffer(&pbDesc, 0, &particleBuffer);
+
+	// The vertex shader reads it through an SRV
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = capacity;
+	device->CreateShaderResourceView(particleBuffer, &srvDesc, &particleSRV);
+}
+
+void ParticleResourceCache::Release()
+{
+	if (particleSRV) particleSRV->Release();
+	if (particleBuffer) particleBuffer->Release();
+	if (quadIndexBuffer) quadIndexBuffer->Release();
+	particleSRV = nullptr;
+	particleBuffer = nullptr;
+	quadIndexBuffer = nullptr;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <d3d11.h>
+#include "ParticleEmitter.h"
+
+// --------------------------------------------------------
+// GPU resources shared by every particle emitter: the quad
+// index buffer (same two triangles per particle, so it only
+// ever needs growing) and the dynamic buffer the live particles
+// are uploaded to.  Both grow by doubling the first time they
+// are asked for more than they hold, never at emitter creation.
+// --------------------------------------------------------
+class ParticleResourceCache
+{
+public:
+	ParticleResourceCache(ID3D11Device* device);
+	~ParticleResourceCache();
+
+	//Makes sure the buffers below hold at least particleCount particles.
+	//May recreate them, so get the pointers afterwards
+	void Reserve(int particleCount);
+
+	ID3D11Buffer* GetQuadIndexBuffer();
+	ID3D11Buffer* GetParticleBuffer();
+	ID3D11ShaderResourceView* GetParticleSRV();
+
+	int GetCapacity();
+	int GetGpuBytes();
+
+private:
+	ID3D11Device* device;
+
+	ID3D11Buffer* quadIndexBuffer;
+	ID3D11Buffer* particleBuffer;
+	ID3D11ShaderResourceView* particleSRV;
+	int capacity;
+
+	//Smallest allocation, so a handful of emitters don't cause several resizes
+	const int minCapacity = 1024;
+
+	void CreateQuadIndexBuffer();
+	void CreateParticleBuffer();
+	void Release();
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+#include "Portable.h"
+
+// --------------------------------------------------------
+// Particle data for every emitter in the game, stored as one
+// array per attribute.  Emitters are handed a fixed range of
+// it by the ParticleSystem and keep their ring buffer inside.
+// --------------------------------------------------------
+struct ParticleStore
+{
+	std::vector<DirectX::XMFLOAT3> Position;
+	std::vector<DirectX::XMFLOAT3> StartPos;
+	std::vector<DirectX::XMFLOAT3> StartVel;
+	std::vector<DirectX::XMFLOAT4> Color;
+	std::vector<float> Size;
+	std::vector<float> Age;
+};
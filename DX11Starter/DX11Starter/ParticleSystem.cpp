@@ -0,0 +1,288 @@
+#include "ParticleSystem.h"
+#include <math.h>
+#include <chrono>
+
+ParticleSystem::ParticleSystem(JobSystem* jobSystem)
+{
+	this->jobSystem = jobSystem;
+	capacity = 0;
+
+	culler = new FrustumCuller(jobSystem);
+
+	lodNear = 15.0f;
+	lodFar = 80.0f;
+	lodMinDetail = 0.25f;
+	activeEmitters = 0;
+	sleepingEmitters = 0;
+	culledEmitters = 0;
+
+	ResetTimings();
+}
+
+ParticleSystem::~ParticleSystem()
+{
+	delete culler;
+}
+
+int ParticleSystem::AddEmitter(ParticleEmitter* emitter, int count)
+{
+	emitters.push_back(emitter);
+
+	//First fit from anything handed back earlier
+	for (size_t i = 0; i < freeRanges.size(); i++)
+	{
+		if (freeRanges[i].count < count)
+			continue;
+
+		int first = freeRanges[i].first;
+		freeRanges[i].first += count;
+		freeRanges[i].count -= count;
+		if (freeRanges[i].count == 0)
+			freeRanges.erase(freeRanges.begin() + i);
+		return first;
+	}
+
+	//Nothing big enough, so grow the pool.  Emitters only hold on to
+	//indices, so it's fine for the arrays to move
+	int first = capacity;
+	capacity += count;
+	store.Position.resize(capacity);
+	store.StartPos.resize(capacity);
+	store.StartVel.resize(capacity);
+	store.Color.resize(capacity);
+	store.Size.resize(capacity);
+	store.Age.resize(capacity);
+	return first;
+}
+
+void ParticleSystem::RemoveEmitter(ParticleEmitter* emitter, int first, int count)
+{
+	for (size_t i = 0; i < emitters.size(); i++)
+	{
+		if (emitters[i] == emitter)
+		{
+			emitters.erase(emitters.begin() + i);
+			break;
+		}
+	}
+
+	//Keep the free list sorted so neighbours can be merged back together
+	size_t i = 0;
+	while (i < freeRanges.size() && freeRanges[i].first < first)
+		i++;
+
+	PoolRange range;
+	range.first = first;
+	range.count = count;
+	freeRanges.insert(freeRanges.begin() + i, range);
+
+	if (i + 1 < freeRanges.size() && freeRanges[i].first + freeRanges[i].count == freeRanges[i + 1].first)
+	{
+		freeRanges[i].count += freeRanges[i + 1].count;
+		freeRanges.erase(freeRanges.begin() + i + 1);
+	}
+	if (i > 0 && freeRanges[i - 1].first + freeRanges[i - 1].count == freeRanges[i].first)
+	{
+		freeRanges[i - 1].count += freeRanges[i].count;
+		freeRanges.erase(freeRanges.begin() + i);
+	}
+}
+
+ParticleStore* ParticleSystem::GetStore()
+{
+	return &store;
+}
+
+int ParticleSystem::GetEmitterCount()
+{
+	return (int)emitters.size();
+}
+
+int ParticleSystem::GetPoolBytes()
+{
+	return capacity * (int)(sizeof(XMFLOAT3) * 3 + sizeof(XMFLOAT4) + sizeof(float) * 2);
+}
+
+void ParticleSystem::Queue(ParticleEmitter* emitter)
+{
+	queued.push_back(emitter);
+}
+
+void ParticleSystem::Update(float dt, Camera* camera)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	XMFLOAT4 planes[6];
+	camera->GetFrustumPlanes(planes);
+	XMFLOAT3 eye = camera->GetCamPosition();
+
+	//Emitter level bookkeeping (culling, life time, deactivation) happens here on one thread
+	activeEmitters = 0;
+	sleepingEmitters = 0;
+	culledEmitters = 0;
+	updating.clear();
+	awake.clear();
+	culler->Clear();
+	for (size_t i = 0; i < queued.size(); i++)
+	{
+		ParticleEmitter* e = queued[i];
+		if (!e->IsActive())
+		{
+			sleepingEmitters++;
+			continue;
+		}
+		awake.push_back(e);
+		culler->Add(e->GetEmitterPosition(), e->GetBoundingRadius());
+	}
+	culler->Cull(planes);
+
+	for (size_t i = 0; i < awake.size(); i++)
+	{
+		ParticleEmitter* e = awake[i];
+
+		//Nothing to see, so hold on to the time and catch up later
+		if (!culler->IsVisible((int)i))
+		{
+			e->Sleep(dt);
+			culledEmitters++;
+			continue;
+		}
+
+		//Thin out far away effects
+		XMFLOAT3 center = e->GetEmitterPosition();
+		float dx = center.x - eye.x;
+		float dy = center.y - eye.y;
+		float dz = center.z - eye.z;
+		float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+		float t = (distance - lodNear) / (lodFar - lodNear);
+		if (t < 0) t = 0;
+		if (t > 1) t = 1;
+		e->SetDetail(1.0f + t * (lodMinDetail - 1.0f));
+
+		if (e->BeginUpdate(dt))
+		{
+			updating.push_back(e);
+			activeEmitters++;
+		}
+		else sleepingEmitters++;
+	}
+	queued.clear();
+
+	//Every particle is independent, so these can go wide
+	BuildJobs();
+	jobSystem->ParallelFor((unsigned int)(jobStarts.size() - 1), [&](unsigned int job)
+	{
+		for (size_t r = jobStarts[job]; r < jobStarts[job + 1]; r++)
+		{
+			ParticleEmitter* e = ranges[r].emitter;
+			e->UpdateParticles(e->GetFrameTime(), ranges[r].first, ranges[r].count);
+		}
+	});
+
+	int particleCount = 0;
+	for (size_t i = 0; i < updating.size(); i++)
+	{
+		particleCount += updating[i]->GetLivingParticleCount();
+	}
+
+	//Retiring and spawning only touch the emitter's own ring buffer and
+	//generator, so emitters can finish up independently of each other
+	jobSystem->ParallelFor((unsigned int)updating.size(), [&](unsigned int i)
+	{
+		updating[i]->EndUpdate(updating[i]->GetFrameTime());
+	});
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	totalUpdateTime += elapsed.count();
+	totalParticles += particleCount;
+	timedFrames++;
+}
+
+//Cuts the live particles of every updating emitter into jobs of roughly particlesPerJob
+void ParticleSystem::BuildJobs()
+{
+	ranges.clear();
+	jobStarts.clear();
+	jobStarts.push_back(0);
+
+	int budget = particlesPerJob;
+	for (size_t i = 0; i < updating.size(); i++)
+	{
+		int remaining = updating[i]->GetLivingParticleCount();
+		int first = 0;
+		while (remaining > 0)
+		{
+			int count = remaining < budget ? remaining : budget;
+
+			ParticleRange range;
+			range.emitter = updating[i];
+			range.first = first;
+			range.count = count;
+			ranges.push_back(range);
+
+			first += count;
+			remaining -= count;
+			budget -= count;
+
+			//Job is full, start the next one
+			if (budget == 0)
+			{
+				jobStarts.push_back(ranges.size());
+				budget = particlesPerJob;
+			}
+		}
+	}
+
+	//Close off the last partially filled job
+	if (jobStarts.back() != ranges.size())
+		jobStarts.push_back(ranges.size());
+}
+
+void ParticleSystem::SetLodDistances(float nearDistance, float farDistance, float minDetail)
+{
+	lodNear = nearDistance;
+	lodFar = farDistance;
+	lodMinDetail = minDetail;
+}
+
+int ParticleSystem::GetActiveEmitterCount()
+{
+	return activeEmitters;
+}
+
+int ParticleSystem::GetSleepingEmitterCount()
+{
+	return sleepingEmitters;
+}
+
+int ParticleSystem::GetCulledEmitterCount()
+{
+	return culledEmitters;
+}
+
+float ParticleSystem::GetAverageUpdateTime()
+{
+	return timedFrames > 0 ? (float)(totalUpdateTime / timedFrames) : 0.0f;
+}
+
+int ParticleSystem::GetAverageParticleCount()
+{
+	return timedFrames > 0 ? (int)(totalParticles / timedFrames) : 0;
+}
+
+void ParticleSystem::ResetTimings()
+{
+	totalUpdateTime = 0.0;
+	totalParticles = 0;
+	timedFrames = 0;
+}
+
+JobSystem* ParticleSystem::GetJobSystem()
+{
+	return jobSystem;
+}
+
+const std::vector<ParticleEmitter*>& ParticleSystem::GetEmitters()
+{
+	return emitters;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <vector>
+#include "Camera.h"
+#include "JobSystem.h"
+#include "ParticleEmitter.h"
+#include "ParticleStore.h"
+#include "FrustumCuller.h"
+
+// --------------------------------------------------------
+// Owns every particle in the game.  Emitters are handed a range
+// of one shared store, which the ParticleRenderer uploads from.
+//
+// Also gathers every emitter that needs simulating this frame and
+// updates them together.  Emitters outside the view are put to sleep
+// (and catch up when they come back), and far away ones are run at
+// a lower spawn rate.  Live particles from all emitters are
+// cut into evenly sized jobs (big emitters get split, small ones
+// share a job) and run on the job system.
+// --------------------------------------------------------
+class ParticleSystem
+{
+public:
+	ParticleSystem(JobSystem* jobSystem);
+	~ParticleSystem();
+
+	//Emitters register themselves on creation, returns the start of their range
+	int AddEmitter(ParticleEmitter* emitter, int count);
+	void RemoveEmitter(ParticleEmitter* emitter, int first, int count);
+	ParticleStore* GetStore();
+
+	//Every emitter, in the order they were made
+	const std::vector<ParticleEmitter*>& GetEmitters();
+
+	//Memory use of the whole pool
+	int GetEmitterCount();
+	int GetPoolBytes();
+
+	//Adds an emitter to this frame's update
+	void Queue(ParticleEmitter* emitter);
+
+	//Updates everything queued this frame, then clears the queue
+	void Update(float dt, Camera* camera);
+
+	//Detail falls off linearly from 1 at nearDistance to minDetail at farDistance
+	void SetLodDistances(float nearDistance, float farDistance, float minDetail);
+
+	//What happened to the emitters queued last frame.  Finished or
+	//deactivated ones are sleeping, ones outside the view are culled
+	int GetActiveEmitterCount();
+	int GetSleepingEmitterCount();
+	int GetCulledEmitterCount();
+
+	//Timing stats, averaged since the last reset
+	float GetAverageUpdateTime();
+	int GetAverageParticleCount();
+	void ResetTimings();
+
+	JobSystem* GetJobSystem();
+
+private:
+	//A run of live particles from a single emitter
+	struct ParticleRange
+	{
+		ParticleEmitter* emitter;
+		int first;
+		int count;
+	};
+
+	//A free run of the shared store
+	struct PoolRange
+	{
+		int first;
+		int count;
+	};
+
+	JobSystem* jobSystem;
+
+	//Shared pool
+	ParticleStore store;
+	int capacity;
+	std::vector<PoolRange> freeRanges;
+	std::vector<ParticleEmitter*> emitters;
+
+	std::vector<ParticleEmitter*> queued;
+	std::vector<ParticleEmitter*> updating;
+
+	//Culling and level of detail
+	FrustumCuller* culler;
+	std::vector<ParticleEmitter*> awake;
+	float lodNear;
+	float lodFar;
+	float lodMinDetail;
+	int activeEmitters;
+	int sleepingEmitters;
+	int culledEmitters;
+	std::vector<ParticleRange> ranges;
+	std::vector<size_t> jobStarts;
+
+	//Target amount of particles in each job
+	const int particlesPerJob = 256;
+
+	//Timing
+	double totalUpdateTime;
+	long long totalParticles;
+	int timedFrames;
+
+	void BuildJobs();
+};
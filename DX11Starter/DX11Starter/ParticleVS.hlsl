@@ -1,20 +1,22 @@
 
 // Constant buffer for C++ data being passed in
-cbuffer externalData : register(b0)
+// Changes once a frame, shared by every shader (FrameConstantData in C++)
+cbuffer perFrame : register(b1)
 {
-    matrix view;
-    matrix projection;
+	matrix view;
+	matrix projection;
 };
 
-// Describes individual vertex data
-struct VertexShaderInput
+// One entry per live particle (matches ParticleVertex in C++)
+struct Particle
 {
-    float3 position		: POSITION;
-    float2 uv			: TEXCOORD;
-    float4 color		: COLOR;
-	float size			: SIZE;
+	float3 position;
+	float size;
+	float4 color;
 };
 
+StructuredBuffer<Particle> particles : register(t0);
+
 // Defines the output data of our vertex shader
 struct VertexToPixel
 {
@@ -24,24 +26,31 @@ struct VertexToPixel
 };
 
 // The entry point for our vertex shader
-VertexToPixel main(VertexShaderInput input)
+// - No vertex buffer, each particle is expanded into a
+//   quad of four vertices using the vertex id
+VertexToPixel main(uint id : SV_VertexID)
 {
     // Set up output
     VertexToPixel output;
 
+	// Which particle and which corner of its quad
+	Particle input = particles[id / 4];
+	uint corner = id % 4;
+	float2 uv = float2(corner == 1 || corner == 2, corner >= 2);
+
     // Calculate output position
     matrix viewProj = mul(view, projection);
     output.position = mul(float4(input.position, 1.0f), viewProj);
 
 	// Use UV to offset position (billboarding)
-	float2 offset = input.uv * 2 - 1;
+	float2 offset = uv * 2 - 1;
 	offset *= input.size;
 	offset.y *= -1;
 	output.position.xy += offset;
-	
+
 	// Pass uv through
-	output.uv = input.uv;
+	output.uv = uv;
 	output.color = input.color;
-   
+
     return output;
-}
\ No newline at end of file
+}
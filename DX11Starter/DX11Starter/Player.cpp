@@ -2,15 +2,18 @@
 
 using namespace std;
 
-Player::Player(Mesh* mesh, Material* material) : Entity(mesh, material)
+Player::Player(int mesh, int material, float radius) : Entity(mesh, material, radius, ENTITY_SHIP)
 {
 	this->SetActive(true);
 	this->SetPosition(0.0f, 0.0f, -50.0f);
 	this->SetRotation(-1.0f * XM_PIDIV2, XM_PI, 0.0f);
-	accelRate = 0.2f;
-	decelRate = 0.09f;
+	//Per second, so movement doesn't depend on the simulation rate.  Same
+	//feel as the old per frame values at 60 frames a second
+	accelRate = 12.0f;
+	decelRate = 5.4f;
 	velocity = XMFLOAT3(0, 0, 0);
-	maxVelocity = 0.8f;
+	maxVelocity = 48.0f;
+	wallDamping = 0.0002f;
 	xCap = 4.0f;
 	yCap = 2.0f;
 
@@ -43,24 +46,22 @@ void Player::Update(float deltaTime, float totalTime)
 	this->Move(0, 0, 10.0f * deltaTime);
 	if (pos.x > xCap) {
 		pos.x = xCap;
-		velocity.x *= accelRate/1000;
+		velocity.x *= wallDamping;
 	}
 	if (pos.y > yCap) {
 		pos.y = yCap;
-		velocity.y *= accelRate/1000;
+		velocity.y *= wallDamping;
 	}
 	if (pos.x < -xCap) {
 		pos.x = -xCap;
-		velocity.x *= accelRate/1000;
+		velocity.x *= wallDamping;
 	}
 	if (pos.y < -yCap) {
 		pos.y = -yCap;
-		velocity.y *= accelRate/1000;
+		velocity.y *= wallDamping;
 	}
 	this->SetPosition(pos.x, pos.y, GetPosition().z);
 	//this->SetRotation(-1.0f * XM_PIDIV2 + 5 * velocity.y, XM_PI + 5 * velocity.x, 0.0f);
-	XMFLOAT3 rot = GetRotation();
-	XMMATRIX rotM = XMMatrixRotationRollPitchYaw(rot.x, rot.y, rot.z);
 	//XMVECTOR enginePos = XMLoadFloat3(&engineOffset);
 	XMFLOAT3 enginePos = engineOffset;
 	//enginePos = rotM * enginePos;
@@ -72,46 +73,6 @@ void Player::Update(float deltaTime, float totalTime)
 
 }
 
-void Player::Draw(ID3D11DeviceContext* context, Camera* camera, LightManager* lightManager)
-{
-	if (this->IsActive() != true)
-	{
-		return;
-	}
-
-	//Get array of PointLights
-	PointLight lightArray[64] = {};
-	for (size_t i = 0; i < lightManager->pointLights.size(); i++)
-	{
-		lightArray[i] = *(lightManager->pointLights[i]);
-	}
-	int lightCount = (int)lightManager->pointLights.size();
-
-	SimpleVertexShader* vShader = GetMaterial()->GetVertexShader();
-	SimplePixelShader* pShader = GetMaterial()->GetPixelShader();
-
-	vShader->SetShader();
-	pShader->SetShader();
-
-	vShader->SetMatrix4x4("world", GetWorld());
-	vShader->SetMatrix4x4("view", camera->GetView());
-	vShader->SetMatrix4x4("projection", camera->GetProj());
-	vShader->SetMatrix4x4("normalWorld", GetNormalWorld());
-
-	pShader->SetData("dirLight", &(lightManager->dirLight), sizeof(DirectionalLight));
-	pShader->SetData("lightList", &lightArray, sizeof(PointLight) * 64);
-	pShader->SetData("pointLightCount", &lightCount, sizeof(int));
-	pShader->SetData("cameraPosition", &(camera->GetCamPosition()), sizeof(XMFLOAT3));
-	pShader->SetShaderResourceView("diffuseTexture", GetMaterial()->GetTexture());
-	pShader->SetShaderResourceView("normalMap", GetMaterial()->GetNormal());
-	pShader->SetSamplerState("basicSampler", GetMaterial()->GetSampler());
-
-	vShader->CopyAllBufferData();
-	pShader->CopyAllBufferData();
-
-	Entity::Draw(context, camera, lightManager);
-}
-
 void Player::Collides()
 {
 }
@@ -1,13 +1,14 @@
 #pragma once
 #include "Entity.h"
+#include "Lights.h"
+
 class Player :
 	public Entity
 {
 public:
-	Player(Mesh* mesh, Material* material);
+	Player(int mesh, int material, float radius);
 	~Player();
 	void Update(float deltaTime, float totalTime) override;
-	void Draw(ID3D11DeviceContext* context, Camera* camera, LightManager* lightManager) override;
 	void Collides() override;
 	void Accelerate(float dx, float dy, float dz);
 	void Decelerate(float d);
@@ -21,6 +22,7 @@ public:
 private:
 	
 	float maxVelocity;
+	float wallDamping;
 	XMFLOAT3 accel;
 	float xCap;
 	float yCap;
@@ -0,0 +1,91 @@
+#pragma once
+
+// --------------------------------------------------------
+// What the device-free code (the simulation and the systems
+// it uses) needs from Windows-only headers.  On Windows that's
+// DirectXMath itself.  Elsewhere, for the headless benchmark
+// and the tests, it's stand-ins with the same layout: the
+// storage types and constants only.  So anything that has to
+// build off Windows does its math by hand rather than with
+// XMVECTOR and XMMATRIX.
+// --------------------------------------------------------
+#if defined(_WIN32)
+
+#include <DirectXMath.h>
+
+#else
+
+#include <stdio.h>
+
+namespace DirectX
+{
+	const float XM_PI = 3.141592654f;
+	const float XM_2PI = 6.283185307f;
+	const float XM_PIDIV2 = 1.570796327f;
+	const float XM_PIDIV4 = 0.785398163f;
+
+	struct XMFLOAT2
+	{
+		float x;
+		float y;
+
+		XMFLOAT2() = default;
+		XMFLOAT2(float x, float y) : x(x), y(y) {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x;
+		float y;
+		float z;
+
+		XMFLOAT3() = default;
+		XMFLOAT3(float x, float y, float z) : x(x), y(y), z(z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x;
+		float y;
+		float z;
+		float w;
+
+		XMFLOAT4() = default;
+		XMFLOAT4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+	};
+
+	struct XMUINT4
+	{
+		unsigned int x;
+		unsigned int y;
+		unsigned int z;
+		unsigned int w;
+	};
+}
+
+//The CRT's _s functions are MSVC's.  With the arguments used here they
+//behave like the standard ones
+#define sscanf_s sscanf
+
+inline int fopen_s(FILE** file, const char* path, const char* mode)
+{
+	*file = fopen(path, mode);
+	return *file ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,348 @@
+#include "Profiler.h"
+#include "Portable.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+atomic<bool> Profiler::enabled(false);
+bool Profiler::capturing = false;
+long long Profiler::captureStart = 0;
+int Profiler::dropped = 0;
+double Profiler::zoneCost = 0.0;
+
+mutex Profiler::lock;
+vector<Profiler::ThreadBuffer*> Profiler::buffers;
+vector<string*> Profiler::names;
+Profiler::ThreadBuffer* Profiler::mainBuffer = 0;
+thread_local Profiler::ThreadBuffer* Profiler::threadBuffer = 0;
+thread_local int Profiler::threadDepth = 0;
+
+long long Profiler::frameStart = 0;
+long long Profiler::lastFrameStart = 0;
+long long Profiler::lastFrameEnd = 0;
+vector<long long> Profiler::captureFrames;
+
+//Every time is measured from here
+static const std::chrono::high_resolution_clock::time_point programStart = std::chrono::high_resolution_clock::now();
+
+//Zone names go in as JSON strings
+static void WriteName(FILE* file, const char* name)
+{
+	for (const char* c = name; *c; c++)
+	{
+		if (*c == '"' || *c == '\\')
+			fputc('\\', file);
+		fputc(*c, file);
+	}
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+	Profiler::enabled.store(enabled);
+}
+
+bool Profiler::IsEnabled()
+{
+	return enabled.load(memory_order_relaxed);
+}
+
+void Profiler::BeginFrame()
+{
+	if (IsEnabled() && !mainBuffer)
+	{
+		mainBuffer = GetThreadBuffer();
+		lock_guard<mutex> guard(lock);
+		mainBuffer->name = "Main";
+	}
+	frameStart = Now();
+}
+
+void Profiler::EndFrame()
+{
+	lastFrameStart = frameStart;
+	lastFrameEnd = Now();
+	if (capturing)
+		captureFrames.push_back(frameStart);
+}
+
+void Profiler::BeginCapture()
+{
+	{
+		lock_guard<mutex> guard(lock);
+		for (size_t i = 0; i < buffers.size(); i++)
+		{
+			buffers[i]->captureHead = buffers[i]->head.load(memory_order_acquire);
+		}
+	}
+
+	dropped = 0;
+	captureFrames.clear();
+	captureStart = Now();
+	capturing = true;
+	SetEnabled(true);
+}
+
+bool Profiler::EndCapture(const char* path)
+{
+	SetEnabled(false);
+	capturing = false;
+
+	FILE* file = 0;
+	if (fopen_s(&file, path, "w") != 0 || !file)
+		return false;
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	int mainId = 0;
+
+	lock_guard<mutex> guard(lock);
+	for (size_t b = 0; b < buffers.size(); b++)
+	{
+		ThreadBuffer* buffer = buffers[b];
+		if (buffer == mainBuffer)
+			mainId = buffer->id;
+
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"", first ? "" : ",\n", buffer->id);
+		WriteName(file, buffer->name.c_str());
+		fprintf(file, "\"}}");
+		first = false;
+
+		//Whatever the ring has already written over can't be saved
+		unsigned long long head = buffer->head.load(memory_order_acquire);
+		unsigned long long oldest = head > (unsigned long long)bufferSize ? head - bufferSize : 0;
+		unsigned long long begin = buffer->captureHead > oldest ? buffer->captureHead : oldest;
+		dropped += (int)(begin - buffer->captureHead);
+
+		for (unsigned long long i = begin; i < head; i++)
+		{
+			const ProfileEvent& e = buffer->events[i & (bufferSize - 1)];
+			if (e.Start < captureStart)
+				continue;
+
+			fprintf(file, ",\n{\"name\":\"");
+			WriteName(file, e.Name);
+			fprintf(file, "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+				e.Start / 1000.0,
+				(e.End - e.Start) / 1000.0,
+				buffer->id);
+		}
+	}
+
+	//Frame starts, as lines across every thread
+	for (size_t i = 0; i < captureFrames.size(); i++)
+	{
+		fprintf(file, "%s{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+			first ? "" : ",\n",
+			captureFrames[i] / 1000.0,
+			mainId);
+		first = false;
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	return true;
+}
+
+bool Profiler::IsCapturing()
+{
+	return capturing;
+}
+
+int Profiler::GetDroppedCount()
+{
+	return dropped;
+}
+
+const char* Profiler::Intern(const string& name)
+{
+	lock_guard<mutex> guard(lock);
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (*names[i] == name)
+			return names[i]->c_str();
+	}
+	names.push_back(new string(name));
+	return names.back()->c_str();
+}
+
+void Profiler::GetLastFrame(vector<ProfileNode>& nodes)
+{
+	nodes.clear();
+	if (!mainBuffer)
+		return;
+
+	//Zones are written as they end, so end times only go up.  Walk back
+	//from the newest until they're from before the frame
+	vector<ProfileEvent> events;
+	unsigned long long head = mainBuffer->head.load(memory_order_acquire);
+	unsigned long long oldest = head > (unsigned long long)bufferSize ? head - bufferSize : 0;
+	for (unsigned long long i = head; i > oldest; i--)
+	{
+		const ProfileEvent& e = mainBuffer->events[(i - 1) & (bufferSize - 1)];
+		if (e.End < lastFrameStart)
+			break;
+		if (e.Start >= lastFrameStart && e.End <= lastFrameEnd)
+			events.push_back(e);
+	}
+
+	//Parents start first (or at the same time, but less deep)
+	sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b)
+	{
+		return a.Start < b.Start || (a.Start == b.Start && a.Depth < b.Depth);
+	});
+
+	vector<int> open;
+	vector<int> openDepth;
+	for (size_t i = 0; i < events.size(); i++)
+	{
+		const ProfileEvent& e = events[i];
+		while (open.size() > 0 && openDepth.back() >= e.Depth)
+		{
+			open.pop_back();
+			openDepth.pop_back();
+		}
+		int parent = open.size() > 0 ? open.back() : -1;
+
+		//Same name under the same parent is the same node, called again
+		int node = -1;
+		for (size_t n = 0; n < nodes.size() && node < 0; n++)
+		{
+			if (nodes[n].Parent == parent && strcmp(nodes[n].Name, e.Name) == 0)
+				node = (int)n;
+		}
+		if (node < 0)
+		{
+			ProfileNode added = {};
+			added.Name = e.Name;
+			added.Parent = parent;
+			added.Depth = parent < 0 ? 0 : nodes[parent].Depth + 1;
+			nodes.push_back(added);
+			node = (int)nodes.size() - 1;
+		}
+
+		nodes[node].Count++;
+		nodes[node].TotalMs += (e.End - e.Start) / 1000000.0;
+		open.push_back(node);
+		openDepth.push_back(e.Depth);
+	}
+
+	for (size_t n = 0; n < nodes.size(); n++)
+	{
+		nodes[n].SelfMs += nodes[n].TotalMs;
+		if (nodes[n].Parent >= 0)
+			nodes[nodes[n].Parent].SelfMs -= nodes[n].TotalMs;
+	}
+}
+
+double Profiler::GetLastFrameTime()
+{
+	return (lastFrameEnd - lastFrameStart) / 1000000.0;
+}
+
+int Profiler::GetLastFrameZoneCount()
+{
+	int count = 0;
+	lock_guard<mutex> guard(lock);
+	for (size_t b = 0; b < buffers.size(); b++)
+	{
+		ThreadBuffer* buffer = buffers[b];
+		unsigned long long head = buffer->head.load(memory_order_acquire);
+		unsigned long long oldest = head > (unsigned long long)bufferSize ? head - bufferSize : 0;
+		for (unsigned long long i = head; i > oldest; i--)
+		{
+			const ProfileEvent& e = buffer->events[(i - 1) & (bufferSize - 1)];
+			if (e.End < lastFrameStart)
+				break;
+			if (e.Start >= lastFrameStart && e.End <= lastFrameEnd)
+				count++;
+		}
+	}
+	return count;
+}
+
+double Profiler::Calibrate()
+{
+	const int zones = 10000;
+	bool wasEnabled = IsEnabled();
+	SetEnabled(true);
+
+	long long start = Now();
+	for (int i = 0; i < zones; i++)
+	{
+		PROFILE_SCOPE("Calibrate");
+	}
+	long long end = Now();
+
+	SetEnabled(wasEnabled);
+	zoneCost = (end - start) / 1000000.0 / zones;
+	return zoneCost;
+}
+
+double Profiler::GetZoneCost()
+{
+	return zoneCost;
+}
+
+void Profiler::Shutdown()
+{
+	SetEnabled(false);
+	lock_guard<mutex> guard(lock);
+	for (size_t i = 0; i < buffers.size(); i++)
+	{
+		delete buffers[i];
+	}
+	buffers.clear();
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		delete names[i];
+	}
+	names.clear();
+	mainBuffer = 0;
+	threadBuffer = 0;
+}
+
+long long Profiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - programStart).count();
+}
+
+int Profiler::Enter()
+{
+	return threadDepth++;
+}
+
+void Profiler::Leave(const char* name, long long start, int depth)
+{
+	long long end = Now();
+	threadDepth = depth;
+
+	//Only this thread writes here, so the new head just has to be published
+	//after the event is filled in
+	ThreadBuffer* buffer = GetThreadBuffer();
+	unsigned long long head = buffer->head.load(memory_order_relaxed);
+	ProfileEvent& e = buffer->events[head & (bufferSize - 1)];
+	e.Name = name;
+	e.Start = start;
+	e.End = end;
+	e.Depth = depth;
+	buffer->head.store(head + 1, memory_order_release);
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+	if (threadBuffer)
+		return threadBuffer;
+
+	ThreadBuffer* buffer = new ThreadBuffer();
+	buffer->events.resize(bufferSize);
+	buffer->head.store(0);
+	buffer->captureHead = 0;
+
+	lock_guard<mutex> guard(lock);
+	buffer->id = (int)buffers.size() + 1;
+	buffer->name = "Worker " + to_string(buffer->id - 1);
+	buffers.push_back(buffer);
+	threadBuffer = buffer;
+	return buffer;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//Times the rest of the enclosing block as a zone called name.  name has to
+//outlive the capture, so a literal or something from Profiler::Intern.
+//Define NO_PROFILING to compile the markers out altogether
+#if defined(NO_PROFILING)
+#define PROFILE_SCOPE(name)
+#else
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#endif
+
+//One finished zone.  Times are in nanoseconds from when the program started
+struct ProfileEvent
+{
+	const char* Name;
+	long long Start;
+	long long End;
+	int Depth;
+};
+
+//Zones on the main thread in one frame, merged by name under the same parent
+struct ProfileNode
+{
+	const char* Name;
+	int Parent;
+	int Depth;
+	int Count;
+	double TotalMs;
+	double SelfMs;
+};
+
+// --------------------------------------------------------
+// Scoped zone profiler.  Each thread writes its finished
+// zones into its own ring buffer, so recording never takes
+// a lock or touches another thread's memory.  While it's
+// off a zone is one flag check.
+//
+// Captures are written out as Chrome trace JSON, which
+// chrome://tracing and Perfetto both open.  Buffers are read
+// between frames, when no jobs are running.
+// --------------------------------------------------------
+class Profiler
+{
+public:
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled();
+
+	//Called by the main loop around every frame
+	static void BeginFrame();
+	static void EndFrame();
+
+	//Turns profiling on and remembers when.  EndCapture turns it back off and
+	//writes every zone since then to path, returns false if it couldn't
+	static void BeginCapture();
+	static bool EndCapture(const char* path);
+	static bool IsCapturing();
+
+	//Zones that were overwritten before EndCapture could write them
+	static int GetDroppedCount();
+
+	//A copy of name that lives as long as the program, for zone names that
+	//aren't literals.  Takes a lock, so not for every zone
+	static const char* Intern(const string& name);
+
+	//The main thread's zones in the last full frame, parents before children
+	static void GetLastFrame(vector<ProfileNode>& nodes);
+	static double GetLastFrameTime();
+
+	//Zones recorded on every thread in the last full frame
+	static int GetLastFrameZoneCount();
+
+	//Times a lot of empty zones to find what one costs, in milliseconds
+	static double Calibrate();
+	static double GetZoneCost();
+
+	//Frees every thread's buffer.  Nothing can be profiled after this
+	static void Shutdown();
+
+	//Used by ProfileZone
+	static long long Now();
+	static int Enter();
+	static void Leave(const char* name, long long start, int depth);
+
+private:
+	struct ThreadBuffer
+	{
+		vector<ProfileEvent> events;
+		atomic<unsigned long long> head;
+		unsigned long long captureHead;
+		int id;
+		string name;
+	};
+
+	//Per thread buffers hold this many zones before wrapping
+	static const int bufferSize = 1 << 16;
+
+	static atomic<bool> enabled;
+	static bool capturing;
+	static long long captureStart;
+	static int dropped;
+	static double zoneCost;
+
+	static mutex lock;
+	static vector<ThreadBuffer*> buffers;
+	static vector<string*> names;
+	static ThreadBuffer* mainBuffer;
+	static thread_local ThreadBuffer* threadBuffer;
+	static thread_local int threadDepth;
+
+	static long long frameStart;
+	static long long lastFrameStart;
+	static long long lastFrameEnd;
+	static vector<long long> captureFrames;
+
+	static ThreadBuffer* GetThreadBuffer();
+
+	friend class ProfileZone;
+};
+
+// --------------------------------------------------------
+// Marks a zone from construction to destruction.  Use it
+// through PROFILE_SCOPE
+// --------------------------------------------------------
+class ProfileZone
+{
+public:
+	ProfileZone(const char* name)
+	{
+		if (Profiler::enabled.load(memory_order_relaxed))
+		{
+			this->name = name;
+			depth = Profiler::Enter();
+			start = Profiler::Now();
+		}
+		else this->name = 0;
+	}
+
+	~ProfileZone()
+	{
+		if (name)
+			Profiler::Leave(name, start, depth);
+	}
+
+private:
+	const char* name;
+	long long start;
+	int depth;
+};
@@ -0,0 +1,96 @@
+#include "RadixSorter.h"
+#include <cstring>
+
+RadixSorter::RadixSorter(JobSystem* jobSystem)
+{
+	this->jobSystem = jobSystem;
+}
+
+RadixSorter::~RadixSorter()
+{
+}
+
+void RadixSorter::Sort(unsigned int* keys, unsigned int* values, int count)
+{
+	if (count < 2)
+		return;
+
+	if ((int)tempKeys.size() < count)
+	{
+		tempKeys.resize(count);
+		tempValues.resize(count);
+	}
+
+	//Enough chunks to keep every thread busy, but not so many they're tiny
+	int chunkCount = (int)jobSystem->GetThreadCount();
+	if (chunkCount > count / minChunkSize)
+		chunkCount = count / minChunkSize;
+	if (chunkCount < 1)
+		chunkCount = 1;
+	int chunkSize = (count + chunkCount - 1) / chunkCount;
+	histograms.resize(chunkCount * 256);
+
+	unsigned int* srcKeys = keys;
+	unsigned int* srcValues = values;
+	unsigned int* dstKeys = &tempKeys[0];
+	unsigned int* dstValues = &tempValues[0];
+
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		//Count digits in each chunk
+		jobSystem->ParallelFor(chunkCount, [&](unsigned int chunk)
+		{
+			unsigned int* counts = &histograms[chunk * 256];
+			memset(counts, 0, sizeof(unsigned int) * 256);
+
+			int start = chunk * chunkSize;
+			int end = start + chunkSize < count ? start + chunkSize : count;
+			for (int i = start; i < end; i++)
+				counts[(srcKeys[i] >> shift) & 0xFF]++;
+		});
+
+		//Every chunk with a given digit goes after all smaller digits and after
+		//earlier chunks with the same digit, which keeps the sort stable
+		unsigned int offset = 0;
+		for (int digit = 0; digit < 256; digit++)
+		{
+			for (int chunk = 0; chunk < chunkCount; chunk++)
+			{
+				unsigned int c = histograms[chunk * 256 + digit];
+				histograms[chunk * 256 + digit] = offset;
+				offset += c;
+			}
+		}
+
+		//Scatter
+		jobSystem->ParallelFor(chunkCount, [&](unsigned int chunk)
+		{
+			unsigned int* offsets = &histograms[chunk * 256];
+
+			int start = chunk * chunkSize;
+			int end = start + chunkSize < count ? start + chunkSize : count;
+			for (int i = start; i < end; i++)
+			{
+				unsigned int o = offsets[(srcKeys[i] >> shift) & 0xFF]++;
+				dstKeys[o] = srcKeys[i];
+				dstValues[o] = srcValues[i];
+			}
+		});
+
+		//Swap roles for the next pass
+		unsigned int* t = srcKeys; srcKeys = dstKeys; dstKeys = t;
+		t = srcValues; srcValues = dstValues; dstValues = t;
+	}
+
+	//Four passes is even, so the result has ended up back in keys/values
+}
+
+unsigned int RadixSorter::FloatToKey(float f)
+{
+	unsigned int bits;
+	memcpy(&bits, &f, sizeof(bits));
+
+	//Negative floats sort backwards, so flip all their bits.  Positive ones
+	//just need to go above the negatives
+	return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+}
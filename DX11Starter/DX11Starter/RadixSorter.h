@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include "JobSystem.h"
+
+// --------------------------------------------------------
+// Parallel LSD radix sort of 32 bit keys with a 32 bit value
+// carried along (usually an index).  Four 8 bit passes, each
+// one split into chunks that count and scatter on the job
+// system.  Stable, ascending.
+// --------------------------------------------------------
+class RadixSorter
+{
+public:
+	RadixSorter(JobSystem* jobSystem);
+	~RadixSorter();
+
+	//Sorts keys[0..count) ascending, moving values the same way
+	void Sort(unsigned int* keys, unsigned int* values, int count);
+
+	//Turns a float into a key that sorts in the same order
+	static unsigned int FloatToKey(float f);
+
+private:
+	JobSystem* jobSystem;
+
+	//Ping-pong buffers
+	std::vector<unsigned int> tempKeys;
+	std::vector<unsigned int> tempValues;
+
+	//256 counters per chunk, turned into scatter offsets in place
+	std::vector<unsigned int> histograms;
+
+	//Below this many keys per chunk it's not worth splitting
+	const int minChunkSize = 4096;
+};
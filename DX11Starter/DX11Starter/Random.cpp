@@ -0,0 +1,125 @@
+#include "Random.h"
+
+unsigned long long Random::globalSeed = 0;
+
+Random::Random()
+{
+	Seed(NextSeed());
+}
+
+Random::Random(unsigned long long seed)
+{
+	Seed(seed);
+}
+
+void Random::Seed(unsigned long long seed)
+{
+	//Expand the seed with splitmix so nearby seeds still give unrelated streams
+	unsigned long long x = seed;
+	unsigned long long a = SplitMix(x);
+	unsigned long long b = SplitMix(x);
+	s[0] = (unsigned int)a;
+	s[1] = (unsigned int)(a >> 32);
+	s[2] = (unsigned int)b;
+	s[3] = (unsigned int)(b >> 32);
+
+	//Lanes are laid out so lanes[4k + stream] holds word k of that stream
+	for (int stream = 0; stream < 4; stream++)
+	{
+		a = SplitMix(x);
+		b = SplitMix(x);
+		lanes[0 + stream] = (unsigned int)a;
+		lanes[4 + stream] = (unsigned int)(a >> 32);
+		lanes[8 + stream] = (unsigned int)b;
+		lanes[12 + stream] = (unsigned int)(b >> 32);
+	}
+}
+
+unsigned int Random::Next()
+{
+	unsigned int result = s[0] + s[3];
+	unsigned int t = s[1] << 9;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = (s[3] << 11) | (s[3] >> 21);
+
+	return result;
+}
+
+float Random::NextFloat()
+{
+	//Top 24 bits fill a float mantissa exactly
+	return (Next() >> 8) * (1.0f / 16777216.0f);
+}
+
+float Random::Range(float min, float max)
+{
+	return min + NextFloat() * (max - min);
+}
+
+unsigned int Random::NextInt(unsigned int bound)
+{
+	return (unsigned int)(((unsigned long long)Next() * bound) >> 32);
+}
+
+void Random::FillFloats(float* out, int count, float min, float max)
+{
+	__m128 scale = _mm_set1_ps((max - min) * (1.0f / 16777216.0f));
+	__m128 offset = _mm_set1_ps(min);
+
+	//The state isn't 16-byte aligned, so pull it into registers once
+	__m128i s0 = _mm_loadu_si128((__m128i*)(lanes + 0));
+	__m128i s1 = _mm_loadu_si128((__m128i*)(lanes + 4));
+	__m128i s2 = _mm_loadu_si128((__m128i*)(lanes + 8));
+	__m128i s3 = _mm_loadu_si128((__m128i*)(lanes + 12));
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		//Same steps as Next(), on all four streams at once
+		__m128i result = _mm_add_epi32(s0, s3);
+		__m128i t = _mm_slli_epi32(s1, 9);
+
+		s2 = _mm_xor_si128(s2, s0);
+		s3 = _mm_xor_si128(s3, s1);
+		s1 = _mm_xor_si128(s1, s2);
+		s0 = _mm_xor_si128(s0, s3);
+		s2 = _mm_xor_si128(s2, t);
+		s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+		//24 bits are always positive, so the signed convert is fine
+		__m128 f = _mm_cvtepi32_ps(_mm_srli_epi32(result, 8));
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(f, scale), offset));
+	}
+
+	_mm_storeu_si128((__m128i*)(lanes + 0), s0);
+	_mm_storeu_si128((__m128i*)(lanes + 4), s1);
+	_mm_storeu_si128((__m128i*)(lanes + 8), s2);
+	_mm_storeu_si128((__m128i*)(lanes + 12), s3);
+
+	//Leftovers
+	for (; i < count; i++)
+		out[i] = Range(min, max);
+}
+
+void Random::SetGlobalSeed(unsigned long long seed)
+{
+	globalSeed = seed;
+}
+
+unsigned long long Random::NextSeed()
+{
+	return SplitMix(globalSeed);
+}
+
+unsigned long long Random::SplitMix(unsigned long long& x)
+{
+	unsigned long long z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
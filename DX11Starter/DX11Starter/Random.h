@@ -0,0 +1,42 @@
+#pragma once
+
+#include <emmintrin.h>
+
+// --------------------------------------------------------
+// Small xoshiro128+ generator.  Each emitter/spawner owns one, so
+// there is no shared state between threads, and they are all
+// seeded from one global seed so a run can be reproduced.
+// --------------------------------------------------------
+class Random
+{
+public:
+	//Seeds from the next global seed
+	Random();
+	Random(unsigned long long seed);
+
+	void Seed(unsigned long long seed);
+
+	unsigned int Next();
+	float NextFloat();						// [0, 1)
+	float Range(float min, float max);		// [min, max)
+	unsigned int NextInt(unsigned int bound);	// [0, bound)
+
+	//Fills out[0..count) with floats in [min, max), four at a time
+	void FillFloats(float* out, int count, float min, float max);
+
+	//Every generator created after this is seeded from here, in creation order
+	static void SetGlobalSeed(unsigned long long seed);
+	static unsigned long long NextSeed();
+
+private:
+	//Scalar state
+	unsigned int s[4];
+
+	//Four independent streams side by side for the bulk path; lanes[4k..4k+3]
+	//hold word k of each stream.  Plain words rather than __m128i so the
+	//heap-allocated owners don't need 16-byte alignment
+	unsigned int lanes[16];
+
+	static unsigned long long globalSeed;
+	static unsigned long long SplitMix(unsigned long long& x);
+};
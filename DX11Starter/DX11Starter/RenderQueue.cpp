@@ -0,0 +1,249 @@
+#include "RenderQueue.h"
+#include <chrono>
+
+//Key layout, from the top bit down
+const int passBits = 4;
+const int stateBits = 4;
+const int shaderBits = 8;
+const int materialBits = 12;
+const int meshBits = 12;
+const int depthBits = 24;
+
+RenderQueue::RenderQueue(JobSystem* jobSystem, ID3D11Device* device, EntityRenderer* entityRenderer)
+	: entityRenderer(entityRenderer), batcher(device, entityRenderer), sorter(jobSystem)
+{
+	instancing = true;
+	depthRow = XMFLOAT4(0, 0, 0, 0);
+	farClip = 100.0f;
+	drawCount = 0;
+	instancedCount = 0;
+	instanceUploadBytes = 0;
+	stateChanges = 0;
+	sortTime = 0.0;
+}
+
+RenderQueue::~RenderQueue()
+{
+}
+
+void RenderQueue::Begin(Camera* camera)
+{
+	packets.clear();
+	drawCount = 0;
+	instancedCount = 0;
+	instanceUploadBytes = 0;
+	stateChanges = 0;
+	sortTime = 0.0;
+
+	XMFLOAT4X4 view = camera->GetView();
+	depthRow = XMFLOAT4(view._31, view._32, view._33, view._34);
+
+	//Far plane from the projection, see LightClusters
+	XMFLOAT4X4 proj = camera->GetProj();
+	farClip = proj._34 / (1.0f - proj._33);
+}
+
+unsigned int RenderQueue::GetId(unordered_map<void*, unsigned int>& ids, void* thing, unsigned int bits)
+{
+	unordered_map<void*, unsigned int>::iterator it = ids.find(thing);
+	if (it != ids.end())
+		return it->second;
+
+	//Past the field's range everything shares the last id, which only costs
+	//some sorting quality
+	unsigned int id = (unsigned int)ids.size();
+	unsigned int maxId = (1u << bits) - 1;
+	if (id > maxId)
+		id = maxId;
+	ids[thing] = id;
+	return id;
+}
+
+void RenderQueue::Add(Entity* entity, RenderPass pass, ID3D11RasterizerState* rasterState, ID3D11BlendState* blendState)
+{
+	Material* material = entityRenderer->GetMaterial(entity->GetMaterial());
+
+	//Raster and blend states share a field, so hash the pair into one pointer
+	void* states = (void*)((size_t)rasterState ^ ((size_t)blendState << 1));
+	unsigned long long state = GetId(stateIds, states, stateBits);
+	unsigned long long shader = GetId(shaderIds, material->GetPixelShader(), shaderBits);
+	unsigned long long mat = GetId(materialIds, material, materialBits);
+	unsigned long long mesh = GetId(meshIds, entityRenderer->GetMesh(entity->GetMesh()), meshBits);
+
+	//View depth, scaled to the key's range
+	XMFLOAT3 p = entity->GetRenderPosition();
+	float depth = (depthRow.x * p.x + depthRow.y * p.y + depthRow.z * p.z + depthRow.w) / farClip;
+	depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+	unsigned long long depthKey = (unsigned long long)(depth * ((1 << depthBits) - 1));
+
+	unsigned long long key = (unsigned long long)pass << (64 - passBits);
+	if (pass == RENDER_PASS_TRANSPARENT)
+	{
+		//Farthest first
+		depthKey = ((1 << depthBits) - 1) - depthKey;
+		key |= depthKey << (64 - passBits - depthBits);
+		key |= state << (64 - passBits - depthBits - stateBits);
+		key |= shader << (64 - passBits - depthBits - stateBits - shaderBits);
+		key |= mat << (64 - passBits - depthBits - stateBits - shaderBits - materialBits);
+		key |= mesh << (64 - passBits - depthBits - stateBits - shaderBits - materialBits - meshBits);
+	}
+	else
+	{
+		key |= state << (64 - passBits - stateBits);
+		key |= shader << (64 - passBits - stateBits - shaderBits);
+		key |= mat << (64 - passBits - stateBits - shaderBits - materialBits);
+		key |= mesh << (64 - passBits - stateBits - shaderBits - materialBits - meshBits);
+		key |= depthKey << (64 - passBits - stateBits - shaderBits - materialBits - meshBits - depthBits);
+	}
+
+	RenderPacket packet;
+	packet.key = key;
+	packet.entity = entity;
+	packet.rasterState = rasterState;
+	packet.blendState = blendState;
+	packets.push_back(packet);
+}
+
+void RenderQueue::Sort()
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	int count = (int)packets.size();
+	lowKeys.resize(count);
+	highKeys.resize(count);
+	order.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		lowKeys[i] = (unsigned int)packets[i].key;
+		order[i] = i;
+	}
+
+	//The sort is stable, so sorting by the low half and then the high half
+	//leaves the packets sorted by the whole key
+	if (count > 0)
+	{
+		sorter.Sort(&lowKeys[0], &order[0], count);
+		for (int i = 0; i < count; i++)
+			highKeys[i] = (unsigned int)(packets[order[i]].key >> 32);
+		sorter.Sort(&highKeys[0], &order[0], count);
+	}
+
+	std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - start;
+	sortTime += time.count();
+}
+
+void RenderQueue::Submit(ID3D11DeviceContext* context, StateCache* stateCache, LightManager* lightManager, RenderPass pass)
+{
+	ID3D11RasterizerState* rasterState = 0;
+	ID3D11BlendState* blendState = 0;
+	Material* material = 0;
+
+	//Work out the draws first, so every instance can go up in one copy.
+	//Sorting has already put packets that can share a batch next to each other
+	items.clear();
+	batcher.Begin();
+	RenderPacket* last = 0;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		RenderPacket& packet = packets[order[i]];
+		if ((RenderPass)(packet.key >> (64 - passBits)) != pass)
+			continue;
+
+		SubmitItem item;
+		item.packet = order[i];
+		item.batch = -1;
+		if (instancing && entityRenderer->GetMaterial(packet.entity->GetMaterial())->GetInstanced())
+		{
+			if (last && (last->rasterState != packet.rasterState || last->blendState != packet.blendState))
+				batcher.EndBatch();
+			item.batch = batcher.Add(packet.entity, lightManager);
+			instancedCount++;
+
+			//Joined a batch that's already going to be drawn
+			if (!items.empty() && items.back().batch == item.batch)
+			{
+				last = &packet;
+				continue;
+			}
+		}
+		else
+		{
+			batcher.EndBatch();
+		}
+		items.push_back(item);
+		last = &packet;
+	}
+	batcher.Upload(context);
+	instanceUploadBytes += batcher.GetUploadBytes();
+
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		RenderPacket& packet = packets[items[i].packet];
+
+		if (packet.rasterState != rasterState)
+		{
+			rasterState = packet.rasterState;
+			stateCache->RSSetState(rasterState);
+			stateChanges++;
+		}
+		if (packet.blendState != blendState)
+		{
+			blendState = packet.blendState;
+			stateCache->OMSetBlendState(blendState, 0, 0xffffffff);
+			stateChanges++;
+		}
+		Material* packetMaterial = entityRenderer->GetMaterial(packet.entity->GetMaterial());
+		if (packetMaterial != material)
+		{
+			material = packetMaterial;
+			stateChanges++;
+		}
+
+		if (items[i].batch >= 0)
+			batcher.Draw(context, items[i].batch, lightManager);
+		else
+			entityRenderer->Draw(context, packet.entity, lightManager);
+		drawCount++;
+	}
+
+	//Leave the defaults for whatever draws next
+	if (rasterState)
+		stateCache->RSSetState(0);
+	if (blendState)
+		stateCache->OMSetBlendState(0, 0, 0xffffffff);
+}
+
+void RenderQueue::SetInstancing(bool instancing)
+{
+	this->instancing = instancing;
+}
+
+bool RenderQueue::IsInstancing()
+{
+	return instancing;
+}
+
+int RenderQueue::GetDrawCount()
+{
+	return drawCount;
+}
+
+int RenderQueue::GetInstancedCount()
+{
+	return instancedCount;
+}
+
+int RenderQueue::GetInstanceUploadBytes()
+{
+	return instanceUploadBytes;
+}
+
+int RenderQueue::GetStateChanges()
+{
+	return stateChanges;
+}
+
+double RenderQueue::GetSortTime()
+{
+	return sortTime;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <d3d11.h>
+#include <vector>
+#include <unordered_map>
+#include "Entity.h"
+#include "EntityRenderer.h"
+#include "Camera.h"
+#include "LightManager.h"
+#include "StateCache.h"
+#include "RadixSorter.h"
+#include "InstanceBatcher.h"
+
+using namespace std;
+
+//Passes are drawn in this order, and sort before anything else in a key
+enum RenderPass
+{
+	RENDER_PASS_OPAQUE,
+	RENDER_PASS_TRANSPARENT
+};
+
+// --------------------------------------------------------
+// Entities are added once a frame as draw packets, each with
+// a 64 bit key.  Opaque keys go pass, states, shader, material,
+// mesh, then depth front to back, so draws that share state end
+// up next to each other.  Transparent keys put depth (back to
+// front) straight after the pass, since order matters more
+// there than state changes.  The keys are radix sorted, then
+// each pass is submitted in key order.  Runs of packets with
+// the same mesh, material and states are drawn as one instanced
+// batch when the material has an instanced version.
+// --------------------------------------------------------
+class RenderQueue
+{
+public:
+	RenderQueue(JobSystem* jobSystem, ID3D11Device* device, EntityRenderer* entityRenderer);
+	~RenderQueue();
+
+	//Empties the queue for a new frame, depth keys come from this camera
+	void Begin(Camera* camera);
+
+	//Queues an entity to be drawn in a pass, with its raster and blend
+	//states (null for the defaults)
+	void Add(Entity* entity, RenderPass pass, ID3D11RasterizerState* rasterState = 0, ID3D11BlendState* blendState = 0);
+
+	void Sort();
+
+	//Draws every packet of a pass in sorted order, then puts the default
+	//raster and blend states back
+	void Submit(ID3D11DeviceContext* context, StateCache* stateCache, LightManager* lightManager, RenderPass pass);
+
+	//Off draws every packet on its own, for comparing
+	void SetInstancing(bool instancing);
+	bool IsInstancing();
+
+	//For the frame so far
+	int GetDrawCount();
+	int GetInstancedCount();
+	int GetInstanceUploadBytes();
+	int GetStateChanges();
+	double GetSortTime();
+
+private:
+	struct RenderPacket
+	{
+		unsigned long long key;
+		Entity* entity;
+		ID3D11RasterizerState* rasterState;
+		ID3D11BlendState* blendState;
+	};
+
+	vector<RenderPacket> packets;
+
+	//What Submit draws, either one packet or a whole batch
+	struct SubmitItem
+	{
+		int packet;
+		int batch;
+	};
+	vector<SubmitItem> items;
+	EntityRenderer* entityRenderer;
+	InstanceBatcher batcher;
+	bool instancing;
+
+	//Key halves sorted one after the other (low then high, both stable),
+	//and the packet order that comes out
+	RadixSorter sorter;
+	vector<unsigned int> lowKeys;
+	vector<unsigned int> highKeys;
+	vector<unsigned int> order;
+
+	//Small ids for the key fields, handed out the first time a thing is seen
+	unordered_map<void*, unsigned int> stateIds;
+	unordered_map<void*, unsigned int> shaderIds;
+	unordered_map<void*, unsigned int> materialIds;
+	unordered_map<void*, unsigned int> meshIds;
+	unsigned int GetId(unordered_map<void*, unsigned int>& ids, void* thing, unsigned int bits);
+
+	//Third row of the view matrix (it's stored transposed), for view depth
+	XMFLOAT4 depthRow;
+	float farClip;
+
+	int drawCount;
+	int instancedCount;
+	int instanceUploadBytes;
+	int stateChanges;
+	double sortTime;
+};
@@ -1,12 +1,12 @@
 #include "Reticule.h"
+#include <math.h>
 
 
 
-Reticule::Reticule(Mesh* mesh, Material* material, Player* player, TargetManager* targetManager, ID3D11BlendState* blend, float bulletRad) : Entity(mesh, material)
+Reticule::Reticule(int mesh, int material, float radius, Player* player, TargetManager* targetManager, float bulletRad) : Entity(mesh, material, radius, ENTITY_SPRITE)
 {
 	this->playerRef = player;
 	this->targetRef = targetManager;
-	this->blend = blend;
 	this->bulletRadSq = pow(bulletRad, 2.0f);
 	this->SetRotation(0.0f, XM_PI, 0.0f);
 }
@@ -14,7 +14,6 @@ Reticule::Reticule(Mesh* mesh, Material* material, Player* player, TargetManager
 
 Reticule::~Reticule()
 {
-	blend->Release();
 }
 
 void Reticule::Update(float deltaTime, float totalTime)
@@ -23,7 +22,7 @@ void Reticule::Update(float deltaTime, float totalTime)
 
 	//Build list of targets in the path of the player
 	vector<Entity*> inRange = vector<Entity*>();
-	for each (Entity* t in targetRef->GetTargets())
+	for (Entity* t : targetRef->GetTargets())
 	{
 		//Check active
 		if (!t->IsActive()) continue;
@@ -64,29 +63,3 @@ void Reticule::Update(float deltaTime, float totalTime)
 	}
 
 }
-
-void Reticule::Draw(ID3D11DeviceContext* context, Camera* camera, LightManager* lightManager)
-{
-	SimpleVertexShader* vShader = GetMaterial()->GetVertexShader();
-	SimplePixelShader* pShader = GetMaterial()->GetPixelShader();
-
-	vShader->SetShader();
-	pShader->SetShader();
-
-	vShader->SetMatrix4x4("world", GetWorld());
-	vShader->SetMatrix4x4("view", camera->GetView());
-	vShader->SetMatrix4x4("projection", camera->GetProj());
-
-	pShader->SetShaderResourceView("diffuseTexture", GetMaterial()->GetTexture());
-	pShader->SetSamplerState("basicSampler", GetMaterial()->GetSampler());
-
-	vShader->CopyAllBufferData();
-	pShader->CopyAllBufferData();
-
-	Entity::Draw(context, camera, lightManager);
-}
-
-ID3D11BlendState* Reticule::GetBlend()
-{
-	return blend;
-}
\ No newline at end of file
@@ -7,18 +7,14 @@
 class Reticule : public Entity
 {
 public:
-	Reticule(Mesh* mesh, Material* material, Player* player, TargetManager* targetManager, ID3D11BlendState* blend, float bulletRad);
+	Reticule(int mesh, int material, float radius, Player* player, TargetManager* targetManager, float bulletRad);
 	~Reticule();
 
 	void Update(float deltaTime, float totalTime) override;
-	void Draw(ID3D11DeviceContext* context, Camera* camera, LightManager* lightManager) override;
-
-	ID3D11BlendState* GetBlend();
 
 private:
 	Player* playerRef;
 	TargetManager* targetRef;
-	ID3D11BlendState* blend;
 	float bulletRadSq;
 };
 
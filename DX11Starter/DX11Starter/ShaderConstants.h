@@ -0,0 +1,403 @@
+// Generated by Tools/GenerateShaderConstants.py from the cbuffers in the .hlsl
+// files.  Don't edit by hand, rerun it after changing a cbuffer.
+#pragma once
+
+#include <cstddef>
+#include "Portable.h"
+#include "Lights.h"
+
+// The C++ light structs have to match the HLSL ones
+static_assert(sizeof(DirectionalLight) == 60, "DirectionalLight doesn't match HLSL");
+static_assert(sizeof(PointLight) == 64, "PointLight doesn't match HLSL");
+
+// A cbuffer member's offset and size, or with a null Variable the
+// whole cbuffer's size
+struct ShaderConstantInfo
+{
+	const char* Buffer;
+	const char* Variable;
+	unsigned int Offset;
+	unsigned int Size;
+};
+
+struct ShaderConstantLayout
+{
+	const char* Shader;		// The .hlsl file's name, without the extension
+	const ShaderConstantInfo* Members;
+	unsigned int Count;
+};
+
+// BloomPS.hlsl
+namespace BloomPS
+{
+	// register(b0)
+	struct Data
+	{
+		float clipValue;
+		unsigned char _pad0[12];
+	};
+	static_assert(offsetof(Data, clipValue) == 0, "Data.clipValue is at the wrong offset");
+	static_assert(sizeof(Data) == 16, "Data is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "Data", 0, 0, 16 },
+		{ "Data", "clipValue", 0, 4 },
+	};
+}
+
+// BlurPS.hlsl
+namespace BlurPS
+{
+	// register(b0)
+	struct Data
+	{
+		DirectX::XMFLOAT2 passDir;
+		float pixelWidth;
+		float pixelHeight;
+	};
+	static_assert(offsetof(Data, passDir) == 0, "Data.passDir is at the wrong offset");
+	static_assert(offsetof(Data, pixelWidth) == 8, "Data.pixelWidth is at the wrong offset");
+	static_assert(offsetof(Data, pixelHeight) == 12, "Data.pixelHeight is at the wrong offset");
+	static_assert(sizeof(Data) == 16, "Data is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "Data", 0, 0, 16 },
+		{ "Data", "passDir", 0, 8 },
+		{ "Data", "pixelWidth", 8, 4 },
+		{ "Data", "pixelHeight", 12, 4 },
+	};
+}
+
+// BulletInstancedPS.hlsl
+namespace BulletInstancedPS
+{
+	// register(b1)
+	struct perFrame
+	{
+		unsigned char _pad0[192];
+		DirectX::XMFLOAT4 cameraPosition;
+	};
+	static_assert(offsetof(perFrame, cameraPosition) == 192, "perFrame.cameraPosition is at the wrong offset");
+	static_assert(sizeof(perFrame) == 208, "perFrame is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "perFrame", 0, 0, 208 },
+		{ "perFrame", "cameraPosition", 192, 16 },
+	};
+}
+
+// BulletInstancedVS.hlsl
+namespace BulletInstancedVS
+{
+	// register(b1)
+	struct perFrame
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 projection;
+	};
+	static_assert(offsetof(perFrame, view) == 0, "perFrame.view is at the wrong offset");
+	static_assert(offsetof(perFrame, projection) == 64, "perFrame.projection is at the wrong offset");
+	static_assert(sizeof(perFrame) == 128, "perFrame is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "perFrame", 0, 0, 128 },
+		{ "perFrame", "view", 0, 64 },
+		{ "perFrame", "projection", 64, 64 },
+	};
+}
+
+// BulletPS.hlsl
+namespace BulletPS
+{
+	// register(b0)
+	struct perObject
+	{
+		PointLight bulletLight;
+	};
+	static_assert(offsetof(perObject, bulletLight) == 0, "perObject.bulletLight is at the wrong offset");
+	static_assert(sizeof(perObject) == 64, "perObject is the wrong size");
+
+	// register(b1)
+	struct perFrame
+	{
+		unsigned char _pad0[192];
+		DirectX::XMFLOAT4 cameraPosition;
+	};
+	static_assert(offsetof(perFrame, cameraPosition) == 192, "perFrame.cameraPosition is at the wrong offset");
+	static_assert(sizeof(perFrame) == 208, "perFrame is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "perObject", 0, 0, 64 },
+		{ "perObject", "bulletLight", 0, 64 },
+		{ "perFrame", 0, 0, 208 },
+		{ "perFrame", "cameraPosition", 192, 16 },
+	};
+}
+
+// BulletVS.hlsl
+namespace BulletVS
+{
+	// register(b0)
+	struct perObject
+	{
+		DirectX::XMFLOAT4X4 world;
+		DirectX::XMFLOAT4X4 normalWorld;
+	};
+	static_assert(offsetof(perObject, world) == 0, "perObject.world is at the wrong offset");
+	static_assert(offsetof(perObject, normalWorld) == 64, "perObject.normalWorld is at the wrong offset");
+	static_assert(sizeof(perObject) == 128, "perObject is the wrong size");
+
+	// register(b1)
+	struct perFrame
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 projection;
+	};
+	static_assert(offsetof(perFrame, view) == 0, "perFrame.view is at the wrong offset");
+	static_assert(offsetof(perFrame, projection) == 64, "perFrame.projection is at the wrong offset");
+	static_assert(sizeof(perFrame) == 128, "perFrame is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "perObject", 0, 0, 128 },
+		{ "perObject", "world", 0, 64 },
+		{ "perObject", "normalWorld", 64, 64 },
+		{ "perFrame", 0, 0, 128 },
+		{ "perFrame", "view", 0, 64 },
+		{ "perFrame", "projection", 64, 64 },
+	};
+}
+
+// ParticleVS.hlsl
+namespace ParticleVS
+{
+	// register(b1)
+	struct perFrame
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 projection;
+	};
+	static_assert(offsetof(perFrame, view) == 0, "perFrame.view is at the wrong offset");
+	static_assert(offsetof(perFrame, projection) == 64, "perFrame.projection is at the wrong offset");
+	static_assert(sizeof(perFrame) == 128, "perFrame is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "perFrame", 0, 0, 128 },
+		{ "perFrame", "view", 0, 64 },
+		{ "perFrame", "projection", 64, 64 },
+	};
+}
+
+// ShipInstancedPS.hlsl
+namespace ShipInstancedPS
+{
+	// register(b1)
+	struct perFrame
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 projection;
+		DirectionalLight dirLight;
+		unsigned char _pad0[4];
+		DirectX::XMFLOAT4 cameraPosition;
+	};
+	static_assert(offsetof(perFrame, view) == 0, "perFrame.view is at the wrong offset");
+	static_assert(offsetof(perFrame, projection) == 64, "perFrame.projection is at the wrong offset");
+	static_assert(offsetof(perFrame, dirLight) == 128, "perFrame.dirLight is at the wrong offset");
+	static_assert(offsetof(perFrame, cameraPosition) == 192, "perFrame.cameraPosition is at the wrong offset");
+	static_assert(sizeof(perFrame) == 208, "perFrame is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "perFrame", 0, 0, 208 },
+		{ "perFrame", "view", 0, 64 },
+		{ "perFrame", "projection", 64, 64 },
+		{ "perFrame", "dirLight", 128, 60 },
+		{ "perFrame", "cameraPosition", 192, 16 },
+	};
+}
+
+// ShipInstancedVS.hlsl
+namespace ShipInstancedVS
+{
+	// register(b1)
+	struct perFrame
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 projection;
+	};
+	static_assert(offsetof(perFrame, view) == 0, "perFrame.view is at the wrong offset");
+	static_assert(offsetof(perFrame, projection) == 64, "perFrame.projection is at the wrong offset");
+	static_assert(sizeof(perFrame) == 128, "perFrame is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "perFrame", 0, 0, 128 },
+		{ "perFrame", "view", 0, 64 },
+		{ "perFrame", "projection", 64, 64 },
+	};
+}
+
+// ShipPS.hlsl
+namespace ShipPS
+{
+	// register(b0)
+	struct perObject
+	{
+		DirectX::XMUINT4 lightIndices[16];
+		int pointLightCount;
+		unsigned char _pad0[12];
+	};
+	static_assert(offsetof(perObject, lightIndices) == 0, "perObject.lightIndices is at the wrong offset");
+	static_assert(offsetof(perObject, pointLightCount) == 256, "perObject.pointLightCount is at the wrong offset");
+	static_assert(sizeof(perObject) == 272, "perObject is the wrong size");
+
+	// register(b1)
+	struct perFrame
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 projection;
+		DirectionalLight dirLight;
+		unsigned char _pad0[4];
+		DirectX::XMFLOAT4 cameraPosition;
+	};
+	static_assert(offsetof(perFrame, view) == 0, "perFrame.view is at the wrong offset");
+	static_assert(offsetof(perFrame, projection) == 64, "perFrame.projection is at the wrong offset");
+	static_assert(offsetof(perFrame, dirLight) == 128, "perFrame.dirLight is at the wrong offset");
+	static_assert(offsetof(perFrame, cameraPosition) == 192, "perFrame.cameraPosition is at the wrong offset");
+	static_assert(sizeof(perFrame) == 208, "perFrame is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "perObject", 0, 0, 272 },
+		{ "perObject", "lightIndices", 0, 256 },
+		{ "perObject", "pointLightCount", 256, 4 },
+		{ "perFrame", 0, 0, 208 },
+		{ "perFrame", "view", 0, 64 },
+		{ "perFrame", "projection", 64, 64 },
+		{ "perFrame", "dirLight", 128, 60 },
+		{ "perFrame", "cameraPosition", 192, 16 },
+	};
+}
+
+// ShipVS.hlsl
+namespace ShipVS
+{
+	// register(b0)
+	struct perObject
+	{
+		DirectX::XMFLOAT4X4 world;
+		DirectX::XMFLOAT4X4 normalWorld;
+	};
+	static_assert(offsetof(perObject, world) == 0, "perObject.world is at the wrong offset");
+	static_assert(offsetof(perObject, normalWorld) == 64, "perObject.normalWorld is at the wrong offset");
+	static_assert(sizeof(perObject) == 128, "perObject is the wrong size");
+
+	// register(b1)
+	struct perFrame
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 projection;
+	};
+	static_assert(offsetof(perFrame, view) == 0, "perFrame.view is at the wrong offset");
+	static_assert(offsetof(perFrame, projection) == 64, "perFrame.projection is at the wrong offset");
+	static_assert(sizeof(perFrame) == 128, "perFrame is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "perObject", 0, 0, 128 },
+		{ "perObject", "world", 0, 64 },
+		{ "perObject", "normalWorld", 64, 64 },
+		{ "perFrame", 0, 0, 128 },
+		{ "perFrame", "view", 0, 64 },
+		{ "perFrame", "projection", 64, 64 },
+	};
+}
+
+// SkyboxVS.hlsl
+namespace SkyboxVS
+{
+	// register(b1)
+	struct perFrame
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 projection;
+	};
+	static_assert(offsetof(perFrame, view) == 0, "perFrame.view is at the wrong offset");
+	static_assert(offsetof(perFrame, projection) == 64, "perFrame.projection is at the wrong offset");
+	static_assert(sizeof(perFrame) == 128, "perFrame is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "perFrame", 0, 0, 128 },
+		{ "perFrame", "view", 0, 64 },
+		{ "perFrame", "projection", 64, 64 },
+	};
+}
+
+// VertexShader.hlsl
+namespace VertexShader
+{
+	// register(b0)
+	struct perObject
+	{
+		DirectX::XMFLOAT4X4 world;
+	};
+	static_assert(offsetof(perObject, world) == 0, "perObject.world is at the wrong offset");
+	static_assert(sizeof(perObject) == 64, "perObject is the wrong size");
+
+	// register(b1)
+	struct perFrame
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 projection;
+	};
+	static_assert(offsetof(perFrame, view) == 0, "perFrame.view is at the wrong offset");
+	static_assert(offsetof(perFrame, projection) == 64, "perFrame.projection is at the wrong offset");
+	static_assert(sizeof(perFrame) == 128, "perFrame is the wrong size");
+
+	// What reflection on the compiled shader should report
+	static const ShaderConstantInfo Reflection[] =
+	{
+		{ "perObject", 0, 0, 64 },
+		{ "perObject", "world", 0, 64 },
+		{ "perFrame", 0, 0, 128 },
+		{ "perFrame", "view", 0, 64 },
+		{ "perFrame", "projection", 64, 64 },
+	};
+}
+
+// Every shader above
+static const ShaderConstantLayout ShaderConstantLayouts[] =
+{
+	{ "BloomPS", BloomPS::Reflection, sizeof(BloomPS::Reflection) / sizeof(ShaderConstantInfo) },
+	{ "BlurPS", BlurPS::Reflection, sizeof(BlurPS::Reflection) / sizeof(ShaderConstantInfo) },
+	{ "BulletInstancedPS", BulletInstancedPS::Reflection, sizeof(BulletInstancedPS::Reflection) / sizeof(ShaderConstantInfo) },
+	{ "BulletInstancedVS", BulletInstancedVS::Reflection, sizeof(BulletInstancedVS::Reflection) / sizeof(ShaderConstantInfo) },
+	{ "BulletPS", BulletPS::Reflection, sizeof(BulletPS::Reflection) / sizeof(ShaderConstantInfo) },
+	{ "BulletVS", BulletVS::Reflection, sizeof(BulletVS::Reflection) / sizeof(ShaderConstantInfo) },
+	{ "ParticleVS", ParticleVS::Reflection, sizeof(ParticleVS::Reflection) / sizeof(ShaderConstantInfo) },
+	{ "ShipInstancedPS", ShipInstancedPS::Reflection, sizeof(ShipInstancedPS::Reflection) / sizeof(ShaderConstantInfo) },
+	{ "ShipInstancedVS", ShipInstancedVS::Reflection, sizeof(ShipInstancedVS::Reflection) / sizeof(ShaderConstantInfo) },
+	{ "ShipPS", ShipPS::Reflection, sizeof(ShipPS::Reflection) / sizeof(ShaderConstantInfo) },
+	{ "ShipVS", ShipVS::Reflection, sizeof(ShipVS::Reflection) / sizeof(ShaderConstantInfo) },
+	{ "SkyboxVS", SkyboxVS::Reflection, sizeof(SkyboxVS::Reflection) / sizeof(ShaderConstantInfo) },
+	{ "VertexShader", VertexShader::Reflection, sizeof(VertexShader::Reflection) / sizeof(ShaderConstantInfo) },
+};
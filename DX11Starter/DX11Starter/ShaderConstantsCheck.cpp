@@ -0,0 +1,64 @@
+#include "ShaderConstantsCheck.h"
+#include "ShaderConstants.h"
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include <stdio.h>
+#include <string>
+
+using namespace std;
+
+int CheckShaderConstants()
+{
+	int differences = 0;
+	for (const ShaderConstantLayout& layout : ShaderConstantLayouts)
+	{
+		string file = string(layout.Shader) + ".cso";
+		wstring wideFile(file.begin(), file.end());
+		ID3DBlob* blob = 0;
+		if (D3DReadFileToBlob(wideFile.c_str(), &blob) != S_OK)
+		{
+			printf("\nShaderConstants: couldn't open %s", file.c_str());
+			differences++;
+			continue;
+		}
+
+		ID3D11ShaderReflection* refl = 0;
+		D3DReflect(blob->GetBufferPointer(), blob->GetBufferSize(), IID_ID3D11ShaderReflection, (void**)&refl);
+		for (unsigned int i = 0; i < layout.Count; i++)
+		{
+			const ShaderConstantInfo& info = layout.Members[i];
+
+			//An unknown name gives back a dummy whose GetDesc fails
+			D3D11_SHADER_BUFFER_DESC bufferDesc;
+			ID3D11ShaderReflectionConstantBuffer* cb = refl->GetConstantBufferByName(info.Buffer);
+			if (FAILED(cb->GetDesc(&bufferDesc)))
+				continue;
+
+			unsigned int offset = 0;
+			unsigned int size = bufferDesc.Size;
+			if (info.Variable)
+			{
+				D3D11_SHADER_VARIABLE_DESC varDesc;
+				if (FAILED(cb->GetVariableByName(info.Variable)->GetDesc(&varDesc)))
+				{
+					printf("\nShaderConstants: %s has no %s.%s", file.c_str(), info.Buffer, info.Variable);
+					differences++;
+					continue;
+				}
+				offset = varDesc.StartOffset;
+				size = varDesc.Size;
+			}
+
+			if (offset != info.Offset || size != info.Size)
+			{
+				printf("\nShaderConstants: %s %s%s%s is %u bytes at %u, the header has %u at %u",
+					file.c_str(), info.Buffer, info.Variable ? "." : "", info.Variable ? info.Variable : "",
+					size, offset, info.Size, info.Offset);
+				differences++;
+			}
+		}
+		refl->Release();
+		blob->Release();
+	}
+	return differences;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// --------------------------------------------------------
+// Compares ShaderConstants.h with the reflection data in the
+// compiled shaders (the .cso files in the working directory),
+// printing each offset or size that differs.  Cbuffers the
+// compiler stripped out aren't checked.
+//
+// Returns the number of differences
+// --------------------------------------------------------
+int CheckShaderConstants();
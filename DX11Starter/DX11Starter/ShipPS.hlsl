@@ -24,15 +24,25 @@ struct PointLight {
 	float  radius;
 };
 
-// Constant Buffer
-cbuffer externalData : register(b0)
+// Constant Buffers
+cbuffer perObject : register(b0)
 {
-	DirectionalLight dirLight;
-	PointLight lightList[64];
+	uint4 lightIndices[16];		// Which lights reach this object, four per element
 	int pointLightCount;
+};
+
+// Changes once a frame, shared by every shader (FrameConstantData in C++)
+cbuffer perFrame : register(b1)
+{
+	matrix view;
+	matrix projection;
+	DirectionalLight dirLight;
 	float4 cameraPosition;
 };
 
+// Every point light in the scene, packed once a frame
+StructuredBuffer<PointLight> lights : register(t2);
+
 Texture2D diffuseTexture  : register(t0);
 Texture2D normalMap       : register(t1);
 SamplerState basicSampler : register(s0);
@@ -87,7 +97,7 @@ float4 main(VertexToPixel input) : SV_TARGET
 
 	for (int i = 0; i < pointLightCount; i++)
 	{
-		light += calcPointLight(lightList[i], input.worldPos, normal);
+		light += calcPointLight(lights[lightIndices[i / 4][i % 4]], input.worldPos, normal);
 	}
 
 	return surfaceColor * light;
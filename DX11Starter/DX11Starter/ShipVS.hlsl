@@ -1,11 +1,16 @@
 
 // Constant Buffer
-cbuffer externalData : register(b0)
+cbuffer perObject : register(b0)
 {
 	matrix world;
+	matrix normalWorld;
+};
+
+// Changes once a frame, shared by every shader (FrameConstantData in C++)
+cbuffer perFrame : register(b1)
+{
 	matrix view;
 	matrix projection;
-	matrix normalWorld;
 };
 
 // Struct representing a single vertex worth of data
@@ -1,4 +1,5 @@
 #include "SimpleShader.h"
+#include "Profiler.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // ------ BASE SIMPLE SHADER --------------------------------------------------
@@ -12,11 +13,13 @@ ISimpleShader::ISimpleShader(ID3D11Device* device, ID3D11DeviceContext* context)
 	// Save the device
 	this->device = device;
 	this->deviceContext = context;
+	uploadTarget = new D3DStateTarget(context);
 
 	// Set up fields
 	constantBufferCount = 0;
 	constantBuffers = 0;
 	shaderBlob = 0;
+	stateCache = 0;
 }
 
 // --------------------------------------------------------
@@ -27,6 +30,8 @@ ISimpleShader::~ISimpleShader()
 	// Derived class destructors will call this class's CleanUp method
 	if(shaderBlob)
 		shaderBlob->Release();
+
+	delete uploadTarget;
 }
 
 // --------------------------------------------------------
@@ -39,7 +44,7 @@ void ISimpleShader::CleanUp()
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
 		constantBuffers[i].ConstantBuffer->Release();
-		delete[] constantBuffers[i].LocalDataBuffer;
+		delete constantBuffers[i].LocalData;
 	}
 
 	if (constantBuffers)
@@ -56,6 +61,7 @@ void ISimpleShader::CleanUp()
 
 	// Clean up tables
 	varTable.clear();
+	variables.clear();
 	cbTable.clear();
 	samplerTable.clear();
 	textureTable.clear();
@@ -116,6 +122,8 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		switch (resourceDesc.Type)
 		{
 		case D3D_SIT_TEXTURE: // A texture resource
+		case D3D_SIT_STRUCTURED: // Structured and raw buffers are bound through SRVs too
+		case D3D_SIT_BYTEADDRESS:
 		{
 			// Create the SRV wrapper
 			SimpleSRV* srv = new SimpleSRV();
@@ -174,8 +182,8 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 
 		// Set up the data buffer for this constant buffer
 		constantBuffers[b].Size = bufferDesc.Size;
-		constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
-		ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
+		constantBuffers[b].LocalData = new ConstantBufferData(bufferDesc.Size, constantBuffers[b].Name == "perObject");
+		constantBuffers[b].External = false;
 
 		// Loop through all variables in this buffer
 		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
@@ -190,6 +198,7 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 
 			// Create the variable struct
 			SimpleShaderVariable varStruct;
+			varStruct.Index = (unsigned int)variables.size();
 			varStruct.ConstantBufferIndex = b;
 			varStruct.ByteOffset = varDesc.StartOffset;
 			varStruct.Size = varDesc.Size;
@@ -200,6 +209,7 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 			// Add this variable to the table and the constant buffer
 			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
 			constantBuffers[b].Variables.push_back(varStruct);
+			variables.push_back(varStruct);
 		}
 	}
 
@@ -273,16 +283,15 @@ void ISimpleShader::SetShader()
 // --------------------------------------------------------
 void ISimpleShader::CopyAllBufferData()
 {
+	PROFILE_SCOPE("CopyAllBufferData");
+
 	// Ensure the shader is valid
 	if (!shaderValid) return;
 
-	// Loop through the constant buffers and copy all data
+	// Loop through the constant buffers and copy any that changed
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer, 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
+		UploadBuffer(&constantBuffers[i]);
 	}
 }
 
@@ -310,10 +319,8 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 	SimpleConstantBuffer* cb = &this->constantBuffers[index];
 	if (!cb) return;
 
-	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer, 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	// Copy the data (if it changed) and get out
+	UploadBuffer(cb);
 }
 
 // --------------------------------------------------------
@@ -332,10 +339,52 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	SimpleConstantBuffer* cb = this->FindConstantBuffer(bufferName);
 	if (!cb) return;
 
-	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer, 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	// Copy the data (if it changed) and get out
+	UploadBuffer(cb);
+}
+
+// --------------------------------------------------------
+// Copies a constant buffer's local data to the GPU, unless
+// nothing has been written to it since the last copy
+// --------------------------------------------------------
+void ISimpleShader::UploadBuffer(SimpleConstantBuffer* cb)
+{
+	// Shared buffers are filled by their owner
+	if (cb->External)
+		return;
+
+	cb->LocalData->Upload(uploadTarget, cb->ConstantBuffer);
+}
+
+// --------------------------------------------------------
+// Swaps one of this shader's constant buffers for a buffer
+// owned elsewhere (and shared with other shaders)
+//
+// bufferName - The name of the cbuffer in the shader
+// buffer - The buffer to bind instead, at least as big
+//
+// Returns false if the shader has no cbuffer of that name
+// --------------------------------------------------------
+bool ISimpleShader::UseExternalBuffer(std::string bufferName, ID3D11Buffer* buffer)
+{
+	SimpleConstantBuffer* cb = FindConstantBuffer(bufferName);
+	if (!cb) return false;
+
+	// Hold a reference, since CleanUp releases whatever is in here
+	buffer->AddRef();
+	cb->ConstantBuffer->Release();
+	cb->ConstantBuffer = buffer;
+	cb->External = true;
+	return true;
+}
+
+// --------------------------------------------------------
+// Copies a variable's new value into its local data buffer.
+// Writing the same bytes again leaves the buffer clean
+// --------------------------------------------------------
+void ISimpleShader::WriteVariable(const SimpleShaderVariable* var, const void* data)
+{
+	constantBuffers[var->ConstantBufferIndex].LocalData->Write(var->ByteOffset, data, var->Size);
 }
 
 
@@ -357,10 +406,7 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 		return false;
 
 	// Set the data in the local data buffer
-	memcpy(
-		constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
-		data,
-		size);
+	WriteVariable(var, data);
 
 	// Success
 	return true;
@@ -446,6 +492,162 @@ bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 dat
 	return this->SetData(name, &data, sizeof(float) * 16);
 }
 
+// --------------------------------------------------------
+// Gets the handle of a constant buffer (its index), or
+// SIMPLE_SHADER_INVALID_HANDLE if it doesn't exist
+//
+// bufferName - the name of the cbuffer
+// --------------------------------------------------------
+SimpleShaderHandle ISimpleShader::GetBufferHandle(std::string bufferName)
+{
+	SimpleConstantBuffer* cb = FindConstantBuffer(bufferName);
+	if (cb == 0)
+		return SIMPLE_SHADER_INVALID_HANDLE;
+
+	return (SimpleShaderHandle)(cb - constantBuffers);
+}
+
+// --------------------------------------------------------
+// Gets the handle of a variable, or SIMPLE_SHADER_INVALID_HANDLE
+// if it doesn't exist.  Look handles up once, not every frame
+//
+// name - the name of the variable
+// --------------------------------------------------------
+SimpleShaderHandle ISimpleShader::GetVariableHandle(std::string name)
+{
+	SimpleShaderVariable* var = FindVariable(name, -1);
+	if (var == 0)
+		return SIMPLE_SHADER_INVALID_HANDLE;
+
+	return var->Index;
+}
+
+// --------------------------------------------------------
+// Gets the handle of an SRV, or SIMPLE_SHADER_INVALID_HANDLE
+//
+// name - the name of the SRV
+// --------------------------------------------------------
+SimpleShaderHandle ISimpleShader::GetShaderResourceViewHandle(std::string name)
+{
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
+	if (srvInfo == 0)
+		return SIMPLE_SHADER_INVALID_HANDLE;
+
+	return srvInfo->Index;
+}
+
+// --------------------------------------------------------
+// Gets the handle of a sampler, or SIMPLE_SHADER_INVALID_HANDLE
+//
+// name - the name of the sampler
+// --------------------------------------------------------
+SimpleShaderHandle ISimpleShader::GetSamplerHandle(std::string name)
+{
+	const SimpleSampler* sampInfo = GetSamplerInfo(name);
+	if (sampInfo == 0)
+		return SIMPLE_SHADER_INVALID_HANDLE;
+
+	return sampInfo->Index;
+}
+
+// --------------------------------------------------------
+// Sets a variable by handle in the local data buffer
+//
+// handle - from GetVariableHandle on this shader
+// data - the data to copy
+// size - the size of the data, which must match the variable
+//
+// Returns true if the handle is valid and the size matches
+// --------------------------------------------------------
+bool ISimpleShader::SetData(SimpleShaderHandle handle, const void* data, unsigned int size)
+{
+	// Valid handle?
+	if (handle < 0 || handle >= (int)variables.size())
+		return false;
+
+	// Is the data size correct?
+	const SimpleShaderVariable& var = variables[handle];
+	if (var.Size != size)
+		return false;
+
+	// Set the data in the local data buffer
+	WriteVariable(&var, data);
+
+	// Success
+	return true;
+}
+
+// --------------------------------------------------------
+// Replaces the whole local data buffer of a constant buffer
+//
+// handle - from GetBufferHandle on this shader
+// data - the new contents, laid out like the cbuffer
+// size - the size of the data, which must match the buffer
+//
+// Returns true if the handle is valid and the size matches
+// --------------------------------------------------------
+bool ISimpleShader::SetBufferData(SimpleShaderHandle handle, const void* data, unsigned int size)
+{
+	// Valid handle?
+	if (handle < 0 || handle >= (int)constantBufferCount)
+		return false;
+
+	// Is the data size correct?
+	SimpleConstantBuffer* cb = &constantBuffers[handle];
+	if (cb->Size != size)
+		return false;
+
+	// Only dirties the buffer if something actually changed
+	cb->LocalData->Write(0, data, size);
+	return true;
+}
+
+// --------------------------------------------------------
+// Replaces the whole local data buffer of a constant buffer
+//
+// bufferName - the name of the cbuffer
+// data - the new contents, laid out like the cbuffer
+// size - the size of the data, which must match the buffer
+// --------------------------------------------------------
+bool ISimpleShader::SetBufferData(std::string bufferName, const void* data, unsigned int size)
+{
+	return SetBufferData(GetBufferHandle(bufferName), data, size);
+}
+
+// --------------------------------------------------------
+// Sets INT, FLOAT, FLOAT2, FLOAT3, FLOAT4 and MATRIX (4x4)
+// variables by handle in the local data buffer
+// --------------------------------------------------------
+bool ISimpleShader::SetInt(SimpleShaderHandle handle, int data)
+{
+	return this->SetData(handle, &data, sizeof(int));
+}
+
+bool ISimpleShader::SetFloat(SimpleShaderHandle handle, float data)
+{
+	return this->SetData(handle, &data, sizeof(float));
+}
+
+bool ISimpleShader::SetFloat2(SimpleShaderHandle handle, const DirectX::XMFLOAT2 data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 2);
+}
+
+bool ISimpleShader::SetFloat3(SimpleShaderHandle handle, const DirectX::XMFLOAT3 data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 3);
+}
+
+bool ISimpleShader::SetFloat4(SimpleShaderHandle handle, const DirectX::XMFLOAT4 data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 4);
+}
+
+bool ISimpleShader::SetMatrix4x4(SimpleShaderHandle handle, const DirectX::XMFLOAT4X4 data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 16);
+}
+
 // --------------------------------------------------------
 // Gets info about a shader variable, if it exists
 // --------------------------------------------------------
@@ -675,6 +877,11 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
 		refl->GetInputParameterDesc(i, &paramDesc);
 
+		// System values (like SV_VertexID) are generated by the
+		// input assembler, so they don't belong in the layout
+		if (paramDesc.SystemValueType != D3D_NAME_UNDEFINED)
+			continue;
+
 		// Check the semantic name for "_PER_INSTANCE"
 		std::string perInstanceStr = "_PER_INSTANCE";
 		std::string sem = paramDesc.SemanticName;
@@ -732,6 +939,13 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 		inputLayoutDesc.push_back(elementDesc);
 	}
 
+	// No vertex data at all?  Then no input layout is needed
+	if (inputLayoutDesc.size() == 0)
+	{
+		refl->Release();
+		return true;
+	}
+
 	// Try to create Input Layout
 	HRESULT hr = device->CreateInputLayout(
 		&inputLayoutDesc[0], 
@@ -754,6 +968,16 @@ void SimpleVertexShader::SetShaderAndCBs()
 	// Is shader valid?
 	if (!shaderValid) return;
 
+	// Let the cache skip whatever's already bound
+	if (stateCache)
+	{
+		stateCache->IASetInputLayout(inputLayout);
+		stateCache->VSSetShader(shader);
+		for (unsigned int i = 0; i < constantBufferCount; i++)
+			stateCache->VSSetConstantBuffer(constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer);
+		return;
+	}
+
 	// Set the shader and input layout
 	deviceContext->IASetInputLayout(inputLayout);
 	deviceContext->VSSetShader(shader, 0, 0);
@@ -784,7 +1008,10 @@ bool SimpleVertexShader::SetShaderResourceView(std::string name, ID3D11ShaderRes
 		return false;
 
 	// Set the shader resource view
-	deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	if (stateCache)
+		stateCache->VSSetShaderResource(srvInfo->BindIndex, srv);
+	else
+		deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, &srv);
 
 	// Success
 	return true;
@@ -806,7 +1033,60 @@ bool SimpleVertexShader::SetSamplerState(std::string name, ID3D11SamplerState* s
 		return false;
 
 	// Set the shader resource view
-	deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	if (stateCache)
+		stateCache->VSSetSampler(sampInfo->BindIndex, samplerState);
+	else
+		deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+
+	// Success
+	return true;
+}
+
+// --------------------------------------------------------
+// Sets a shader resource view in the vertex shader stage by handle
+//
+// handle - From GetShaderResourceViewHandle on this shader
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleVertexShader::SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv)
+{
+	// Handles are raw indices
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo((unsigned int)handle);
+	if (srvInfo == 0)
+		return false;
+
+	// Set the shader resource view
+	if (stateCache)
+		stateCache->VSSetShaderResource(srvInfo->BindIndex, srv);
+	else
+		deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+
+	// Success
+	return true;
+}
+
+// --------------------------------------------------------
+// Sets a sampler state in the vertex shader stage by handle
+//
+// handle - From GetSamplerHandle on this shader
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleVertexShader::SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState)
+{
+	// Handles are raw indices
+	const SimpleSampler* sampInfo = GetSamplerInfo((unsigned int)handle);
+	if (sampInfo == 0)
+		return false;
+
+	// Set the sampler state
+	if (stateCache)
+		stateCache->VSSetSampler(sampInfo->BindIndex, samplerState);
+	else
+		deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
 
 	// Success
 	return true;
@@ -876,6 +1156,15 @@ void SimplePixelShader::SetShaderAndCBs()
 	// Is shader valid?
 	if (!shaderValid) return;
 	
+	// Let the cache skip whatever's already bound
+	if (stateCache)
+	{
+		stateCache->PSSetShader(shader);
+		for (unsigned int i = 0; i < constantBufferCount; i++)
+			stateCache->PSSetConstantBuffer(constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer);
+		return;
+	}
+
 	// Set the shader
 	deviceContext->PSSetShader(shader, 0, 0);
 
@@ -905,7 +1194,10 @@ bool SimplePixelShader::SetShaderResourceView(std::string name, ID3D11ShaderReso
 		return false;
 
 	// Set the shader resource view
-	deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	if (stateCache)
+		stateCache->PSSetShaderResource(srvInfo->BindIndex, srv);
+	else
+		deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, &srv);
 
 	// Success
 	return true;
@@ -927,7 +1219,60 @@ bool SimplePixelShader::SetSamplerState(std::string name, ID3D11SamplerState* sa
 		return false;
 
 	// Set the shader resource view
-	deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	if (stateCache)
+		stateCache->PSSetSampler(sampInfo->BindIndex, samplerState);
+	else
+		deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+
+	// Success
+	return true;
+}
+
+// --------------------------------------------------------
+// Sets a shader resource view in the pixel shader stage by handle
+//
+// handle - From GetShaderResourceViewHandle on this shader
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimplePixelShader::SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv)
+{
+	// Handles are raw indices
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo((unsigned int)handle);
+	if (srvInfo == 0)
+		return false;
+
+	// Set the shader resource view
+	if (stateCache)
+		stateCache->PSSetShaderResource(srvInfo->BindIndex, srv);
+	else
+		deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+
+	// Success
+	return true;
+}
+
+// --------------------------------------------------------
+// Sets a sampler state in the pixel shader stage by handle
+//
+// handle - From GetSamplerHandle on this shader
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimplePixelShader::SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState)
+{
+	// Handles are raw indices
+	const SimpleSampler* sampInfo = GetSamplerInfo((unsigned int)handle);
+	if (sampInfo == 0)
+		return false;
+
+	// Set the sampler state
+	if (stateCache)
+		stateCache->PSSetSampler(sampInfo->BindIndex, samplerState);
+	else
+		deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
 
 	// Success
 	return true;
@@ -1056,6 +1401,50 @@ bool SimpleDomainShader::SetSamplerState(std::string name, ID3D11SamplerState* s
 	return true;
 }
 
+// --------------------------------------------------------
+// Sets a shader resource view in the domain shader stage by handle
+//
+// handle - From GetShaderResourceViewHandle on this shader
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleDomainShader::SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv)
+{
+	// Handles are raw indices
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo((unsigned int)handle);
+	if (srvInfo == 0)
+		return false;
+
+	// Set the shader resource view
+	deviceContext->DSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+
+	// Success
+	return true;
+}
+
+// --------------------------------------------------------
+// Sets a sampler state in the domain shader stage by handle
+//
+// handle - From GetSamplerHandle on this shader
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleDomainShader::SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState)
+{
+	// Handles are raw indices
+	const SimpleSampler* sampInfo = GetSamplerInfo((unsigned int)handle);
+	if (sampInfo == 0)
+		return false;
+
+	// Set the sampler state
+	deviceContext->DSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+
+	// Success
+	return true;
+}
+
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1178,6 +1567,50 @@ bool SimpleHullShader::SetSamplerState(std::string name, ID3D11SamplerState* sam
 	return true;
 }
 
+// --------------------------------------------------------
+// Sets a shader resource view in the hull shader stage by handle
+//
+// handle - From GetShaderResourceViewHandle on this shader
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleHullShader::SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv)
+{
+	// Handles are raw indices
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo((unsigned int)handle);
+	if (srvInfo == 0)
+		return false;
+
+	// Set the shader resource view
+	deviceContext->HSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+
+	// Success
+	return true;
+}
+
+// --------------------------------------------------------
+// Sets a sampler state in the hull shader stage by handle
+//
+// handle - From GetSamplerHandle on this shader
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleHullShader::SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState)
+{
+	// Handles are raw indices
+	const SimpleSampler* sampInfo = GetSamplerInfo((unsigned int)handle);
+	if (sampInfo == 0)
+		return false;
+
+	// Set the sampler state
+	deviceContext->HSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+
+	// Success
+	return true;
+}
+
 
 
 
@@ -1422,6 +1855,50 @@ bool SimpleGeometryShader::SetSamplerState(std::string name, ID3D11SamplerState*
 	return true;
 }
 
+// --------------------------------------------------------
+// Sets a shader resource view in the geometry shader stage by handle
+//
+// handle - From GetShaderResourceViewHandle on this shader
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleGeometryShader::SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv)
+{
+	// Handles are raw indices
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo((unsigned int)handle);
+	if (srvInfo == 0)
+		return false;
+
+	// Set the shader resource view
+	deviceContext->GSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+
+	// Success
+	return true;
+}
+
+// --------------------------------------------------------
+// Sets a sampler state in the geometry shader stage by handle
+//
+// handle - From GetSamplerHandle on this shader
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleGeometryShader::SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState)
+{
+	// Handles are raw indices
+	const SimpleSampler* sampInfo = GetSamplerInfo((unsigned int)handle);
+	if (sampInfo == 0)
+		return false;
+
+	// Set the sampler state
+	deviceContext->GSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+
+	// Success
+	return true;
+}
+
 // --------------------------------------------------------
 // Calculates the number of components specified by a parameter description mask
 //
@@ -1660,6 +2137,50 @@ bool SimpleComputeShader::SetSamplerState(std::string name, ID3D11SamplerState*
 	return true;
 }
 
+// --------------------------------------------------------
+// Sets a shader resource view in the compute shader stage by handle
+//
+// handle - From GetShaderResourceViewHandle on this shader
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleComputeShader::SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv)
+{
+	// Handles are raw indices
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo((unsigned int)handle);
+	if (srvInfo == 0)
+		return false;
+
+	// Set the shader resource view
+	deviceContext->CSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+
+	// Success
+	return true;
+}
+
+// --------------------------------------------------------
+// Sets a sampler state in the compute shader stage by handle
+//
+// handle - From GetSamplerHandle on this shader
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleComputeShader::SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState)
+{
+	// Handles are raw indices
+	const SimpleSampler* sampInfo = GetSamplerInfo((unsigned int)handle);
+	if (sampInfo == 0)
+		return false;
+
+	// Set the sampler state
+	deviceContext->CSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+
+	// Success
+	return true;
+}
+
 // --------------------------------------------------------
 // Sets an unordered access view in the Compute shader stage
 //
@@ -10,12 +10,17 @@
 #include <vector>
 #include <string>
 
+#include "StateCache.h"
+#include "D3DStateTarget.h"
+#include "ConstantBufferData.h"
+
 // --------------------------------------------------------
 // Used by simple shaders to store information about
 // specific variables in constant buffers
 // --------------------------------------------------------
 struct SimpleShaderVariable
 {
+	unsigned int Index;		// The raw index of the variable (also its handle)
 	unsigned int ByteOffset;
 	unsigned int Size;
 	unsigned int ConstantBufferIndex;
@@ -32,10 +37,20 @@ struct SimpleConstantBuffer
 	unsigned int Size;
 	unsigned int BindIndex;
 	ID3D11Buffer* ConstantBuffer;
-	unsigned char* LocalDataBuffer;
+	ConstantBufferData* LocalData;	// Tracks whether it changed since the last copy to the GPU
+	bool External;			// The GPU buffer belongs to someone else, who fills it
 	std::vector<SimpleShaderVariable> Variables;
 };
 
+// --------------------------------------------------------
+// A variable, SRV or sampler looked up by name once, so later
+// sets skip the string and the hash.  Handles are the raw index
+// and only mean something to the shader that made them.
+// SIMPLE_SHADER_INVALID_HANDLE means the name wasn't found
+// --------------------------------------------------------
+typedef int SimpleShaderHandle;
+#define SIMPLE_SHADER_INVALID_HANDLE -1
+
 // --------------------------------------------------------
 // Contains info about a single SRV in a shader
 // --------------------------------------------------------
@@ -70,12 +85,21 @@ public:
 	// Simple helpers
 	bool IsShaderValid() { return shaderValid; }
 
+	// Routes vertex and pixel stage binds through a cache that drops
+	// redundant ones.  Null (the default) talks to the context directly
+	void SetStateCache(StateCache* cache) { stateCache = cache; }
+
 	// Activating the shader and copying data
 	void SetShader();
 	void CopyAllBufferData();
 	void CopyBufferData(unsigned int index);
 	void CopyBufferData(std::string bufferName);
 
+	// Binds someone else's buffer in place of this shader's own copy of a
+	// constant buffer, for data shared between shaders.  The shader never
+	// uploads to it, whoever owns it does
+	bool UseExternalBuffer(std::string bufferName, ID3D11Buffer* buffer);
+
 	// Sets arbitrary shader data
 	bool SetData(std::string name, const void* data, unsigned int size);
 
@@ -90,9 +114,32 @@ public:
 	bool SetMatrix4x4(std::string name, const float data[16]);
 	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
 
+	// Looking up handles, once, for the faster versions below
+	SimpleShaderHandle GetBufferHandle(std::string bufferName);
+	SimpleShaderHandle GetVariableHandle(std::string name);
+	SimpleShaderHandle GetShaderResourceViewHandle(std::string name);
+	SimpleShaderHandle GetSamplerHandle(std::string name);
+
+	// Sets shader data by handle - just a size check and a copy
+	bool SetData(SimpleShaderHandle handle, const void* data, unsigned int size);
+
+	// Replaces a whole constant buffer's local data in one copy, usually
+	// from a struct in ShaderConstants.h.  The size must match exactly
+	bool SetBufferData(SimpleShaderHandle handle, const void* data, unsigned int size);
+	bool SetBufferData(std::string bufferName, const void* data, unsigned int size);
+
+	bool SetInt(SimpleShaderHandle handle, int data);
+	bool SetFloat(SimpleShaderHandle handle, float data);
+	bool SetFloat2(SimpleShaderHandle handle, const DirectX::XMFLOAT2 data);
+	bool SetFloat3(SimpleShaderHandle handle, const DirectX::XMFLOAT3 data);
+	bool SetFloat4(SimpleShaderHandle handle, const DirectX::XMFLOAT4 data);
+	bool SetMatrix4x4(SimpleShaderHandle handle, const DirectX::XMFLOAT4X4 data);
+
 	// Setting shader resources
 	virtual bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv) = 0;
 	virtual bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState) = 0;
+	virtual bool SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv) = 0;
+	virtual bool SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState) = 0;
 
 	// Getting data about variables and resources
 	const SimpleShaderVariable* GetVariableInfo(std::string name);
@@ -114,12 +161,19 @@ public:
 	// Misc getters
 	ID3DBlob* GetShaderBlob() { return shaderBlob; }
 
+	// Constant buffer traffic - call EndFrame once a frame, then
+	// GetLastFrameStats has the totals for the frame just drawn
+	static void EndFrame() { ConstantBufferData::EndFrame(); }
+	static const SimpleBufferStats& GetLastFrameStats() { return ConstantBufferData::GetLastFrameStats(); }
+
 protected:
 	
 	bool shaderValid;
 	ID3DBlob* shaderBlob;
 	ID3D11Device* device;
 	ID3D11DeviceContext* deviceContext;
+	D3DStateTarget* uploadTarget;
+	StateCache* stateCache;
 
 	// Resource counts
 	unsigned int constantBufferCount;
@@ -130,6 +184,7 @@ protected:
 	std::vector<SimpleSampler*>	samplerStates;
 	std::unordered_map<std::string, SimpleConstantBuffer*> cbTable;
 	std::unordered_map<std::string, SimpleShaderVariable> varTable;
+	std::vector<SimpleShaderVariable> variables; // For handle-based lookup
 	std::unordered_map<std::string, SimpleSRV*> textureTable;
 	std::unordered_map<std::string, SimpleSampler*> samplerTable;
 
@@ -142,6 +197,12 @@ protected:
 	// Helpers for finding data by name
 	SimpleShaderVariable* FindVariable(std::string name, int size);
 	SimpleConstantBuffer* FindConstantBuffer(std::string name);
+
+	// Copies into the local data buffer, marking it dirty only if the bytes change
+	void WriteVariable(const SimpleShaderVariable* var, const void* data);
+
+	// Uploads a buffer if it's dirty, and counts it either way
+	void UploadBuffer(SimpleConstantBuffer* cb);
 };
 
 // --------------------------------------------------------
@@ -159,6 +220,8 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState);
 
 protected:
 	bool perInstanceCompatible;
@@ -182,6 +245,8 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState);
 
 protected:
 	ID3D11PixelShader* shader;
@@ -202,6 +267,8 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState);
 
 protected:
 	ID3D11DomainShader* shader;
@@ -222,6 +289,8 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState);
 
 protected:
 	ID3D11HullShader* shader;
@@ -242,6 +311,8 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState);
 
 	bool CreateCompatibleStreamOutBuffer(ID3D11Buffer** buffer, int vertexCount);
 
@@ -281,6 +352,8 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState);
 	bool SetUnorderedAccessView(std::string name, ID3D11UnorderedAccessView* uav, unsigned int appendConsumeOffset = -1);
 
 	int GetUnorderedAccessViewIndex(std::string name);
@@ -0,0 +1,233 @@
+#include "Simulation.h"
+#include "Profiler.h"
+#include <math.h>
+
+Simulation::Simulation(const SimulationAssets& assets, JobSystem* jobSystem, Camera* camera, unsigned long long seed)
+{
+	this->camera = camera;
+	score = 0;
+
+	Random::SetGlobalSeed(seed);
+
+	//Emitters just claim a slice of the particle pool
+	particleSystem = new ParticleSystem(jobSystem);
+
+	//Create smoke for targets
+	smoke = new ParticleEmitter(
+		500,							// Max particles
+		50,							// Particles per second
+		0.5f,								// Particle lifetime
+		1,							// Start size
+		0.1f,							// End size
+		XMFLOAT4(1, 0.5f, 0, 0.6f),	// Start color
+		XMFLOAT4(0, 0, 0, 0.5f),		// End color
+		XMFLOAT3(0, 1, 0),				// Start velocity
+		XMFLOAT3(0, 0, 0),				// Start position
+		XMFLOAT3(0, 2, 0),				// Start acceleration
+		particleSystem,
+		assets.Particles,
+		2);
+
+	thruster = new ParticleEmitter(
+		500,							// Max particles
+		50,							// Particles per second
+		0.5f,								// Particle lifetime
+		0.5,							// Start size
+		0.15f,							// End size
+		XMFLOAT4(0.4f, 0.4f, 0.4f, 0.6f),	// Start color
+		XMFLOAT4(0, 0, 0, 0.5f),		// End color
+		XMFLOAT3(0, 0, 1),				// Start velocity
+		XMFLOAT3(0, 0, 0),				// Start position
+		XMFLOAT3(0, 0, 3),				// Start acceleration
+		particleSystem,
+		assets.Particles,
+		0);
+
+	//Make target field
+	targetManager = new TargetManager(assets.Target.Mesh, assets.Target.Material, assets.Target.Radius, smoke, thruster, particleSystem);
+	for (Entity* e : targetManager->GetTargets())
+	{
+		entities.push_back(e);
+	}
+
+	//Make player
+	player = new Player(assets.Player.Mesh, assets.Player.Material, assets.Player.Radius);
+	entities.push_back(player);
+
+	//Make fire control
+	fireManager = new FireManager(assets.Bullet.Mesh, assets.Bullet.Material, assets.Bullet.Radius);
+	for (Entity* b : fireManager->GetBullets())
+	{
+		entities.push_back(b);
+		((Bullet*)b)->Link(player);
+	}
+
+	//Make reticule
+	reticule = new Reticule(assets.Reticule.Mesh, assets.Reticule.Material, assets.Reticule.Radius, player, targetManager, fireManager->GetBullets().at(0)->GetRadius());
+	reticule->SetActive(true);
+	entities.push_back(reticule);
+
+	// Set up particles for player engines
+	leftThruster = new ParticleEmitter(
+		500,							// Max particles
+		50,							// Particles per second
+		0.5f,								// Particle lifetime
+		0.2f,							// Start size
+		0.1f,							// End size
+		XMFLOAT4(0, 0.5f, 1, 0.6f),	// Start color
+		XMFLOAT4(0, 0.5f, 1, 0.2f),		// End color
+		XMFLOAT3(0, 0, -1),				// Start velocity
+		XMFLOAT3(0, 0, 0),				// Start position
+		XMFLOAT3(0, 0, -5),				// Start acceleration
+		particleSystem,
+		assets.Particles,
+		0);
+	//The camera is locked to the ship, so keep its exhaust attached rather than trailing behind
+	leftThruster->SetLocalSpace(true);
+	rightThruster = leftThruster->Clone();
+}
+
+Simulation::~Simulation()
+{
+	//Targets take their emitters with them, and every emitter has to go
+	//before the particle system it's part of
+	for (Entity* e : entities)
+	{
+		delete e;
+	}
+	delete targetManager;
+	delete fireManager;
+	delete smoke;
+	delete thruster;
+	delete leftThruster;
+	delete rightThruster;
+	delete particleSystem;
+}
+
+void Simulation::Step(const GameInput& input, float deltaTime, float totalTime)
+{
+	PROFILE_SCOPE("Simulation step");
+
+	//Where everything was before this step, for drawing in between
+	for (Entity* e : entities)
+	{
+		e->SaveState();
+	}
+
+	fireManager->Fire(deltaTime, totalTime, input.Fire);
+
+	//Player movement control
+	player->Accelerate(input.MoveX * player->accelRate * deltaTime, input.MoveY * player->accelRate * deltaTime, 0);
+	XMFLOAT3 v = player->velocity;
+	player->Move(v.x * deltaTime, v.y * deltaTime, v.z * deltaTime);
+	player->Decelerate(player->decelRate * deltaTime);
+
+	//Update Camera
+	FollowPlayer(player->GetPosition(), deltaTime, totalTime);
+
+	//Keep thrusters close to player
+	leftThruster->SetEmitterPosition(XMFLOAT3(player->GetPosition().x + 0.16f, player->GetPosition().y + 0.15f, player->GetPosition().z - 0.8f));
+	particleSystem->Queue(leftThruster);
+
+	rightThruster->SetEmitterPosition(XMFLOAT3(player->GetPosition().x - 0.16f, player->GetPosition().y + 0.15f, player->GetPosition().z - 0.8f));
+	particleSystem->Queue(rightThruster);
+
+	//Update Entities
+	{
+		PROFILE_SCOPE("Entity update");
+		for (Entity* e : entities)
+		{
+			e->Update(deltaTime, totalTime);
+		}
+	}
+
+	//Simulate every emitter queued above in one go
+	{
+		PROFILE_SCOPE("Particle update");
+		particleSystem->Update(deltaTime, camera);
+	}
+
+	//Collision detection
+	{
+		PROFILE_SCOPE("Collision");
+		CheckForCollisions(fireManager->GetBullets(), targetManager->GetTargets());
+	}
+
+	//Reset level when player passes end
+	if (player->GetPosition().z > levelEnd) {
+		targetManager->ResetTargets();
+		player->SetPosition(player->GetPosition().x, player->GetPosition().y, levelStart);
+		player->ResetInterpolation();
+	}
+}
+
+void Simulation::FollowPlayer(XMFLOAT3 playerPosition, float deltaTime, float totalTime)
+{
+	camera->SetPosition(playerPosition.x / 4.0f, playerPosition.y / 4.0f, playerPosition.z - 4.0f);
+	camera->Update(deltaTime, totalTime, playerPosition);
+}
+
+void Simulation::SetRenderBlend(float blend)
+{
+	for (Entity* e : entities)
+	{
+		e->SetRenderBlend(blend);
+	}
+}
+
+const vector<Entity*>& Simulation::GetEntities()
+{
+	return entities;
+}
+
+int Simulation::GetScore()
+{
+	return score;
+}
+
+Player* Simulation::GetPlayer()
+{
+	return player;
+}
+
+TargetManager* Simulation::GetTargetManager()
+{
+	return targetManager;
+}
+
+FireManager* Simulation::GetFireManager()
+{
+	return fireManager;
+}
+
+Reticule* Simulation::GetReticule()
+{
+	return reticule;
+}
+
+ParticleSystem* Simulation::GetParticleSystem()
+{
+	return particleSystem;
+}
+
+void Simulation::CheckForCollisions(const vector<Entity*>& l1, const vector<Entity*>& l2)
+{
+	for (Entity* e1 : l1) {
+		if (e1->IsActive()) {
+			for (Entity* e2 : l2) {
+				if (e2->IsActive()) {
+					float distX = e1->GetPosition().x - e2->GetPosition().x;
+					float distY = e1->GetPosition().y - e2->GetPosition().y;
+					float distZ = e1->GetPosition().z - e2->GetPosition().z;
+
+					float distV = pow(distX, 2) + pow(distY, 2) + pow(distZ, 2);
+					if (distV < pow((e1->GetRadius() + e2->GetRadius()), 2)) {
+						e1->Collides();
+						e2->Collides();
+						score++;
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include "Portable.h"
+#include "GameInput.h"
+#include "Entity.h"
+#include "Player.h"
+#include "Reticule.h"
+#include "Camera.h"
+#include "JobSystem.h"
+#include "TargetManager.h"
+#include "FireManager.h"
+#include "ParticleEmitter.h"
+#include "ParticleSystem.h"
+
+using namespace std;
+using namespace DirectX;
+
+//Renderer handles for one kind of entity, and its mesh's radius
+struct EntityAsset
+{
+	int Mesh;
+	int Material;
+	float Radius;
+};
+
+//Everything the simulation needs from whoever draws it
+struct SimulationAssets
+{
+	EntityAsset Player;
+	EntityAsset Target;
+	EntityAsset Bullet;
+	EntityAsset Reticule;
+	int Particles;
+};
+
+// --------------------------------------------------------
+// The game world and one step of gameplay: steering and firing
+// from a GameInput, every entity's update, particles, collisions
+// and the level wrapping around.  Makes and owns the entities
+// and emitters, but reads no devices and no keyboard, so it can
+// be stepped as fast as possible with scripted input.  Whatever
+// draws it only reads it.
+// --------------------------------------------------------
+class Simulation
+{
+public:
+	//Every emitter and spawner pulls its own seed from seed, so the same
+	//seed plays out the same way every run
+	Simulation(const SimulationAssets& assets, JobSystem* jobSystem, Camera* camera, unsigned long long seed);
+	~Simulation();
+
+	static const unsigned long long defaultSeed = 1;
+
+	void Step(const GameInput& input, float deltaTime, float totalTime);
+
+	//Keeps the camera behind and slightly towards the player
+	void FollowPlayer(XMFLOAT3 playerPosition, float deltaTime, float totalTime);
+
+	//Sets how far between the last two steps GetRender* is for every entity
+	void SetRenderBlend(float blend);
+
+	//Targets, then the player, then bullets, then the reticule
+	const vector<Entity*>& GetEntities();
+	int GetScore();
+
+	Player* GetPlayer();
+	TargetManager* GetTargetManager();
+	FireManager* GetFireManager();
+	Reticule* GetReticule();
+	ParticleSystem* GetParticleSystem();
+
+private:
+	Player* player;
+	FireManager* fireManager;
+	TargetManager* targetManager;
+	Reticule* reticule;
+	ParticleSystem* particleSystem;
+	Camera* camera;
+	ParticleEmitter* smoke;
+	ParticleEmitter* thruster;
+	ParticleEmitter* leftThruster;
+	ParticleEmitter* rightThruster;
+
+	vector<Entity*> entities;
+	int score;
+
+	const float levelEnd = 350.0f;
+	const float levelStart = -50.0f;
+
+	void CheckForCollisions(const vector<Entity*>& l1, const vector<Entity*>& l2);
+};
@@ -0,0 +1,99 @@
+#include "SimulationBenchmark.h"
+#include "Simulation.h"
+#include "InputScript.h"
+#include "MeshData.h"
+#include "JobSystem.h"
+#include "Camera.h"
+#include "Portable.h"
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+//Reads a model's bounding sphere.  Handles are just the model's
+//number, nothing looks them up without a renderer
+static bool LoadAsset(EntityAsset& asset, int handle, const char* assetFolder, const char* model)
+{
+	string path = string(assetFolder) + "/Models/" + model;
+	MeshData data;
+	if (!data.Load(path.c_str()))
+	{
+		printf("\nSimulation benchmark: couldn't open %s\n", path.c_str());
+		return false;
+	}
+
+	asset.Mesh = handle;
+	asset.Material = handle;
+	asset.Radius = data.Radius;
+	return true;
+}
+
+int RunSimulationBenchmark(int steps, const char* assetFolder)
+{
+	SimulationAssets assets = {};
+	if (!LoadAsset(assets.Player, 0, assetFolder, "SharpClawRacer.obj") ||
+		!LoadAsset(assets.Target, 1, assetFolder, "Enemy.obj") ||
+		!LoadAsset(assets.Bullet, 2, assetFolder, "sphere.obj") ||
+		!LoadAsset(assets.Reticule, 3, assetFolder, "plane.obj"))
+		return 1;
+	assets.Particles = 0;
+
+	//Same camera as the game's window, since particle culling uses it
+	JobSystem* jobSystem = new JobSystem();
+	Camera* camera = new Camera(1280.0f, 720.0f, 0.25f * XM_PI, 0.01f, 100.0f);
+	camera->SetPosition(0, 0, -53.0f);
+	Simulation* simulation = new Simulation(assets, jobSystem, camera, Simulation::defaultSeed);
+
+	float step = 1.0f / 60.0f;
+	InputScript script(Simulation::defaultSeed);
+	vector<double> times(steps);
+	float time = 0.0f;
+	for (int i = 0; i < steps; i++)
+	{
+		GameInput input = script.Next(step);
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		simulation->Step(input, step, time);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+		times[i] = elapsed.count();
+		time += step;
+	}
+
+	double total = 0.0;
+	for (int i = 0; i < steps; i++)
+	{
+		total += times[i];
+	}
+	sort(times.begin(), times.end());
+
+	char report[512];
+	snprintf(report, sizeof(report),
+		"\nSimulation benchmark: %d steps at %.0f Hz on %u thread(s), %.1f ms total, score %d"
+		"\n  ms per step: mean %.4f, min %.4f, median %.4f, 95%% %.4f, 99%% %.4f, max %.4f\n",
+		steps,
+		1.0f / step,
+		jobSystem->GetThreadCount(),
+		total,
+		simulation->GetScore(),
+		steps > 0 ? total / steps : 0.0,
+		steps > 0 ? times[0] : 0.0,
+		steps > 0 ? times[steps / 2] : 0.0,
+		steps > 0 ? times[(steps * 95) / 100] : 0.0,
+		steps > 0 ? times[(steps * 99) / 100] : 0.0,
+		steps > 0 ? times[steps - 1] : 0.0);
+	printf("%s", report);
+
+	FILE* file = 0;
+	if (fopen_s(&file, "benchmark.txt", "a") == 0 && file)
+	{
+		fputs(report, file);
+		fclose(file);
+	}
+
+	delete simulation;
+	delete camera;
+	delete jobSystem;
+	return 0;
+}
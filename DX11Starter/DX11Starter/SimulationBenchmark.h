@@ -0,0 +1,11 @@
+#pragma once
+
+// --------------------------------------------------------
+// Plays the game with an InputScript at 60Hz for steps steps,
+// timing each one, without a window, a device or any waiting.
+// The same seed plays the same game, so runs can be compared.
+// Only the models' bounding spheres are needed, read from
+// assetFolder's Models folder.  Results go to stdout and are
+// added to benchmark.txt.  Returns 0, or 1 if a model is missing.
+// --------------------------------------------------------
+int RunSimulationBenchmark(int steps, const char* assetFolder);
@@ -1,6 +1,7 @@
 
 // Constant Buffer
-cbuffer externalData : register(b0)
+// Changes once a frame, shared by every shader (FrameConstantData in C++)
+cbuffer perFrame : register(b1)
 {
 	matrix view;
 	matrix projection;
@@ -0,0 +1,352 @@
+#include "SoftwarePostProcess.h"
+#include <emmintrin.h>
+#include <math.h>
+#include <chrono>
+
+//Same as the shaders
+static const float blurWeights[15] = { 0.009033f, 0.018476f, 0.033851f, 0.055555f, 0.08167f,
+	0.107545f, 0.126854f, 0.134032f, 0.126854f, 0.107545f,
+	0.08167f, 0.055555f, 0.033851f, 0.018476f, 0.009033f };
+
+static const float radialWeights[16] = { 0.132368f, 0.125279f, 0.106209f, 0.080656f,
+	0.054865f, 0.033431f, 0.018246f, 0.008920f,
+	0.003906f, 0.001532f, 0.000538f, 0.000169f,
+	0.000048f, 0.000012f, 0.000003f, 0.000001f };
+
+SoftwarePostProcess::SoftwarePostProcess(JobSystem* jobSystem)
+{
+	this->jobSystem = jobSystem;
+	time = 0.0;
+}
+
+SoftwarePostProcess::~SoftwarePostProcess()
+{
+}
+
+void SoftwarePostProcess::Run(const FloatImage& scene, FloatImage& result, const Settings& settings)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	const FloatImage* bloomResult = 0;
+	if (settings.Bloom)
+	{
+		Bloom(scene, bright, settings.ClipValue);
+		if (settings.Quantize)
+			Quantize(bright);
+
+		//Smaller bloom keeps the blur the same size on screen
+		const FloatImage* blurSource = &bright;
+		float spacing = 2.0f;
+		if (settings.BloomDownsample > 1)
+		{
+			Downsample(bright, reduced, settings.BloomDownsample);
+			if (settings.Quantize)
+				Quantize(reduced);
+			blurSource = &reduced;
+			spacing /= settings.BloomDownsample;
+		}
+
+		Blur(*blurSource, blurH, true, spacing, settings.BlurTaps);
+		if (settings.Quantize)
+			Quantize(blurH);
+		Blur(blurH, blurV, false, spacing, settings.BlurTaps);
+		if (settings.Quantize)
+			Quantize(blurV);
+		bloomResult = &blurV;
+	}
+
+	const FloatImage* base = &scene;
+	if (settings.RadialBlur)
+	{
+		Radial(scene, radial);
+		if (settings.Quantize)
+			Quantize(radial);
+		base = &radial;
+	}
+
+	Combine(*base, bloomResult, result);
+	if (settings.Quantize)
+		Quantize(result);
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	time = elapsed.count();
+}
+
+void SoftwarePostProcess::Bloom(const FloatImage& src, FloatImage& dst, float clipValue)
+{
+	Resize(dst, src.Width, src.Height);
+	__m128 luma = _mm_set_ps(0.0f, 0.11f, 0.59f, 0.3f);
+
+	//Pixel centres land on texel centres, so no filtering.  Clipped pixels
+	//keep the target's clear colour
+	ForEachTile(src.Width, src.Height, [&](int x0, int y0, int x1, int y1)
+	{
+		for (int y = y0; y < y1; y++)
+		{
+			for (int x = x0; x < x1; x++)
+			{
+				__m128 color = Texel(src, x, y);
+				__m128 l = _mm_mul_ps(color, luma);
+				l = _mm_add_ps(l, _mm_movehl_ps(l, l));
+				l = _mm_add_ss(l, _mm_shuffle_ps(l, l, 1));
+
+				bool clipped = _mm_cvtss_f32(l) - clipValue < 0.0f;
+				_mm_storeu_ps(&dst.Pixels[(y * dst.Width + x) * 4], clipped ? _mm_setzero_ps() : color);
+			}
+		}
+	});
+}
+
+void SoftwarePostProcess::Blur(const FloatImage& src, FloatImage& dst, bool horizontal, float spacing, int taps)
+{
+	Resize(dst, src.Width, src.Height);
+
+	//The middle of the shader's kernel, scaled back up to the full kernel's
+	//total so fewer taps don't darken the bloom
+	taps = taps > 15 ? 15 : (taps < 1 ? 1 : taps | 1);
+	int first = 7 - taps / 2;
+	float full = 0.0f;
+	float kept = 0.0f;
+	for (int i = 0; i < 15; i++)
+	{
+		full += blurWeights[i];
+		kept += i >= first && i < first + taps ? blurWeights[i] : 0.0f;
+	}
+	__m128 weights[15];
+	for (int i = 0; i < taps; i++)
+		weights[i] = _mm_set1_ps(blurWeights[first + i] * full / kept);
+
+	//Offsets fall on whole texels at full size, between two texels along
+	//the blur at smaller sizes
+	int length = horizontal ? src.Width : src.Height;
+	ForEachTile(src.Width, src.Height, [&](int x0, int y0, int x1, int y1)
+	{
+		for (int y = y0; y < y1; y++)
+		{
+			for (int x = x0; x < x1; x++)
+			{
+				float along = (float)(horizontal ? x : y);
+				__m128 sum = _mm_setzero_ps();
+				for (int i = 0; i < taps; i++)
+				{
+					float p = along + (first + i - 7) * spacing;
+					float fp = floorf(p);
+					int a = (int)fp;
+					int b = a + 1;
+					a = a < 0 ? 0 : (a >= length ? length - 1 : a);
+					b = b < 0 ? 0 : (b >= length ? length - 1 : b);
+
+					__m128 ta = horizontal ? Texel(src, a, y) : Texel(src, x, a);
+					__m128 sample = ta;
+					if (p != fp)
+					{
+						__m128 tb = horizontal ? Texel(src, b, y) : Texel(src, x, b);
+						sample = _mm_add_ps(ta, _mm_mul_ps(_mm_sub_ps(tb, ta), _mm_set1_ps(p - fp)));
+					}
+					sum = _mm_add_ps(sum, _mm_mul_ps(weights[i], sample));
+				}
+				_mm_storeu_ps(&dst.Pixels[(y * dst.Width + x) * 4], sum);
+			}
+		}
+	});
+}
+
+void SoftwarePostProcess::Radial(const FloatImage& src, FloatImage& dst)
+{
+	Resize(dst, src.Width, src.Height);
+	__m128 weights[16];
+	float total = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		weights[i] = _mm_set1_ps(2.0f * radialWeights[i]);
+		total += 2.0f * radialWeights[i];
+	}
+
+	ForEachTile(src.Width, src.Height, [&](int x0, int y0, int x1, int y1)
+	{
+		for (int y = y0; y < y1; y++)
+		{
+			float v = (y + 0.5f) / src.Height;
+			for (int x = x0; x < x1; x++)
+			{
+				//Steps towards the middle, further the nearer the edge
+				float u = (x + 0.5f) / src.Width;
+				float toX = 0.5f - u;
+				float toY = 0.5f - v;
+				float factor = sqrtf(toX * toX + toY * toY) - 0.25f;
+				factor = factor < 0.0f ? 0.0f : (factor > 1.0f ? 1.0f : factor);
+				float stepX = factor * toX / 32.0f;
+				float stepY = factor * toY / 32.0f;
+
+				//The middle of the screen doesn't move, every tap is this pixel
+				if (factor == 0.0f)
+				{
+					_mm_storeu_ps(&dst.Pixels[(y * dst.Width + x) * 4], _mm_mul_ps(Texel(src, x, y), _mm_set1_ps(total)));
+					continue;
+				}
+
+				__m128 sum = _mm_setzero_ps();
+				for (int i = 0; i < 16; i++)
+					sum = _mm_add_ps(sum, _mm_mul_ps(weights[i], Sample(src, u + i * stepX, v + i * stepY)));
+				_mm_storeu_ps(&dst.Pixels[(y * dst.Width + x) * 4], sum);
+			}
+		}
+	});
+}
+
+void SoftwarePostProcess::Combine(const FloatImage& base, const FloatImage* bloom, FloatImage& dst)
+{
+	//Screen blend of the bloom over the base, like PPPS
+	Resize(dst, base.Width, base.Height);
+	ForEachTile(base.Width, base.Height, [&](int x0, int y0, int x1, int y1)
+	{
+		for (int y = y0; y < y1; y++)
+		{
+			float v = (y + 0.5f) / base.Height;
+			for (int x = x0; x < x1; x++)
+			{
+				__m128 color = Texel(base, x, y);
+				if (bloom)
+				{
+					__m128 glow = Sample(*bloom, (x + 0.5f) / base.Width, v);
+					color = _mm_add_ps(color, _mm_sub_ps(glow, _mm_mul_ps(color, glow)));
+				}
+				_mm_storeu_ps(&dst.Pixels[(y * dst.Width + x) * 4], color);
+			}
+		}
+	});
+}
+
+void SoftwarePostProcess::Downsample(const FloatImage& src, FloatImage& dst, int factor)
+{
+	//Box filter, what a chain of bilinear halvings comes to
+	Resize(dst, (src.Width + factor - 1) / factor, (src.Height + factor - 1) / factor);
+	ForEachTile(dst.Width, dst.Height, [&](int x0, int y0, int x1, int y1)
+	{
+		for (int y = y0; y < y1; y++)
+		{
+			for (int x = x0; x < x1; x++)
+			{
+				__m128 sum = _mm_setzero_ps();
+				int count = 0;
+				for (int sy = y * factor; sy < (y + 1) * factor && sy < src.Height; sy++)
+				{
+					for (int sx = x * factor; sx < (x + 1) * factor && sx < src.Width; sx++)
+					{
+						sum = _mm_add_ps(sum, Texel(src, sx, sy));
+						count++;
+					}
+				}
+				_mm_storeu_ps(&dst.Pixels[(y * dst.Width + x) * 4], _mm_mul_ps(sum, _mm_set1_ps(1.0f / count)));
+			}
+		}
+	});
+}
+
+void SoftwarePostProcess::Quantize(FloatImage& image)
+{
+	//Saturate, then round to the nearest of 256 levels
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 levels = _mm_set1_ps(255.0f);
+	__m128 inverse = _mm_set1_ps(1.0f / 255.0f);
+	ForEachTile(image.Width, image.Height, [&](int x0, int y0, int x1, int y1)
+	{
+		for (int y = y0; y < y1; y++)
+		{
+			float* row = &image.Pixels[y * image.Width * 4];
+			for (int x = x0; x < x1; x++)
+			{
+				__m128 c = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(row + x * 4), zero), one);
+				__m128i rounded = _mm_cvtps_epi32(_mm_mul_ps(c, levels));
+				_mm_storeu_ps(row + x * 4, _mm_mul_ps(_mm_cvtepi32_ps(rounded), inverse));
+			}
+		}
+	});
+}
+
+float SoftwarePostProcess::Compare(const FloatImage& a, const FloatImage& b, float* maxError)
+{
+	double sum = 0.0;
+	float largest = 0.0f;
+	int count = a.Width * a.Height;
+	if (a.Width == b.Width && a.Height == b.Height)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				float d = fabsf(a.Pixels[i * 4 + c] - b.Pixels[i * 4 + c]);
+				sum += d * d;
+				largest = d > largest ? d : largest;
+			}
+		}
+	}
+	else
+	{
+		//Can't line them up, so they're as different as they can be
+		sum = count * 3.0;
+		largest = 1.0f;
+	}
+
+	if (maxError)
+		*maxError = largest;
+	return count > 0 ? (float)sqrt(sum / (count * 3.0)) : 0.0f;
+}
+
+double SoftwarePostProcess::GetTime()
+{
+	return time;
+}
+
+void SoftwarePostProcess::ForEachTile(int width, int height, const function<void(int, int, int, int)>& work)
+{
+	int tilesX = (width + tileSize - 1) / tileSize;
+	int tilesY = (height + tileSize - 1) / tileSize;
+	jobSystem->ParallelFor(tilesX * tilesY, [&](unsigned int tile)
+	{
+		int x0 = (tile % tilesX) * tileSize;
+		int y0 = (tile / tilesX) * tileSize;
+		int x1 = x0 + tileSize < width ? x0 + tileSize : width;
+		int y1 = y0 + tileSize < height ? y0 + tileSize : height;
+		work(x0, y0, x1, y1);
+	});
+}
+
+void SoftwarePostProcess::Resize(FloatImage& image, int width, int height)
+{
+	image.Width = width;
+	image.Height = height;
+	image.Pixels.resize(width * height * 4);
+}
+
+__m128 SoftwarePostProcess::Texel(const FloatImage& image, int x, int y)
+{
+	return _mm_loadu_ps(&image.Pixels[(y * image.Width + x) * 4]);
+}
+
+__m128 SoftwarePostProcess::Sample(const FloatImage& image, float u, float v)
+{
+	//Bilinear between the four nearest texel centres, clamped at the edges
+	float x = u * image.Width - 0.5f;
+	float y = v * image.Height - 0.5f;
+	float fx = floorf(x);
+	float fy = floorf(y);
+	int x0 = (int)fx;
+	int y0 = (int)fy;
+	int x1 = x0 + 1;
+	int y1 = y0 + 1;
+	x0 = x0 < 0 ? 0 : (x0 >= image.Width ? image.Width - 1 : x0);
+	x1 = x1 < 0 ? 0 : (x1 >= image.Width ? image.Width - 1 : x1);
+	y0 = y0 < 0 ? 0 : (y0 >= image.Height ? image.Height - 1 : y0);
+	y1 = y1 < 0 ? 0 : (y1 >= image.Height ? image.Height - 1 : y1);
+
+	__m128 tx = _mm_set1_ps(x - fx);
+	__m128 a = Texel(image, x0, y0);
+	__m128 b = Texel(image, x1, y0);
+	__m128 c = Texel(image, x0, y1);
+	__m128 d = Texel(image, x1, y1);
+	__m128 top = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), tx));
+	__m128 bottom = _mm_add_ps(c, _mm_mul_ps(_mm_sub_ps(d, c), tx));
+	return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), _mm_set1_ps(y - fy)));
+}
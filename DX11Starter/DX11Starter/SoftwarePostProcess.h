@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <xmmintrin.h>
+#include "JobSystem.h"
+
+using namespace std;
+
+//RGBA float pixels, row by row from the top of the screen
+struct FloatImage
+{
+	int Width;
+	int Height;
+	vector<float> Pixels;
+};
+
+// --------------------------------------------------------
+// The post processing shaders (BloomPS, BlurPS, RadialPS and
+// the PPPS combine) done on the CPU, with SSE on each RGBA
+// pixel and the image split into tiles across the job system.
+// Samples are taken the way the GPU's clamped bilinear sampler
+// takes them, so with 8 bit rounding turned on the output is
+// a golden image for what the GPU draws (to within rounding in
+// the filtering hardware).
+//
+// The blur tap count and bloom resolution can be changed, so
+// cheaper versions of the pipeline can be run against the full
+// one and their error measured.
+// --------------------------------------------------------
+class SoftwarePostProcess
+{
+public:
+	SoftwarePostProcess(JobSystem* jobSystem);
+	~SoftwarePostProcess();
+
+	struct Settings
+	{
+		bool Bloom = true;
+		bool RadialBlur = true;
+		float ClipValue = 0.72f;
+
+		//Odd, up to 15.  Fewer taps drop the outside of the kernel
+		int BlurTaps = 15;
+
+		//Bloom is blurred at 1/BloomDownsample of the screen size, with the
+		//taps spread over the same screen distance
+		int BloomDownsample = 1;
+
+		//Round between passes like the game's R8G8B8A8 targets
+		bool Quantize = true;
+	};
+
+	//The whole chain, in the order the game's frame graph runs it
+	void Run(const FloatImage& scene, FloatImage& result, const Settings& settings);
+
+	//Single passes.  dst is resized to fit
+	void Bloom(const FloatImage& src, FloatImage& dst, float clipValue);
+	void Blur(const FloatImage& src, FloatImage& dst, bool horizontal, float spacing = 2.0f, int taps = 15);
+	void Radial(const FloatImage& src, FloatImage& dst);
+	void Combine(const FloatImage& base, const FloatImage* bloom, FloatImage& dst);
+	void Downsample(const FloatImage& src, FloatImage& dst, int factor);
+	void Quantize(FloatImage& image);
+
+	//Root mean square difference of the RGB channels, and the largest one
+	static float Compare(const FloatImage& a, const FloatImage& b, float* maxError = 0);
+
+	//Last Run
+	double GetTime();
+
+private:
+	JobSystem* jobSystem;
+	const int tileSize = 64;
+	double time;
+
+	//Intermediate images, kept so Run doesn't allocate every time
+	FloatImage bright;
+	FloatImage reduced;
+	FloatImage blurH;
+	FloatImage blurV;
+	FloatImage radial;
+
+	//Runs work(x0, y0, x1, y1) on every tile of a width x height image
+	void ForEachTile(int width, int height, const function<void(int, int, int, int)>& work);
+
+	static void Resize(FloatImage& image, int width, int height);
+	static __m128 Texel(const FloatImage& image, int x, int y);
+	static __m128 Sample(const FloatImage& image, float u, float v);
+};
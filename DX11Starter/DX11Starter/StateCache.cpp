@@ -0,0 +1,221 @@
+#include "StateCache.h"
+#include <string.h>
+
+void* const StateCache::unknownState = (void*)-1;
+
+StateCache::StateCache(StateTarget* target)
+{
+	this->target = target;
+	filtering = true;
+	issuedCalls = 0;
+	filteredCalls = 0;
+	lastIssuedCalls = 0;
+	lastFilteredCalls = 0;
+	Invalidate();
+}
+
+StateCache::~StateCache()
+{
+}
+
+bool StateCache::Changed(bool same)
+{
+	if (filtering && same)
+	{
+		filteredCalls++;
+		return false;
+	}
+	issuedCalls++;
+	return true;
+}
+
+void StateCache::IASetInputLayout(ID3D11InputLayout* layout)
+{
+	if (!Changed(inputLayout == layout))
+		return;
+	target->IASetInputLayout(layout);
+	inputLayout = layout;
+}
+
+void StateCache::VSSetShader(ID3D11VertexShader* shader)
+{
+	if (!Changed(vertexShader == shader))
+		return;
+	target->VSSetShader(shader);
+	vertexShader = shader;
+}
+
+void StateCache::PSSetShader(ID3D11PixelShader* shader)
+{
+	if (!Changed(pixelShader == shader))
+		return;
+	target->PSSetShader(shader);
+	pixelShader = shader;
+}
+
+void StateCache::VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	bool tracked = slot < constantBufferSlots;
+	if (!Changed(tracked && vs.constantBuffers[slot] == buffer))
+		return;
+	target->VSSetConstantBuffers(slot, 1, &buffer);
+	if (tracked) vs.constantBuffers[slot] = buffer;
+}
+
+void StateCache::PSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	bool tracked = slot < constantBufferSlots;
+	if (!Changed(tracked && ps.constantBuffers[slot] == buffer))
+		return;
+	target->PSSetConstantBuffers(slot, 1, &buffer);
+	if (tracked) ps.constantBuffers[slot] = buffer;
+}
+
+void StateCache::VSSetShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv)
+{
+	bool tracked = slot < resourceSlots;
+	if (!Changed(tracked && vs.resources[slot] == srv))
+		return;
+	target->VSSetShaderResources(slot, 1, &srv);
+	if (tracked) vs.resources[slot] = srv;
+}
+
+void StateCache::PSSetShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv)
+{
+	bool tracked = slot < resourceSlots;
+	if (!Changed(tracked && ps.resources[slot] == srv))
+		return;
+	target->PSSetShaderResources(slot, 1, &srv);
+	if (tracked) ps.resources[slot] = srv;
+}
+
+void StateCache::VSSetSampler(unsigned int slot, ID3D11SamplerState* sampler)
+{
+	bool tracked = slot < samplerSlots;
+	if (!Changed(tracked && vs.samplers[slot] == sampler))
+		return;
+	target->VSSetSamplers(slot, 1, &sampler);
+	if (tracked) vs.samplers[slot] = sampler;
+}
+
+void StateCache::PSSetSampler(unsigned int slot, ID3D11SamplerState* sampler)
+{
+	bool tracked = slot < samplerSlots;
+	if (!Changed(tracked && ps.samplers[slot] == sampler))
+		return;
+	target->PSSetSamplers(slot, 1, &sampler);
+	if (tracked) ps.samplers[slot] = sampler;
+}
+
+void StateCache::PSClearShaderResources()
+{
+	//Skipped only when every slot is known to be empty already
+	bool empty = true;
+	for (unsigned int i = 0; i < resourceSlots && empty; i++)
+		empty = ps.resources[i] == nullptr;
+	if (!Changed(empty))
+		return;
+
+	ID3D11ShaderResourceView* nullSRVs[resourceSlots] = {};
+	target->PSSetShaderResources(0, resourceSlots, nullSRVs);
+	for (unsigned int i = 0; i < resourceSlots; i++)
+		ps.resources[i] = nullptr;
+}
+
+void StateCache::OMSetBlendState(ID3D11BlendState* state, const float blendFactor[4], unsigned int sampleMask)
+{
+	//A null factor means all ones
+	float factor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	if (blendFactor)
+		memcpy(factor, blendFactor, sizeof(factor));
+
+	bool same = blendState == state &&
+		this->sampleMask == sampleMask &&
+		memcmp(this->blendFactor, factor, sizeof(factor)) == 0;
+	if (!Changed(same))
+		return;
+
+	target->OMSetBlendState(state, factor, sampleMask);
+	blendState = state;
+	memcpy(this->blendFactor, factor, sizeof(factor));
+	this->sampleMask = sampleMask;
+}
+
+void StateCache::OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef)
+{
+	if (!Changed(depthState == state && this->stencilRef == stencilRef))
+		return;
+	target->OMSetDepthStencilState(state, stencilRef);
+	depthState = state;
+	this->stencilRef = stencilRef;
+}
+
+void StateCache::RSSetState(ID3D11RasterizerState* state)
+{
+	if (!Changed(rasterState == state))
+		return;
+	target->RSSetState(state);
+	rasterState = state;
+}
+
+void StateCache::OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv)
+{
+	target->OMSetRenderTargets(count, rtvs, dsv);
+	issuedCalls++;
+	ForgetResources(vs);
+	ForgetResources(ps);
+}
+
+void StateCache::Invalidate()
+{
+	inputLayout = unknownState;
+	vertexShader = unknownState;
+	pixelShader = unknownState;
+	blendState = unknownState;
+	depthState = unknownState;
+	rasterState = unknownState;
+
+	StageState* stages[2] = { &vs, &ps };
+	for (int s = 0; s < 2; s++)
+	{
+		for (unsigned int i = 0; i < constantBufferSlots; i++)
+			stages[s]->constantBuffers[i] = unknownState;
+		for (unsigned int i = 0; i < samplerSlots; i++)
+			stages[s]->samplers[i] = unknownState;
+		ForgetResources(*stages[s]);
+	}
+}
+
+void StateCache::ForgetResources(StageState& stage)
+{
+	for (unsigned int i = 0; i < resourceSlots; i++)
+		stage.resources[i] = unknownState;
+}
+
+void StateCache::SetFiltering(bool filtering)
+{
+	this->filtering = filtering;
+}
+
+bool StateCache::IsFiltering()
+{
+	return filtering;
+}
+
+void StateCache::EndFrame()
+{
+	lastIssuedCalls = issuedCalls;
+	lastFilteredCalls = filteredCalls;
+	issuedCalls = 0;
+	filteredCalls = 0;
+}
+
+int StateCache::GetIssuedCalls()
+{
+	return lastIssuedCalls;
+}
+
+int StateCache::GetFilteredCalls()
+{
+	return lastFilteredCalls;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "StateTarget.h"
+
+// --------------------------------------------------------
+// Sits between the renderer and a StateTarget (the device
+// context, in the game) and drops calls that would bind what's
+// already bound: shaders, input layout, constant buffers, SRVs
+// and samplers (vertex and pixel stages), plus blend, depth and
+// raster states.
+//
+// Anything that changes state without going through here
+// (SpriteBatch, for one) has to be followed by Invalidate.
+// Filtering can be switched off, which sends every call
+// through so the frame can be compared with the filtered one.
+// --------------------------------------------------------
+class StateCache
+{
+public:
+	StateCache(StateTarget* target);
+	~StateCache();
+
+	void IASetInputLayout(ID3D11InputLayout* layout);
+	void VSSetShader(ID3D11VertexShader* shader);
+	void PSSetShader(ID3D11PixelShader* shader);
+
+	void VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void PSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void VSSetShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv);
+	void PSSetShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv);
+	void VSSetSampler(unsigned int slot, ID3D11SamplerState* sampler);
+	void PSSetSampler(unsigned int slot, ID3D11SamplerState* sampler);
+
+	//Unbinds every pixel shader SRV, so render targets can be written
+	void PSClearShaderResources();
+
+	void OMSetBlendState(ID3D11BlendState* state, const float blendFactor[4], unsigned int sampleMask);
+	void OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef);
+	void RSSetState(ID3D11RasterizerState* state);
+
+	//Always sent.  D3D unbinds any SRV that points at a new target, so the
+	//cache stops trusting its SRV slots
+	void OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv);
+
+	//Forgets everything, after something bound state behind the cache's back
+	void Invalidate();
+
+	void SetFiltering(bool filtering);
+	bool IsFiltering();
+
+	//Call once a frame, the counts below are for the frame just finished
+	void EndFrame();
+	int GetIssuedCalls();
+	int GetFilteredCalls();
+
+private:
+	StateTarget* target;
+	bool filtering;
+
+	//Slots past these aren't tracked, calls for them always go through
+	static const unsigned int constantBufferSlots = 14;
+	static const unsigned int resourceSlots = 16;
+	static const unsigned int samplerSlots = 16;
+
+	//What's bound, or unknownState if we can't be sure (null is a real
+	//binding).  Kept as void* so every kind of object shares the marker
+	static void* const unknownState;
+
+	//One stage's bindings
+	struct StageState
+	{
+		void* constantBuffers[constantBufferSlots];
+		void* resources[resourceSlots];
+		void* samplers[samplerSlots];
+	};
+
+	void* inputLayout;
+	void* vertexShader;
+	void* pixelShader;
+	StageState vs;
+	StageState ps;
+	void* blendState;
+	float blendFactor[4];
+	unsigned int sampleMask;
+	void* depthState;
+	unsigned int stencilRef;
+	void* rasterState;
+
+	int issuedCalls;
+	int filteredCalls;
+	int lastIssuedCalls;
+	int lastFilteredCalls;
+
+	//Counts the call, and returns true if it has to go through
+	bool Changed(bool same);
+	void ForgetResources(StageState& stage);
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#if defined(_WIN32)
+#include <d3d11.h>
+#else
+//Only ever passed around by pointer here, so off Windows the names are enough
+struct ID3D11InputLayout;
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11Buffer;
+struct ID3D11ShaderResourceView;
+struct ID3D11SamplerState;
+struct ID3D11BlendState;
+struct ID3D11DepthStencilState;
+struct ID3D11RasterizerState;
+struct ID3D11RenderTargetView;
+struct ID3D11DepthStencilView;
+#endif
+
+// --------------------------------------------------------
+// Where the StateCache sends the calls it doesn't filter out,
+// and where constant buffers are uploaded.  The game uses
+// D3DStateTarget, which passes them on to the device context.
+// Anything else can record them, so a frame's calls can be
+// checked without a device.
+// --------------------------------------------------------
+class StateTarget
+{
+public:
+	virtual ~StateTarget() {}
+
+	virtual void IASetInputLayout(ID3D11InputLayout* layout) = 0;
+	virtual void VSSetShader(ID3D11VertexShader* shader) = 0;
+	virtual void PSSetShader(ID3D11PixelShader* shader) = 0;
+
+	virtual void VSSetConstantBuffers(unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers) = 0;
+	virtual void PSSetConstantBuffers(unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers) = 0;
+	virtual void VSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) = 0;
+	virtual void PSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) = 0;
+	virtual void VSSetSamplers(unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers) = 0;
+	virtual void PSSetSamplers(unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers) = 0;
+
+	virtual void OMSetBlendState(ID3D11BlendState* state, const float blendFactor[4], unsigned int sampleMask) = 0;
+	virtual void OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef) = 0;
+	virtual void RSSetState(ID3D11RasterizerState* state) = 0;
+	virtual void OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv) = 0;
+
+	//Replaces the whole buffer, size is how much data points at
+	virtual void UpdateSubresource(ID3D11Buffer* buffer, const void* data, unsigned int size) = 0;
+};
@@ -1,16 +1,16 @@
 #pragma once
 #include "Entity.h"
+#include "Lights.h"
 #include "ParticleEmitter.h"
+#include "ParticleSystem.h"
 
 class Target : public Entity
 {
 public:
-	Target(Mesh* mesh, Material* material, ParticleEmitter* explosion, ParticleEmitter* thruster);
+	Target(int mesh, int material, float radius, ParticleEmitter* explosion, ParticleEmitter* thruster, ParticleSystem* particleSystem);
 	~Target();
 
 	void Update(float deltaTime, float totalTime) override;
-	void Draw(ID3D11DeviceContext* context, Camera* camera, LightManager* lightManager) override;
-	void DrawEmitter(ID3D11DeviceContext* context, Camera* camera);
 	void Collides() override;
 	PointLight* GetEngine();
 
@@ -18,6 +18,7 @@ private:
 	ParticleEmitter* explosion;
 	ParticleEmitter* thruster;
 	PointLight* engine;
+	ParticleSystem* particleSystem;
 };
 
 
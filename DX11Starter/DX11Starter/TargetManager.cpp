@@ -2,13 +2,13 @@
 
 	
 
-TargetManager::TargetManager(Mesh* mesh, Material* material, ParticleEmitter* explosion, ParticleEmitter* thruster, ID3D11Device* device)
+TargetManager::TargetManager(int mesh, int material, float radius, ParticleEmitter* explosion, ParticleEmitter* thruster, ParticleSystem* particleSystem)
 {
 
 	if (spawnFixed) {
 		for (size_t i = 0; i < this->count; i++)
 		{
-			Entity* t = new Target(mesh, material, explosion->Clone(device), thruster->Clone(device));
+			Entity* t = new Target(mesh, material, radius, explosion->Clone(), thruster->Clone(), particleSystem);
 			t->SetPosition(0.0f, -1.0f, i * this->spacing);
 			t->SetActive(true);
 			targetList.push_back(t);
@@ -17,9 +17,9 @@ TargetManager::TargetManager(Mesh* mesh, Material* material, ParticleEmitter* ex
 	else {
 		//spawn randomly
 		for (size_t i = 0; i < this->count; i++) {
-			Entity* t = new Target(mesh, material, explosion->Clone(device), thruster->Clone(device));
-			float spawnX = rand() % (int)(2 * xCap) - xCap;
-			float spawnY = rand() % (int)(2 * yCap) - yCap;
+			Entity* t = new Target(mesh, material, radius, explosion->Clone(), thruster->Clone(), particleSystem);
+			float spawnX = random.NextInt((unsigned int)(2 * xCap)) - xCap;
+			float spawnY = random.NextInt((unsigned int)(2 * yCap)) - yCap;
 			t->SetPosition(spawnX, spawnY, i * this->spacing);
 			t->SetActive(true);
 			targetList.push_back(t);
@@ -34,12 +34,13 @@ TargetManager::~TargetManager()
 //Use this method to repopulate level 
 void TargetManager::ResetTargets()
 {
-	for each (Entity* e in targetList)
+	for (Entity* e : targetList)
 	{
-		float spawnX = rand() % (int)(2 * xCap) - xCap;
-		float spawnY = rand() % (int)(2 * yCap) - yCap;
+		float spawnX = random.NextInt((unsigned int)(2 * xCap)) - xCap;
+		float spawnY = random.NextInt((unsigned int)(2 * yCap)) - yCap;
 		e->SetPosition(spawnX, spawnY, e->GetPosition().z);
 		e->SetActive(true);
+		e->ResetInterpolation();
 	}
 }
 
@@ -3,13 +3,15 @@
 #include<vector>
 #include"Target.h"
 #include"ParticleEmitter.h"
+#include"ParticleSystem.h"
+#include"Random.h"
 
 using namespace std;
 
 class TargetManager
 {
 public:
-	TargetManager(Mesh* mesh, Material* material, ParticleEmitter* explosion, ParticleEmitter* thruster, ID3D11Device* device);
+	TargetManager(int mesh, int material, float radius, ParticleEmitter* explosion, ParticleEmitter* thruster, ParticleSystem* particleSystem);
 	~TargetManager();
 
 	vector<Entity*> GetTargets();
@@ -27,5 +29,6 @@ private:
 	const float yCap = 2.0f;
 
 	vector<Entity*> targetList;
+	Random random;
 };
 
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <DirectXMath.h>
+#include "Portable.h"
 
 struct Vertex
 {
@@ -8,4 +8,14 @@ struct Vertex
 	DirectX::XMFLOAT3 Normal;
 	DirectX::XMFLOAT2 UV;
 	DirectX::XMFLOAT3 Tangent;
+};
+
+//Per instance data for instanced draws, from the second vertex buffer.  Matches
+//the *_PER_INSTANCE inputs of the instanced vertex shaders
+struct InstanceData
+{
+	DirectX::XMFLOAT4X4 World;
+	DirectX::XMFLOAT4X4 NormalWorld;
+	unsigned int LightFirst;
+	unsigned int LightCount;
 };
\ No newline at end of file
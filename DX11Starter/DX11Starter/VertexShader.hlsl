@@ -5,9 +5,14 @@
 // - All non-pipeline variables that get their values from 
 //    our C++ code must be defined inside a Constant Buffer
 // - The name of the cbuffer itself is unimportant
-cbuffer externalData : register(b0)
+cbuffer perObject : register(b0)
 {
 	matrix world;
+};
+
+// Changes once a frame, shared by every shader (FrameConstantData in C++)
+cbuffer perFrame : register(b1)
+{
 	matrix view;
 	matrix projection;
 };
@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "ConstantBufferData.h"
+#include "Random.h"
+#include "RecordingStateTarget.h"
+
+using namespace std;
+
+// --------------------------------------------------------
+// Checks that ConstantBufferData only uploads when bytes have
+// changed, that what it uploads is what was written, and that
+// the frame stats count it all, using a recording target in
+// place of the device context
+// --------------------------------------------------------
+
+static int failures = 0;
+
+static void Check(bool passed, const char* what)
+{
+	if (passed)
+		return;
+	printf("%s\n", what);
+	failures++;
+}
+
+static bool Sent(const RecordingStateTarget& target, size_t index, ID3D11Buffer* buffer, const void* bytes, unsigned int size)
+{
+	if (index >= target.Uploads.size())
+		return false;
+	const RecordingStateTarget::Upload& upload = target.Uploads[index];
+	return upload.Buffer == buffer && upload.Bytes.size() == size && memcmp(upload.Bytes.data(), bytes, size) == 0;
+}
+
+static void TestDirtyTracking()
+{
+	RecordingStateTarget target;
+	ID3D11Buffer* gpu = Fake<ID3D11Buffer>(1);
+	ConstantBufferData buffer(64, false);
+	unsigned char expected[64] = {};
+
+	//The GPU copy starts out uninitialised, so the zeroed buffer goes up once
+	Check(buffer.IsDirty(), "a new buffer should be dirty");
+	buffer.Upload(&target, gpu);
+	Check(target.Uploads.size() == 1 && Sent(target, 0, gpu, expected, 64), "a new buffer wasn't uploaded whole");
+	Check(!buffer.IsDirty(), "uploading didn't clean the buffer");
+
+	buffer.Upload(&target, gpu);
+	Check(target.Uploads.size() == 1, "a clean buffer was uploaded again");
+
+	//Writing what's already there changes nothing
+	float zeros[4] = {};
+	buffer.Write(16, zeros, sizeof(zeros));
+	Check(!buffer.IsDirty(), "writing the same bytes dirtied the buffer");
+	buffer.Upload(&target, gpu);
+	Check(target.Uploads.size() == 1, "unchanged bytes were uploaded");
+
+	//A real change goes up with the rest of the buffer around it
+	float color[4] = { 1.0f, 0.5f, 0.25f, 1.0f };
+	buffer.Write(16, color, sizeof(color));
+	memcpy(expected + 16, color, sizeof(color));
+	Check(buffer.IsDirty(), "changing bytes didn't dirty the buffer");
+	Check(memcmp(buffer.GetData(), expected, 64) == 0, "write landed in the wrong place");
+	buffer.Upload(&target, gpu);
+	Check(target.Uploads.size() == 2 && Sent(target, 1, gpu, expected, 64), "changed buffer uploaded the wrong bytes");
+
+	//Several writes between uploads make one upload of the last values
+	int count = 3;
+	float scale = 2.0f;
+	buffer.Write(0, &count, sizeof(count));
+	buffer.Write(4, &scale, sizeof(scale));
+	scale = 4.0f;
+	buffer.Write(4, &scale, sizeof(scale));
+	memcpy(expected, &count, sizeof(count));
+	memcpy(expected + 4, &scale, sizeof(scale));
+	buffer.Upload(&target, gpu);
+	buffer.Upload(&target, gpu);
+	Check(target.Uploads.size() == 3 && Sent(target, 2, gpu, expected, 64), "several writes didn't make one upload");
+
+	//A value changed and changed back before the upload is compared with
+	//the local copy, not the GPU's, so it's still sent
+	float other[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	buffer.Write(16, other, sizeof(other));
+	buffer.Write(16, color, sizeof(color));
+	buffer.Upload(&target, gpu);
+	Check(target.Uploads.size() == 4 && Sent(target, 3, gpu, expected, 64), "a restored value wasn't uploaded");
+}
+
+static void TestStats()
+{
+	RecordingStateTarget target;
+	ConstantBufferData::EndFrame();
+
+	ConstantBufferData perFrame(48, false);
+	ConstantBufferData perObject(128, true);
+	perFrame.Upload(&target, Fake<ID3D11Buffer>(1));
+	perObject.Upload(&target, Fake<ID3D11Buffer>(2));
+	perObject.Upload(&target, Fake<ID3D11Buffer>(2));
+	ConstantBufferData::EndFrame();
+
+	SimpleBufferStats stats = ConstantBufferData::GetLastFrameStats();
+	Check(stats.BuffersUploaded == 2, "wrong upload count");
+	Check(stats.BuffersSkipped == 1, "wrong skip count");
+	Check(stats.BytesUploaded == 48 + 128, "wrong uploaded bytes");
+	Check(stats.ObjectBytesUploaded == 128, "wrong perObject bytes");
+
+	//Next frame starts from nothing
+	perFrame.Upload(&target, Fake<ID3D11Buffer>(1));
+	ConstantBufferData::EndFrame();
+	stats = ConstantBufferData::GetLastFrameStats();
+	Check(stats.BuffersUploaded == 0 && stats.BuffersSkipped == 1 && stats.BytesUploaded == 0,
+		"EndFrame didn't start the counts again");
+}
+
+//Frames of draws that each write a few variables into a few buffers, most
+//of them with the values they had.  The GPU has to end up with what was
+//written, with an upload for each draw whose writes changed a byte and
+//none for the rest
+static void TestFrames()
+{
+	const int bufferCount = 4;
+	const unsigned int size = 64;
+	RecordingStateTarget target;
+	ConstantBufferData* buffers[bufferCount];
+	vector<unsigned char> local[bufferCount];
+	vector<unsigned char> gpu[bufferCount];
+	for (int b = 0; b < bufferCount; b++)
+	{
+		buffers[b] = new ConstantBufferData(size, b == 0);
+		local[b].assign(size, 0);
+		gpu[b].assign(size, 0xcd);
+	}
+
+	Random random(7);
+	int expectedUploads = 0;
+	int expectedSkips = 0;
+	bool uploadedAll = true;
+	ConstantBufferData::EndFrame();
+	for (int frame = 0; frame < 100; frame++)
+	{
+		for (int draw = 0; draw < 20; draw++)
+		{
+			for (int b = 0; b < bufferCount; b++)
+			{
+				bool changed = false;
+				for (int w = 0; w < 3; w++)
+				{
+					//Four floats at a 16 byte offset.  Mostly they're rewritten with
+					//what's there, now and then one changes
+					unsigned int offset = random.NextInt(size / 16) * 16;
+					float value[4];
+					memcpy(value, &local[b][offset], sizeof(value));
+					if (random.NextInt(8) == 0)
+						value[random.NextInt(4)] = (float)random.NextInt(4);
+					buffers[b]->Write(offset, value, sizeof(value));
+					changed |= memcmp(&local[b][offset], value, sizeof(value)) != 0;
+					memcpy(&local[b][offset], value, sizeof(value));
+				}
+
+				//The first upload of each buffer is always needed
+				changed |= frame == 0 && draw == 0;
+				size_t before = target.Uploads.size();
+				buffers[b]->Upload(&target, Fake<ID3D11Buffer>(b + 1));
+				if (target.Uploads.size() > before)
+					gpu[b] = target.Uploads.back().Bytes;
+
+				uploadedAll &= gpu[b] == local[b];
+				if (changed != (target.Uploads.size() > before))
+				{
+					printf("Frame %d draw %d buffer %d: %s\n", frame, draw, b,
+						changed ? "changed but wasn't uploaded" : "uploaded without changing");
+					failures++;
+				}
+				if (changed) expectedUploads++;
+				else expectedSkips++;
+			}
+		}
+	}
+	ConstantBufferData::EndFrame();
+
+	Check(uploadedAll, "the GPU copy fell behind what was written");
+	Check((int)target.Uploads.size() == expectedUploads, "wrong number of uploads over the frames");
+	Check(expectedSkips > 0 && expectedUploads > 0, "the frames should both skip and upload");
+	printf("%d buffer uploads, %d skipped\n", expectedUploads, expectedSkips);
+
+	for (int b = 0; b < bufferCount; b++)
+		delete buffers[b];
+}
+
+int main()
+{
+	TestDirtyTracking();
+	TestStats();
+	TestFrames();
+
+	printf(failures ? "ConstantBufferDataTest: %d failures\n" : "ConstantBufferDataTest: passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,404 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "FrameGraph.h"
+
+using namespace std;
+
+// --------------------------------------------------------
+// Checks FrameGraph's culling, ordering and aliasing on graphs
+// shaped like the game's post processing, without a device:
+// passes just record that they ran
+// --------------------------------------------------------
+
+static int failures = 0;
+
+static void Check(bool passed, const char* test, const char* what)
+{
+	if (passed)
+		return;
+	printf("%s: %s\n", test, what);
+	failures++;
+}
+
+static FrameGraphTextureDesc Desc(int width, int height, int format, int bytesPerPixel)
+{
+	FrameGraphTextureDesc desc = {};
+	desc.Width = width;
+	desc.Height = height;
+	desc.Format = format;
+	desc.BytesPerPixel = bytesPerPixel;
+	return desc;
+}
+
+static int AddPass(FrameGraph& graph, const char* name, vector<string>& ran)
+{
+	return graph.AddPass(name, [&ran, name]() { ran.push_back(name); });
+}
+
+//Names of the passes in the order they ran, comma separated
+static string Joined(const vector<string>& names)
+{
+	string joined;
+	for (size_t i = 0; i < names.size(); i++)
+		joined += (i ? "," : "") + names[i];
+	return joined;
+}
+
+static string CompiledOrder(FrameGraph& graph)
+{
+	vector<string> names;
+	for (int pass : graph.GetOrder())
+		names.push_back(graph.GetPassName(pass));
+	return Joined(names);
+}
+
+//The game's post graph: scene, bloom extract and two blurs, radial blur,
+//then a combine into the back buffer.  Every pass is declared, but the
+//combine only reads what's switched on, like the game's shader does
+struct PostGraph
+{
+	int backBuffer;
+	int scene;
+	int bright;
+	int blurH;
+	int blurV;
+	int radial;
+};
+
+static PostGraph BuildPostGraph(FrameGraph& graph, vector<string>& ran, bool bloom, bool radialBlur)
+{
+	PostGraph g;
+	FrameGraphTextureDesc fullScreen = Desc(640, 480, 28, 4);
+
+	graph.Reset();
+	g.backBuffer = graph.ImportTexture("BackBuffer");
+	g.scene = graph.CreateTexture("Scene", fullScreen);
+	g.bright = graph.CreateTexture("BloomBright", fullScreen);
+	g.blurH = graph.CreateTexture("BloomBlurH", fullScreen);
+	g.blurV = graph.CreateTexture("BloomBlurV", fullScreen);
+	g.radial = graph.CreateTexture("Radial", fullScreen);
+
+	int scene = AddPass(graph, "Scene", ran);
+	graph.Write(scene, g.scene);
+
+	int extract = AddPass(graph, "BloomExtract", ran);
+	graph.Read(extract, g.scene);
+	graph.Write(extract, g.bright);
+
+	int blurH = AddPass(graph, "BloomBlurH", ran);
+	graph.Read(blurH, g.bright);
+	graph.Write(blurH, g.blurH);
+
+	int blurV = AddPass(graph, "BloomBlurV", ran);
+	graph.Read(blurV, g.blurH);
+	graph.Write(blurV, g.blurV);
+
+	int radial = AddPass(graph, "RadialBlur", ran);
+	graph.Read(radial, g.scene);
+	graph.Write(radial, g.radial);
+
+	int combine = AddPass(graph, "Combine", ran);
+	graph.Read(combine, g.scene);
+	if (bloom) graph.Read(combine, g.blurV);
+	if (radialBlur) graph.Read(combine, g.radial);
+	graph.Write(combine, g.backBuffer);
+	return g;
+}
+
+static void TestCulling()
+{
+	const char* test = "Culling";
+	FrameGraph graph;
+	vector<string> ran;
+
+	PostGraph g = BuildPostGraph(graph, ran, true, true);
+	Check(graph.Compile(), test, "everything on didn't compile");
+	Check(graph.GetCulledPassCount() == 0, test, "a pass was culled with everything on");
+
+	//Bloom off: its three passes go, and their textures get no slot
+	BuildPostGraph(graph, ran, false, true);
+	Check(graph.Compile(), test, "bloom off didn't compile");
+	graph.Execute();
+	Check(graph.GetCulledPassCount() == 3, test, "bloom off didn't cull the three bloom passes");
+	Check(Joined(ran) == "Scene,RadialBlur,Combine", test, "bloom off ran the wrong passes");
+	Check(graph.GetPhysicalTexture(g.bright) < 0 && graph.GetPhysicalTexture(g.blurH) < 0 &&
+		graph.GetPhysicalTexture(g.blurV) < 0, test, "culled bloom textures were given slots");
+	Check(graph.GetPhysicalTexture(g.radial) >= 0, test, "radial texture has no slot");
+
+	//Radial off
+	ran.clear();
+	BuildPostGraph(graph, ran, true, false);
+	Check(graph.Compile(), test, "radial off didn't compile");
+	graph.Execute();
+	Check(graph.GetCulledPassCount() == 1, test, "radial off didn't cull just the radial pass");
+	Check(Joined(ran) == "Scene,BloomExtract,BloomBlurH,BloomBlurV,Combine", test, "radial off ran the wrong passes");
+
+	//Both off leaves the scene and the combine
+	ran.clear();
+	BuildPostGraph(graph, ran, false, false);
+	Check(graph.Compile(), test, "both off didn't compile");
+	graph.Execute();
+	Check(Joined(ran) == "Scene,Combine", test, "both off ran the wrong passes");
+	Check(graph.GetPhysicalCount() == 1, test, "both off should need only the scene texture");
+
+	//Nothing reaches the back buffer, so nothing runs
+	ran.clear();
+	graph.Reset();
+	int texture = graph.CreateTexture("Unused", Desc(16, 16, 1, 4));
+	int pass = AddPass(graph, "Orphan", ran);
+	graph.Write(pass, texture);
+	Check(graph.Compile(), test, "orphan graph didn't compile");
+	graph.Execute();
+	Check(graph.GetCulledPassCount() == 1 && ran.empty(), test, "a pass nobody reads ran");
+}
+
+static void TestOrdering()
+{
+	const char* test = "Ordering";
+	FrameGraph graph;
+	vector<string> ran;
+	FrameGraphTextureDesc desc = Desc(64, 64, 1, 4);
+
+	//The post graph declared back to front
+	int backBuffer = graph.ImportTexture("BackBuffer");
+	int scene = graph.CreateTexture("Scene", desc);
+	int bright = graph.CreateTexture("Bright", desc);
+	int blurred = graph.CreateTexture("Blurred", desc);
+
+	int combine = AddPass(graph, "Combine", ran);
+	graph.Read(combine, scene);
+	graph.Read(combine, blurred);
+	graph.Write(combine, backBuffer);
+
+	int blur = AddPass(graph, "Blur", ran);
+	graph.Read(blur, bright);
+	graph.Write(blur, blurred);
+
+	int extract = AddPass(graph, "Extract", ran);
+	graph.Read(extract, scene);
+	graph.Write(extract, bright);
+
+	int draw = AddPass(graph, "Scene", ran);
+	graph.Write(draw, scene);
+
+	Check(graph.Compile(), test, "reversed graph didn't compile");
+	Check(CompiledOrder(graph) == "Scene,Extract,Blur,Combine", test, "reversed graph compiled out of order");
+	graph.Execute();
+	Check(Joined(ran) == "Scene,Extract,Blur,Combine", test, "reversed graph ran out of order");
+
+	//Independent passes keep their declared order
+	ran.clear();
+	graph.Reset();
+	backBuffer = graph.ImportTexture("BackBuffer");
+	int a = graph.CreateTexture("A", desc);
+	int b = graph.CreateTexture("B", desc);
+	int writeA = AddPass(graph, "WriteA", ran);
+	graph.Write(writeA, a);
+	int writeB = AddPass(graph, "WriteB", ran);
+	graph.Write(writeB, b);
+	combine = AddPass(graph, "Combine", ran);
+	graph.Read(combine, b);
+	graph.Read(combine, a);
+	graph.Write(combine, backBuffer);
+	Check(graph.Compile(), test, "independent passes didn't compile");
+	Check(CompiledOrder(graph) == "WriteA,WriteB,Combine", test, "independent passes were reordered");
+
+	//Two writes to one texture stay in declared order, and a read declared
+	//between them sees the first
+	ran.clear();
+	graph.Reset();
+	backBuffer = graph.ImportTexture("BackBuffer");
+	a = graph.CreateTexture("A", desc);
+	b = graph.CreateTexture("B", desc);
+	int first = AddPass(graph, "First", ran);
+	graph.Write(first, a);
+	int copy = AddPass(graph, "Copy", ran);
+	graph.Read(copy, a);
+	graph.Write(copy, b);
+	int second = AddPass(graph, "Second", ran);
+	graph.Read(second, b);
+	graph.Write(second, a);
+	combine = AddPass(graph, "Combine", ran);
+	graph.Read(combine, a);
+	graph.Write(combine, backBuffer);
+	Check(graph.Compile(), test, "rewritten texture didn't compile");
+	Check(CompiledOrder(graph) == "First,Copy,Second,Combine", test, "writes to one texture were reordered");
+
+	//Passes that read each other's output can't be ordered
+	graph.Reset();
+	backBuffer = graph.ImportTexture("BackBuffer");
+	a = graph.CreateTexture("A", desc);
+	b = graph.CreateTexture("B", desc);
+	int left = AddPass(graph, "Left", ran);
+	graph.Read(left, b);
+	graph.Write(left, a);
+	int right = AddPass(graph, "Right", ran);
+	graph.Read(right, a);
+	graph.Write(right, b);
+	combine = AddPass(graph, "Combine", ran);
+	graph.Read(combine, a);
+	graph.Write(combine, backBuffer);
+	Check(!graph.Compile(), test, "a cycle compiled");
+}
+
+//Where each texture is first and last used in the compiled order
+static void Lifetime(FrameGraph& graph, const vector<vector<int>>& used, int texture, int& first, int& last)
+{
+	first = -1;
+	last = -1;
+	const vector<int>& order = graph.GetOrder();
+	for (int i = 0; i < (int)order.size(); i++)
+	{
+		for (int t : used[order[i]])
+		{
+			if (t != texture)
+				continue;
+			if (first < 0) first = i;
+			last = i;
+		}
+	}
+}
+
+static void TestAliasing()
+{
+	const char* test = "Aliasing";
+	FrameGraph graph;
+	vector<string> ran;
+	FrameGraphTextureDesc desc = Desc(128, 128, 1, 4);
+
+	//A chain where each texture is done with once the next one's written:
+	//T0 and T2 can share, as can T1 and T3, but neighbours can't
+	int backBuffer = graph.ImportTexture("BackBuffer");
+	int t[4];
+	vector<vector<int>> used;
+	for (int i = 0; i < 4; i++)
+		t[i] = graph.CreateTexture(("T" + to_string(i)).c_str(), desc);
+	for (int i = 0; i < 5; i++)
+	{
+		int pass = AddPass(graph, "Step", ran);
+		vector<int> uses;
+		if (i > 0) { graph.Read(pass, t[i - 1]); uses.push_back(t[i - 1]); }
+		int written = i < 4 ? t[i] : backBuffer;
+		graph.Write(pass, written);
+		uses.push_back(written);
+		used.push_back(uses);
+	}
+	Check(graph.Compile(), test, "chain didn't compile");
+	Check(graph.GetPhysicalCount() == 2, test, "chain should fit in two slots");
+	Check(graph.GetPhysicalTexture(t[0]) == graph.GetPhysicalTexture(t[2]) &&
+		graph.GetPhysicalTexture(t[1]) == graph.GetPhysicalTexture(t[3]), test, "chain textures weren't reused");
+	Check(graph.GetPhysicalTexture(backBuffer) < 0, test, "imported texture was given a slot");
+
+	//Nothing that shares a slot may be alive at the same time
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = i + 1; j < 4; j++)
+		{
+			if (graph.GetPhysicalTexture(t[i]) != graph.GetPhysicalTexture(t[j]))
+				continue;
+			int firstI, lastI, firstJ, lastJ;
+			Lifetime(graph, used, t[i], firstI, lastI);
+			Lifetime(graph, used, t[j], firstJ, lastJ);
+			Check(lastI < firstJ || lastJ < firstI, test, "overlapping textures share a slot");
+		}
+	}
+
+	//Same chain, but every other texture is half size: only matching descs share
+	graph.Reset();
+	used.clear();
+	backBuffer = graph.ImportTexture("BackBuffer");
+	for (int i = 0; i < 4; i++)
+		t[i] = graph.CreateTexture(("T" + to_string(i)).c_str(), i % 2 ? Desc(64, 64, 1, 4) : desc);
+	for (int i = 0; i < 5; i++)
+	{
+		int pass = AddPass(graph, "Step", ran);
+		if (i > 0) graph.Read(pass, t[i - 1]);
+		graph.Write(pass, i < 4 ? t[i] : backBuffer);
+	}
+	Check(graph.Compile(), test, "mixed chain didn't compile");
+	Check(graph.GetPhysicalCount() == 2, test, "mixed chain should fit in two slots");
+	for (int s = 0; s < graph.GetPhysicalCount(); s++)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			if (graph.GetPhysicalTexture(t[i]) != s)
+				continue;
+			FrameGraphTextureDesc slot = graph.GetPhysicalDesc(s);
+			Check(slot.Width == (i % 2 ? 64 : 128), test, "texture shares a slot of another size");
+		}
+	}
+
+	//Same sizes, different format: nothing shares
+	graph.Reset();
+	backBuffer = graph.ImportTexture("BackBuffer");
+	for (int i = 0; i < 4; i++)
+		t[i] = graph.CreateTexture(("T" + to_string(i)).c_str(), Desc(128, 128, i, 4));
+	for (int i = 0; i < 5; i++)
+	{
+		int pass = AddPass(graph, "Step", ran);
+		if (i > 0) graph.Read(pass, t[i - 1]);
+		graph.Write(pass, i < 4 ? t[i] : backBuffer);
+	}
+	Check(graph.Compile(), test, "format chain didn't compile");
+	Check(graph.GetPhysicalCount() == 4, test, "textures of different formats shared a slot");
+}
+
+static void TestTransientBytes()
+{
+	const char* test = "TransientBytes";
+	FrameGraph graph;
+	vector<string> ran;
+	const int fullScreen = 640 * 480 * 4;
+
+	//Everything on.  Scene lives to the combine, bright is done once BlurH
+	//has read it, so BlurV takes its slot, and Radial takes BlurH's:
+	//three slots for five textures
+	BuildPostGraph(graph, ran, true, true);
+	Check(graph.Compile(), test, "post graph didn't compile");
+	Check(graph.GetPhysicalCount() == 3, test, "post graph should need three slots");
+	Check(graph.GetPeakTransientBytes() == 3 * fullScreen, test, "wrong peak bytes with everything on");
+	Check(graph.GetUnaliasedTransientBytes() == 5 * fullScreen, test, "wrong unaliased bytes with everything on");
+
+	//Bloom off: scene and radial are both alive at the combine
+	BuildPostGraph(graph, ran, false, true);
+	Check(graph.Compile(), test, "bloom off didn't compile");
+	Check(graph.GetPeakTransientBytes() == 2 * fullScreen, test, "wrong peak bytes with bloom off");
+	Check(graph.GetUnaliasedTransientBytes() == 2 * fullScreen, test, "wrong unaliased bytes with bloom off");
+
+	//Peak is the sum of the slots, whatever their sizes
+	graph.Reset();
+	int backBuffer = graph.ImportTexture("BackBuffer");
+	int big = graph.CreateTexture("Big", Desc(256, 256, 1, 8));
+	int small = graph.CreateTexture("Small", Desc(32, 16, 2, 4));
+	int a = AddPass(graph, "Big", ran);
+	graph.Write(a, big);
+	int b = AddPass(graph, "Small", ran);
+	graph.Read(b, big);
+	graph.Write(b, small);
+	int c = AddPass(graph, "Combine", ran);
+	graph.Read(c, small);
+	graph.Write(c, backBuffer);
+	Check(graph.Compile(), test, "mixed sizes didn't compile");
+	Check(graph.GetPeakTransientBytes() == 256 * 256 * 8 + 32 * 16 * 4, test, "wrong peak bytes for mixed sizes");
+
+	//Nothing transient
+	graph.Reset();
+	backBuffer = graph.ImportTexture("BackBuffer");
+	a = AddPass(graph, "Scene", ran);
+	graph.Write(a, backBuffer);
+	Check(graph.Compile(), test, "back buffer only didn't compile");
+	Check(graph.GetPeakTransientBytes() == 0 && graph.GetPhysicalCount() == 0, test, "back buffer only should need no slots");
+}
+
+int main()
+{
+	TestCulling();
+	TestOrdering();
+	TestAliasing();
+	TestTransientBytes();
+
+	printf(failures ? "FrameGraphTest: %d failures\n" : "FrameGraphTest: passed\n", failures);
+	return failures ? 1 : 0;
+}
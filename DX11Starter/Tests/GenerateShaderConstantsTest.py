@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+Tests Tools/GenerateShaderConstants.py.  The layouts expected here are what the
+shader compiler's reflection reports for the same cbuffers, and the checked-in
+ShaderConstants.h has to be what the script makes from the current shaders.
+
+    python GenerateShaderConstantsTest.py
+"""
+
+import os
+import shutil
+import sys
+import tempfile
+import unittest
+
+sys.dont_write_bytecode = True
+TESTS_DIR = os.path.dirname(os.path.abspath(__file__))
+SHADER_DIR = os.path.join(TESTS_DIR, "..", "DX11Starter")
+sys.path.insert(0, os.path.join(TESTS_DIR, "..", "Tools"))
+import GenerateShaderConstants as gen
+
+POINT_LIGHT = """
+struct PointLight
+{
+	float4 AmbientColor;
+	float4 DiffuseColor;
+	float4 SpecularColor;
+	float3 Position;
+	float Radius;
+};
+"""
+
+
+def offsets(hlsl):
+	"""{member: (offset, size)} and the buffer size of the only cbuffer in hlsl"""
+	structs, cbuffers = gen.parse_file(hlsl)
+	placed, size = gen.layout(cbuffers[0][2], structs)
+	return dict((name, (offset, memberSize)) for _, name, _, offset, memberSize in placed), gen.buffer_size(size)
+
+
+class PackingTest(unittest.TestCase):
+	def test_scalars_share_a_register(self):
+		members, size = offsets("cbuffer c { float a; float b; float2 c; };")
+		self.assertEqual(members, {"a": (0, 4), "b": (4, 4), "c": (8, 8)})
+		self.assertEqual(size, 16)
+
+	def test_vector_fits_after_scalar(self):
+		members, size = offsets("cbuffer c { float a; float3 b; };")
+		self.assertEqual(members["b"], (4, 12))
+		self.assertEqual(size, 16)
+
+	def test_vector_never_straddles(self):
+		members, size = offsets("cbuffer c { float2 a; float3 b; float c; };")
+		self.assertEqual(members["b"], (16, 12))
+		self.assertEqual(members["c"], (28, 4))
+		self.assertEqual(size, 32)
+
+	def test_matrix_starts_a_register(self):
+		members, size = offsets("cbuffer c { float a; float4x4 m; matrix n; };")
+		self.assertEqual(members["m"], (16, 64))
+		self.assertEqual(members["n"], (80, 64))
+		self.assertEqual(size, 144)
+
+	def test_array_elements_take_a_register_each(self):
+		# The last element isn't padded, so the next scalar packs after it
+		members, size = offsets("cbuffer c { float a; float b[3]; float c; };")
+		self.assertEqual(members["b"], (16, 36))
+		self.assertEqual(members["c"], (52, 4))
+		self.assertEqual(size, 64)
+
+		members, size = offsets("cbuffer c { uint4 idx[16]; int count; };")
+		self.assertEqual(members["idx"], (0, 256))
+		self.assertEqual(members["count"], (256, 4))
+		self.assertEqual(size, 272)
+
+	def test_struct_starts_a_register(self):
+		members, size = offsets(POINT_LIGHT + "cbuffer c { float a; PointLight light; float4 b; };")
+		self.assertEqual(members["light"], (16, 64))
+		self.assertEqual(members["b"], (80, 16))
+		self.assertEqual(size, 96)
+
+	def test_packoffset(self):
+		members, size = offsets("cbuffer c { float a : packoffset(c0.y); float4 b : packoffset(c3); float c : packoffset(c4.w); };")
+		self.assertEqual(members, {"a": (4, 4), "b": (48, 16), "c": (76, 4)})
+		self.assertEqual(size, 80)
+
+	def test_bool_and_int_are_four_bytes(self):
+		members, size = offsets("cbuffer c { bool a; int b; uint c; };")
+		self.assertEqual(members, {"a": (0, 4), "b": (4, 4), "c": (8, 4)})
+
+	def test_comments_and_register_are_ignored(self):
+		members, _ = offsets("// float x;\ncbuffer c : register(b2) { /* float y; */ float a; // float z;\n };")
+		self.assertEqual(list(members), ["a"])
+
+	def test_errors(self):
+		with self.assertRaises(gen.LayoutError):
+			offsets("cbuffer c { half4 a; };")
+		with self.assertRaises(gen.LayoutError):
+			offsets("cbuffer c { float4 a : packoffset(c1); float b : packoffset(c0); };")
+		with self.assertRaises(gen.LayoutError):
+			offsets("cbuffer c { float4 a : SV_POSITION; };")
+
+
+class HeaderTest(unittest.TestCase):
+	def setUp(self):
+		self.dir = tempfile.mkdtemp()
+
+	def tearDown(self):
+		shutil.rmtree(self.dir)
+
+	def generate(self, files):
+		for name, text in files.items():
+			with open(os.path.join(self.dir, name), "w") as f:
+				f.write(text)
+		return gen.generate(self.dir)
+
+	def test_padding_and_asserts(self):
+		header = self.generate({"TestPS.hlsl": "cbuffer Data : register(b3) { float2 a; float3 b; };"})
+		self.assertIn("namespace TestPS", header)
+		self.assertIn("// register(b3)", header)
+		self.assertIn("\t\tDirectX::XMFLOAT2 a;\n\t\tunsigned char _pad0[8];\n\t\tDirectX::XMFLOAT3 b;\n\t\tunsigned char _pad1[4];", header)
+		self.assertIn("static_assert(offsetof(Data, b) == 16", header)
+		self.assertIn("static_assert(sizeof(Data) == 32", header)
+
+	def test_reflection_table(self):
+		header = self.generate({"TestPS.hlsl": "cbuffer Data { float a; float3 b; };", "Empty.hlsl": "float4 main() : SV_TARGET { return 0; }"})
+		self.assertIn('{ "Data", 0, 0, 16 },\n\t\t{ "Data", "a", 0, 4 },\n\t\t{ "Data", "b", 4, 12 },', header)
+		self.assertIn('{ "TestPS", TestPS::Reflection,', header)
+		self.assertNotIn("Empty", header)
+
+	def test_known_structs_are_checked(self):
+		header = self.generate({"LightPS.hlsl": POINT_LIGHT + "cbuffer Data { PointLight light; };"})
+		self.assertIn("PointLight light;", header)
+		self.assertIn("static_assert(sizeof(PointLight) == 64", header)
+
+	def test_unknown_struct_is_an_error(self):
+		with self.assertRaises(gen.LayoutError):
+			self.generate({"OtherPS.hlsl": "struct Other { float4 a; };\ncbuffer Data { Other o; };"})
+
+
+class CheckedInTest(unittest.TestCase):
+	def test_header_is_up_to_date(self):
+		with open(os.path.join(SHADER_DIR, "ShaderConstants.h")) as f:
+			checkedIn = f.read()
+		self.assertTrue(gen.generate(SHADER_DIR) == checkedIn,
+			"ShaderConstants.h is out of date, rerun Tools/GenerateShaderConstants.py")
+
+
+if __name__ == "__main__":
+	unittest.main()
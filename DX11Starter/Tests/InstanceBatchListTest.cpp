@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <vector>
+#include "InstanceBatchList.h"
+#include "Random.h"
+
+using namespace std;
+
+// --------------------------------------------------------
+// Checks how InstanceBatchList groups entities into batches:
+// which entities each batch holds, where its instances start,
+// and when runs have to split
+// --------------------------------------------------------
+
+static int failures = 0;
+
+static void Check(bool passed, const char* test, const char* what)
+{
+	if (passed)
+		return;
+	printf("%s: %s\n", test, what);
+	failures++;
+}
+
+//The batch's entities are exactly these, in this order
+static bool Holds(InstanceBatchList& list, int batch, const vector<Entity*>& expected)
+{
+	const InstanceBatch& b = list.GetBatches()[batch];
+	if (b.instanceCount != (int)expected.size())
+		return false;
+	for (int i = 0; i < b.instanceCount; i++)
+	{
+		Entity* entity = list.GetEntities()[b.firstInstance + i];
+		if (entity != expected[i] || entity->GetMesh() != b.mesh || entity->GetMaterial() != b.material)
+			return false;
+	}
+	return true;
+}
+
+static void TestSortedFrame()
+{
+	const char* test = "Sorted frame";
+
+	//What the render queue hands over after sorting: the player, the 30
+	//targets sharing the enemy mesh, then the bullets
+	Entity player(0, 0, 1.0f, ENTITY_SHIP);
+	vector<Entity*> targets;
+	vector<Entity*> bullets;
+	for (int i = 0; i < 30; i++)
+		targets.push_back(new Entity(1, 1, 1.0f, ENTITY_SHIP));
+	for (int i = 0; i < 10; i++)
+		bullets.push_back(new Entity(2, 2, 0.5f, ENTITY_BULLET));
+
+	InstanceBatchList list;
+	list.Begin();
+	Check(list.Add(&player) == 0, test, "player not in the first batch");
+	for (Entity* target : targets)
+		Check(list.Add(target) == 1, test, "a target wasn't in the second batch");
+	for (Entity* bullet : bullets)
+		Check(list.Add(bullet) == 2, test, "a bullet wasn't in the third batch");
+
+	const vector<InstanceBatch>& batches = list.GetBatches();
+	Check(batches.size() == 3, test, "should be three batches");
+	Check(batches.size() == 3 && batches[0].firstInstance == 0 && batches[1].firstInstance == 1 && batches[2].firstInstance == 31,
+		test, "batches start at the wrong instances");
+	Check(batches.size() == 3 && Holds(list, 0, vector<Entity*>(1, &player)) && Holds(list, 1, targets) && Holds(list, 2, bullets),
+		test, "batches hold the wrong entities");
+	Check(list.GetEntities().size() == 41, test, "wrong instance count");
+
+	//A new frame starts empty
+	list.Begin();
+	Check(list.GetBatches().empty() && list.GetEntities().empty(), test, "Begin didn't empty the list");
+	Check(list.Add(targets[0]) == 0 && list.GetBatches()[0].firstInstance == 0, test, "first batch after Begin isn't at 0");
+
+	for (Entity* e : targets) delete e;
+	for (Entity* e : bullets) delete e;
+}
+
+static void TestSplits()
+{
+	const char* test = "Splits";
+	Entity a1(1, 1, 1.0f, ENTITY_SHIP);
+	Entity a2(1, 1, 1.0f, ENTITY_SHIP);
+	Entity otherMaterial(1, 2, 1.0f, ENTITY_SHIP);
+	Entity otherMesh(2, 1, 1.0f, ENTITY_SHIP);
+
+	//Mesh or material changing starts a batch
+	InstanceBatchList list;
+	list.Begin();
+	list.Add(&a1);
+	list.Add(&otherMaterial);
+	list.Add(&otherMesh);
+	Check(list.GetBatches().size() == 3, test, "a different mesh or material joined a batch");
+
+	//The list doesn't reorder: the same pair again later is a new batch
+	list.Begin();
+	list.Add(&a1);
+	list.Add(&otherMesh);
+	list.Add(&a2);
+	Check(list.GetBatches().size() == 3 && Holds(list, 0, vector<Entity*>(1, &a1)) && Holds(list, 2, vector<Entity*>(1, &a2)),
+		test, "entities were moved between batches");
+
+	//EndBatch splits a run that would otherwise join, and only once
+	list.Begin();
+	list.EndBatch();
+	list.Add(&a1);
+	list.EndBatch();
+	list.EndBatch();
+	list.Add(&a2);
+	list.Add(&a1);
+	Check(list.GetBatches().size() == 2, test, "EndBatch didn't split the run exactly once");
+	Check(list.GetBatches().size() == 2 && list.GetBatches()[1].firstInstance == 1 && list.GetBatches()[1].instanceCount == 2,
+		test, "batch after EndBatch holds the wrong instances");
+}
+
+//Random runs checked against the rule worked out by hand: a batch starts
+//at the first entity, after EndBatch, and wherever mesh or material change
+static void TestRandomRuns()
+{
+	const char* test = "Random runs";
+	vector<Entity*> pool;
+	for (int mesh = 0; mesh < 3; mesh++)
+		for (int material = 0; material < 2; material++)
+			pool.push_back(new Entity(mesh, material, 1.0f, ENTITY_SHIP));
+
+	Random random(11);
+	InstanceBatchList list;
+	for (int frame = 0; frame < 200; frame++)
+	{
+		list.Begin();
+		vector<Entity*> added;
+		vector<int> expectedBatch;
+		int batch = -1;
+		bool split = true;
+		int count = (int)random.NextInt(60);
+		for (int i = 0; i < count; i++)
+		{
+			if (random.NextInt(10) == 0)
+			{
+				list.EndBatch();
+				split = true;
+			}
+
+			//Mostly the same as the last one, like sorted packets
+			Entity* entity = added.empty() || random.NextInt(4) == 0 ? pool[random.NextInt((unsigned int)pool.size())] : added.back();
+			bool changed = added.empty() || entity->GetMesh() != added.back()->GetMesh() || entity->GetMaterial() != added.back()->GetMaterial();
+			if (split || changed)
+				batch++;
+			split = false;
+
+			if (list.Add(entity) != batch)
+			{
+				printf("Frame %d entity %d: went in batch %d, expected %d\n", frame, i, list.GetBatches().empty() ? -1 : (int)list.GetBatches().size() - 1, batch);
+				failures++;
+			}
+			added.push_back(entity);
+			expectedBatch.push_back(batch);
+		}
+
+		//Batches tile the instances in order, each holding what was added to it
+		const vector<InstanceBatch>& batches = list.GetBatches();
+		Check((int)batches.size() == batch + 1, test, "wrong batch count");
+		Check(list.GetEntities() == added, test, "entities aren't in the order they were added");
+		int next = 0;
+		for (int b = 0; b < (int)batches.size(); b++)
+		{
+			vector<Entity*> expected;
+			for (int i = 0; i < count; i++)
+				if (expectedBatch[i] == b)
+					expected.push_back(added[i]);
+			Check(batches[b].firstInstance == next && batches[b].instanceCount > 0, test, "batches don't tile the instances");
+			Check(Holds(list, b, expected), test, "a batch holds the wrong entities");
+			next += batches[b].instanceCount;
+		}
+		Check(next == count, test, "batches don't cover every instance");
+	}
+
+	for (Entity* e : pool) delete e;
+}
+
+int main()
+{
+	TestSortedFrame();
+	TestSplits();
+	TestRandomRuns();
+
+	printf(failures ? "InstanceBatchListTest: %d failures\n" : "InstanceBatchListTest: passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <vector>
+#include "LightClusters.h"
+#include "Camera.h"
+#include "Random.h"
+
+using namespace std;
+
+// --------------------------------------------------------
+// Checks LightClusters against testing every light against
+// every cluster, without a device.  Thousands of random lights
+// around cameras looking different ways, plus lights centred
+// right on slice and tile edges, which have to land in the
+// clusters on both sides.
+// --------------------------------------------------------
+
+static int failures = 0;
+
+static void Check(bool passed, const char* test, const char* what)
+{
+	if (passed)
+		return;
+	printf("%s: %s\n", test, what);
+	failures++;
+}
+
+//Inverse of GetPointLightRange, for lights that should reach a set distance
+static float RadiusForRange(float range)
+{
+	return 0.04f * 0.01f * range * range;
+}
+
+//How many clusters list light
+static int ClustersWith(LightClusters& clusters, unsigned int light)
+{
+	const vector<LightClusters::ClusterRange>& ranges = clusters.GetClusters();
+	const vector<unsigned int>& indices = clusters.GetLightIndices();
+	int count = 0;
+	for (size_t c = 0; c < ranges.size(); c++)
+	{
+		for (unsigned int i = 0; i < ranges[c].count; i++)
+			count += indices[ranges[c].offset + i] == light;
+	}
+	return count;
+}
+
+static void RandomLights(unsigned long long seed)
+{
+	char test[64];
+	snprintf(test, sizeof(test), "Random lights, seed %llu", seed);
+
+	Random random(seed);
+	Camera camera(1280.0f, 720.0f, 0.25f * XM_PI, 0.01f, 100.0f);
+	XMFLOAT3 eye(random.Range(-50.0f, 50.0f), random.Range(-5.0f, 5.0f), random.Range(-50.0f, 50.0f));
+	camera.LookTo(eye, XMFLOAT3(random.Range(-1.0f, 1.0f), random.Range(-0.3f, 0.3f), random.Range(-1.0f, 1.0f)));
+
+	//Some off, some behind the camera, some past the far plane
+	vector<PointLight> lights(4096);
+	vector<PointLight*> pointers(lights.size());
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		lights[i] = PointLight();
+		lights[i].Position = XMFLOAT3(eye.x + random.Range(-110.0f, 110.0f), eye.y + random.Range(-30.0f, 30.0f), eye.z + random.Range(-110.0f, 110.0f));
+		lights[i].Radius = random.NextInt(16) == 0 ? 0.0f : random.Range(0.0f, 0.01f);
+		pointers[i] = &lights[i];
+	}
+
+	LightClusters clusters;
+	clusters.Build(camera.GetView(), camera.GetProj(), pointers);
+	Check(!clusters.GetLightIndices().empty(), test, "no lights in any cluster");
+	Check(clusters.VerifyAgainstBruteForce() == 0, test, "differs from brute force");
+}
+
+//A camera at the origin looking down +z, so view space is world space
+static void EdgeLights()
+{
+	const char* test = "Edge lights";
+	Camera camera(1280.0f, 720.0f, 0.25f * XM_PI, 0.01f, 100.0f);
+	camera.LookTo(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f));
+	XMFLOAT4X4 projection = camera.GetProj();
+	float tanX = 1.0f / projection._11;
+	float tanY = 1.0f / projection._22;
+
+	//Slice depths come from the projection, so build once with nothing in it
+	LightClusters clusters;
+	clusters.Build(camera.GetView(), camera.GetProj(), vector<PointLight*>());
+	Check(clusters.GetLightIndices().empty(), test, "lights in clusters with none added");
+	int tilesX = clusters.GetTilesX();
+	int tilesY = clusters.GetTilesY();
+
+	//The middle of the tile up and right of the centre is at depth * tan / tiles.
+	//On every inside slice boundary, in the middle of that tile, and on every
+	//inside tile edge, in the middle of a slice.  Each reaches a tenth of
+	//the way into its slice, so it only just crosses
+	vector<PointLight> lights;
+	for (int s = 1; s < clusters.GetSliceCount(); s++)
+	{
+		float nearDepth = clusters.GetSliceDepth(s - 1);
+		float depth = clusters.GetSliceDepth(s);
+		float range = (depth - nearDepth) * 0.1f;
+
+		PointLight light = PointLight();
+		light.Position = XMFLOAT3(depth * tanX / tilesX, depth * tanY / tilesY, depth);
+		light.Radius = RadiusForRange(range);
+		lights.push_back(light);
+	}
+	for (int s = 4; s < clusters.GetSliceCount(); s += 4)
+	{
+		float nearDepth = clusters.GetSliceDepth(s);
+		float farDepth = clusters.GetSliceDepth(s + 1);
+		float depth = (nearDepth + farDepth) * 0.5f;
+		float range = (farDepth - nearDepth) * 0.1f;
+
+		for (int t = 1; t < tilesX; t++)
+		{
+			PointLight light = PointLight();
+			light.Position = XMFLOAT3(depth * tanX * (2.0f * t / tilesX - 1.0f), depth * tanY / tilesY, depth);
+			light.Radius = RadiusForRange(range);
+			lights.push_back(light);
+		}
+		for (int t = 1; t < tilesY; t++)
+		{
+			PointLight light = PointLight();
+			light.Position = XMFLOAT3(depth * tanX / tilesX, depth * tanY * (2.0f * t / tilesY - 1.0f), depth);
+			light.Radius = RadiusForRange(range);
+			lights.push_back(light);
+		}
+	}
+
+	vector<PointLight*> pointers;
+	for (size_t i = 0; i < lights.size(); i++)
+		pointers.push_back(&lights[i]);
+
+	clusters.Build(camera.GetView(), camera.GetProj(), pointers);
+	Check(!clusters.GetLightIndices().empty(), test, "no lights in any cluster");
+	Check(clusters.VerifyAgainstBruteForce() == 0, test, "differs from brute force");
+
+	int oneSided = 0;
+	for (size_t i = 0; i < lights.size(); i++)
+		oneSided += ClustersWith(clusters, (unsigned int)i) < 2;
+	Check(oneSided == 0, test, "a light on an edge is only in the cluster on one side");
+}
+
+int main()
+{
+	for (unsigned long long seed = 1; seed <= 8; seed++)
+		RandomLights(seed);
+	EdgeLights();
+
+	printf(failures ? "LightClustersTest: %d failures\n" : "LightClustersTest: passed\n", failures);
+	return failures ? 1 : 0;
+}
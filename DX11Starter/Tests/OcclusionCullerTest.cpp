@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <vector>
+#include "OcclusionCuller.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "Camera.h"
+#include "Random.h"
+
+using namespace std;
+
+// --------------------------------------------------------
+// Checks OcclusionCuller on made up scenes, without a device:
+// a handful of big occluders close to the camera and thousands
+// of spheres scattered further down the view.  Every culled
+// result has to match testing each sphere against the kept
+// occluders pixel by pixel, and a scene has to actually hide
+// something, or matching brute force proves nothing.
+//
+// Each scene is culled with one thread and with several, at
+// the default buffer size and at widths the culler has to
+// round up to a whole number of four pixel groups.
+// --------------------------------------------------------
+
+static int failures = 0;
+
+static void Check(bool passed, const char* test, const char* what)
+{
+	if (passed)
+		return;
+	printf("%s: %s\n", test, what);
+	failures++;
+}
+
+struct SceneResult
+{
+	int Visible;
+	int Hidden;
+	vector<char> IsVisible;
+};
+
+//Spheres and occluders in front of a camera looking down +z from eye
+static SceneResult CullScene(const char* test, JobSystem* jobSystem, int width, int height, unsigned long long seed)
+{
+	Random random(seed);
+	Camera camera(1280.0f, 720.0f, 0.25f * XM_PI, 0.01f, 100.0f);
+	XMFLOAT3 eye(random.Range(-50.0f, 50.0f), random.Range(-5.0f, 5.0f), random.Range(-50.0f, 50.0f));
+	camera.LookTo(eye, XMFLOAT3(random.Range(-0.2f, 0.2f), random.Range(-0.1f, 0.1f), 1.0f));
+	XMFLOAT4 planes[6];
+	camera.GetFrustumPlanes(planes);
+
+	FrustumCuller culler(jobSystem);
+	for (int i = 0; i < 5000; i++)
+	{
+		XMFLOAT3 center(eye.x + random.Range(-20.0f, 20.0f), eye.y + random.Range(-10.0f, 10.0f), eye.z + random.Range(2.0f, 95.0f));
+		culler.Add(center, random.Range(0.1f, 2.0f));
+	}
+	culler.Cull(planes);
+	int inView = culler.GetVisibleCount();
+
+	OcclusionCuller occlusion(jobSystem, width, height);
+	occlusion.Begin(camera.GetView(), camera.GetProj());
+	for (int i = 0; i < 64; i++)
+	{
+		XMFLOAT3 center(eye.x + random.Range(-6.0f, 6.0f), eye.y + random.Range(-3.0f, 3.0f), eye.z + random.Range(3.0f, 15.0f));
+		occlusion.AddOccluder(center, random.Range(0.5f, 1.5f));
+	}
+	occlusion.Rasterize();
+	int hidden = occlusion.Cull(&culler);
+
+	Check(occlusion.GetWidth() % 4 == 0 && occlusion.GetWidth() >= width && occlusion.GetWidth() < width + 4, test, "buffer width isn't rounded up to a multiple of 4");
+	Check(occlusion.GetOccluderCount() > 0, test, "no occluders in front of the camera");
+	Check(occlusion.GetHiddenCount() > 0, test, "nothing hidden");
+	Check(hidden == occlusion.GetHiddenCount(), test, "Cull and GetHiddenCount disagree");
+	Check(culler.GetVisibleCount() == inView - hidden, test, "hidden spheres are still visible");
+	Check(occlusion.VerifyAgainstBruteForce(&culler) == 0, test, "differs from brute force");
+
+	SceneResult result;
+	result.Visible = culler.GetVisibleCount();
+	result.Hidden = hidden;
+	for (int i = 0; i < culler.GetCount(); i++)
+		result.IsVisible.push_back(culler.IsVisible(i) ? 1 : 0);
+	return result;
+}
+
+int main()
+{
+	JobSystem serial(1);
+	JobSystem parallel(4);
+
+	int sizes[3][2] = { { 320, 184 }, { 150, 97 }, { 61, 40 } };
+	for (int s = 0; s < 3; s++)
+	{
+		for (unsigned long long seed = 1; seed <= 5; seed++)
+		{
+			char test[64];
+			snprintf(test, sizeof(test), "%dx%d, seed %llu", sizes[s][0], sizes[s][1], seed);
+
+			//The same scene has to come out the same however it's split up
+			SceneResult one = CullScene(test, &serial, sizes[s][0], sizes[s][1], seed);
+			SceneResult many = CullScene(test, &parallel, sizes[s][0], sizes[s][1], seed);
+			Check(one.Hidden == many.Hidden && one.IsVisible == many.IsVisible, test, "one thread and four threads disagree");
+		}
+	}
+
+	printf(failures ? "OcclusionCullerTest: %d failures\n" : "OcclusionCullerTest: passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "ParticleSystem.h"
+#include "ParticleEmitter.h"
+#include "JobSystem.h"
+#include "Camera.h"
+#include "Random.h"
+
+using namespace std;
+
+// --------------------------------------------------------
+// Checks that ParticleSystem::Update, which cuts the live
+// particles into jobs and runs them across threads, gives
+// exactly what each emitter's own serial Update does.  Two
+// identically seeded sets of emitters are stepped side by side
+// with the same frame times and movement, and every particle
+// attribute has to match bit for bit after every frame.
+//
+// All the emitters stay in view and close to the camera, so
+// culling and level of detail leave them running at full rate
+// like the serial path does.
+// --------------------------------------------------------
+
+static int failures = 0;
+
+static void Check(bool passed, int frame, const char* what)
+{
+	if (passed)
+		return;
+	printf("Frame %d: %s\n", frame, what);
+	failures++;
+}
+
+template <typename T>
+static bool SameBytes(const vector<T>& a, const vector<T>& b)
+{
+	return a.size() == b.size() && (a.empty() || memcmp(&a[0], &b[0], a.size() * sizeof(T)) == 0);
+}
+
+//Emitters created in the same order from the same global seed get the same
+//generators and the same slices of their system's store
+static void MakeEmitters(ParticleSystem* system, unsigned long long seed, vector<ParticleEmitter*>& emitters)
+{
+	Random::SetGlobalSeed(seed);
+
+	//Big enough to be split across several jobs
+	emitters.push_back(new ParticleEmitter(6000, 3000, 1.5f, 0.5f, 0.1f,
+		XMFLOAT4(1, 0.5f, 0, 0.6f), XMFLOAT4(0, 0, 0, 0.5f),
+		XMFLOAT3(0, 1, 0), XMFLOAT3(0, 0, 8), XMFLOAT3(0, 2, 0),
+		system, 0, 0));
+
+	//Small ones that share jobs, one of them in local space
+	for (int i = 0; i < 12; i++)
+	{
+		emitters.push_back(new ParticleEmitter(300, 40 + i * 10, 0.5f, 1.0f, 0.1f,
+			XMFLOAT4(0.4f, 0.4f, 0.4f, 0.6f), XMFLOAT4(0, 0, 0, 0.5f),
+			XMFLOAT3(0, 0, 1), XMFLOAT3(-3.0f + i * 0.5f, 0, 6), XMFLOAT3(0, 0, 3),
+			system, 0, 0));
+	}
+	emitters[3]->SetLocalSpace(true);
+
+	//Runs out part way through, then goes to sleep once its particles die
+	emitters.push_back(new ParticleEmitter(500, 200, 0.5f, 1.0f, 0.1f,
+		XMFLOAT4(1, 1, 1, 1), XMFLOAT4(0, 0, 0, 0),
+		XMFLOAT3(0, 0, 0), XMFLOAT3(2, 1, 7), XMFLOAT3(0, -1, 0),
+		system, 0, 1.0f));
+}
+
+int main()
+{
+	const int frames = 240;
+	const unsigned long long seed = 42;
+
+	JobSystem serialJobs(1);
+	JobSystem parallelJobs(4);
+
+	//Camera at the origin looking down +z at everything
+	Camera camera(1280.0f, 720.0f, 0.25f * XM_PI, 0.01f, 100.0f);
+	camera.LookTo(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 1));
+
+	ParticleSystem serial(&serialJobs);
+	ParticleSystem parallel(&parallelJobs);
+	vector<ParticleEmitter*> serialEmitters;
+	vector<ParticleEmitter*> parallelEmitters;
+	MakeEmitters(&serial, seed, serialEmitters);
+	MakeEmitters(&parallel, seed, parallelEmitters);
+
+	//Frame times and emitter movement, the same for both
+	Random random(seed);
+	int mostLiving = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		float dt = random.Range(1.0f / 144.0f, 1.0f / 20.0f);
+		XMFLOAT3 moved(random.Range(-1.0f, 1.0f), random.Range(-0.5f, 0.5f), 8.0f + random.Range(-1.0f, 1.0f));
+		serialEmitters[0]->SetEmitterPosition(moved);
+		parallelEmitters[0]->SetEmitterPosition(moved);
+		serialEmitters[3]->SetEmitterPosition(XMFLOAT3(moved.x, moved.y, 6.0f));
+		parallelEmitters[3]->SetEmitterPosition(XMFLOAT3(moved.x, moved.y, 6.0f));
+
+		for (size_t i = 0; i < serialEmitters.size(); i++)
+			serialEmitters[i]->Update(dt);
+
+		for (size_t i = 0; i < parallelEmitters.size(); i++)
+			parallel.Queue(parallelEmitters[i]);
+		parallel.Update(dt, &camera);
+
+		Check(parallel.GetCulledEmitterCount() == 0, frame, "emitters were culled");
+
+		bool sameCounts = true;
+		for (size_t i = 0; i < serialEmitters.size(); i++)
+		{
+			sameCounts = sameCounts && serialEmitters[i]->GetLivingParticleCount() == parallelEmitters[i]->GetLivingParticleCount();
+			sameCounts = sameCounts && serialEmitters[i]->IsActive() == parallelEmitters[i]->IsActive();
+		}
+		Check(sameCounts, frame, "living counts differ");
+
+		ParticleStore* a = serial.GetStore();
+		ParticleStore* b = parallel.GetStore();
+		Check(SameBytes(a->Position, b->Position), frame, "positions differ");
+		Check(SameBytes(a->StartPos, b->StartPos), frame, "start positions differ");
+		Check(SameBytes(a->StartVel, b->StartVel), frame, "start velocities differ");
+		Check(SameBytes(a->Color, b->Color), frame, "colors differ");
+		Check(SameBytes(a->Size, b->Size), frame, "sizes differ");
+		Check(SameBytes(a->Age, b->Age), frame, "ages differ");
+
+		int living = parallelEmitters[0]->GetLivingParticleCount();
+		mostLiving = living > mostLiving ? living : mostLiving;
+		if (failures > 0)
+			break;
+	}
+
+	//Otherwise the big emitter never needed splitting
+	if (mostLiving < 2048)
+	{
+		printf("Big emitter peaked at %d particles, too few to be split across jobs\n", mostLiving);
+		failures++;
+	}
+	if (parallelEmitters.back()->IsActive())
+	{
+		printf("Emitter with a limited life is still active\n");
+		failures++;
+	}
+
+	for (size_t i = 0; i < serialEmitters.size(); i++)
+	{
+		delete serialEmitters[i];
+		delete parallelEmitters[i];
+	}
+
+	printf(failures ? "ParticleSystemTest: %d failures\n" : "ParticleSystemTest: passed\n", failures);
+	return failures ? 1 : 0;
+}
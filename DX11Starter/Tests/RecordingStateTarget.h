@@ -0,0 +1,139 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "StateTarget.h"
+
+using namespace std;
+
+//Objects are never dereferenced, so small numbers stand in for them.
+//0 is null, like the real thing
+template<typename T> inline T* Fake(unsigned int id)
+{
+	return reinterpret_cast<T*>((uintptr_t)id);
+}
+
+//D3D has 14 constant buffer and 16 sampler slots.  It has 128 SRV
+//slots, these are enough to go past the 16 the StateCache tracks
+const unsigned int bufferSlots = 14;
+const unsigned int resourceSlots = 24;
+const unsigned int samplerSlots = 16;
+
+struct StageBindings
+{
+	void* constantBuffers[bufferSlots];
+	void* resources[resourceSlots];
+	void* samplers[samplerSlots];
+};
+
+struct BoundState
+{
+	void* inputLayout;
+	void* vertexShader;
+	void* pixelShader;
+	StageBindings vs;
+	StageBindings ps;
+	void* blendState;
+	float blendFactor[4];
+	unsigned int sampleMask;
+	void* depthState;
+	unsigned int stencilRef;
+	void* rasterState;
+	unsigned int targetCount;
+	void* renderTargets[8];
+	void* depthView;
+};
+
+// --------------------------------------------------------
+// Keeps what's bound and counts the calls that reach it.
+// An SRV and a render target with the same id are views of
+// the same texture: binding the target unbinds the SRV, as
+// D3D does
+// --------------------------------------------------------
+class RecordingStateTarget : public StateTarget
+{
+public:
+	BoundState State;
+	int Calls;
+
+	//Every constant buffer upload, with what was sent.  Not counted in Calls
+	struct Upload
+	{
+		void* Buffer;
+		vector<unsigned char> Bytes;
+	};
+	vector<Upload> Uploads;
+
+	RecordingStateTarget()
+	{
+		memset(&State, 0, sizeof(State));
+		State.blendFactor[0] = State.blendFactor[1] = State.blendFactor[2] = State.blendFactor[3] = 1.0f;
+		State.sampleMask = 0xffffffff;
+		Calls = 0;
+	}
+
+	void IASetInputLayout(ID3D11InputLayout* layout) override { Calls++; State.inputLayout = layout; }
+	void VSSetShader(ID3D11VertexShader* shader) override { Calls++; State.vertexShader = shader; }
+	void PSSetShader(ID3D11PixelShader* shader) override { Calls++; State.pixelShader = shader; }
+
+	void VSSetConstantBuffers(unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers) override { Set(State.vs.constantBuffers, bufferSlots, slot, count, (void* const*)buffers); }
+	void PSSetConstantBuffers(unsigned int slot, unsigned int count, ID3D11Buffer* const* buffers) override { Set(State.ps.constantBuffers, bufferSlots, slot, count, (void* const*)buffers); }
+	void VSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) override { Set(State.vs.resources, resourceSlots, slot, count, (void* const*)srvs); }
+	void PSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) override { Set(State.ps.resources, resourceSlots, slot, count, (void* const*)srvs); }
+	void VSSetSamplers(unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers) override { Set(State.vs.samplers, samplerSlots, slot, count, (void* const*)samplers); }
+	void PSSetSamplers(unsigned int slot, unsigned int count, ID3D11SamplerState* const* samplers) override { Set(State.ps.samplers, samplerSlots, slot, count, (void* const*)samplers); }
+
+	void OMSetBlendState(ID3D11BlendState* state, const float blendFactor[4], unsigned int sampleMask) override
+	{
+		Calls++;
+		State.blendState = state;
+		for (int i = 0; i < 4; i++)
+			State.blendFactor[i] = blendFactor ? blendFactor[i] : 1.0f;
+		State.sampleMask = sampleMask;
+	}
+
+	void OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef) override
+	{
+		Calls++;
+		State.depthState = state;
+		State.stencilRef = stencilRef;
+	}
+
+	void RSSetState(ID3D11RasterizerState* state) override { Calls++; State.rasterState = state; }
+
+	void OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv) override
+	{
+		Calls++;
+		State.targetCount = count;
+		for (unsigned int i = 0; i < 8; i++)
+		{
+			State.renderTargets[i] = i < count ? (void*)rtvs[i] : nullptr;
+			if (i >= count || rtvs[i] == nullptr)
+				continue;
+
+			StageBindings* stages[2] = { &State.vs, &State.ps };
+			for (int s = 0; s < 2; s++)
+				for (unsigned int r = 0; r < resourceSlots; r++)
+					if (stages[s]->resources[r] == (void*)rtvs[i])
+						stages[s]->resources[r] = nullptr;
+		}
+		State.depthView = dsv;
+	}
+
+	void UpdateSubresource(ID3D11Buffer* buffer, const void* data, unsigned int size) override
+	{
+		Upload upload;
+		upload.Buffer = buffer;
+		upload.Bytes.assign((const unsigned char*)data, (const unsigned char*)data + size);
+		Uploads.push_back(upload);
+	}
+
+private:
+	void Set(void** slots, unsigned int slotCount, unsigned int slot, unsigned int count, void* const* values)
+	{
+		Calls++;
+		for (unsigned int i = 0; i < count && slot + i < slotCount; i++)
+			slots[slot + i] = values[i];
+	}
+};
@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <string.h>
+#include "ShaderConstants.h"
+
+// --------------------------------------------------------
+// Building this checks ShaderConstants.h's static_asserts
+// with this compiler.  Running it checks the reflection
+// tables follow the HLSL packing rules: members inside their
+// cbuffer, in order without overlapping, and nothing smaller
+// than a register straddling one
+// --------------------------------------------------------
+
+static const unsigned int registerSize = 16;
+
+int main()
+{
+	int failures = 0;
+	int buffers = 0;
+	int members = 0;
+	for (const ShaderConstantLayout& layout : ShaderConstantLayouts)
+	{
+		const ShaderConstantInfo* buffer = 0;
+		unsigned int end = 0;
+		for (unsigned int i = 0; i < layout.Count; i++)
+		{
+			const ShaderConstantInfo& info = layout.Members[i];
+
+			//Each cbuffer's size comes before its members
+			if (!info.Variable)
+			{
+				buffer = &info;
+				end = 0;
+				buffers++;
+				if (info.Size == 0 || info.Size % registerSize != 0)
+				{
+					printf("%s %s: size %u isn't whole registers\n", layout.Shader, info.Buffer, info.Size);
+					failures++;
+				}
+				continue;
+			}
+
+			members++;
+			if (!buffer || strcmp(buffer->Buffer, info.Buffer) != 0)
+			{
+				printf("%s %s.%s: not after its cbuffer's size\n", layout.Shader, info.Buffer, info.Variable);
+				failures++;
+				continue;
+			}
+
+			unsigned int first = info.Offset / registerSize;
+			unsigned int last = (info.Offset + info.Size - 1) / registerSize;
+			bool straddles = info.Size <= registerSize && first != last;
+			if (info.Offset < end || info.Offset + info.Size > buffer->Size || straddles || info.Size == 0)
+			{
+				printf("%s %s.%s: %u bytes at %u doesn't fit the packing rules\n",
+					layout.Shader, info.Buffer, info.Variable, info.Size, info.Offset);
+				failures++;
+			}
+			end = info.Offset + info.Size;
+		}
+	}
+
+	//The structs the game fills directly
+	static_assert(sizeof(ShipPS::perObject) == 272, "ShipPS::perObject changed size");
+	static_assert(offsetof(ShipPS::perFrame, cameraPosition) == 192, "ShipPS::perFrame.cameraPosition moved");
+	static_assert(sizeof(BlurPS::Data) == 16, "BlurPS::Data changed size");
+
+	if (buffers == 0 || members == 0)
+	{
+		printf("No cbuffers in ShaderConstants.h\n");
+		failures++;
+	}
+
+	printf("%d cbuffers, %d members\n", buffers, members);
+	printf(failures ? "ShaderConstantsTest: %d failures\n" : "ShaderConstantsTest: passed\n", failures);
+	return failures ? 1 : 0;
+}
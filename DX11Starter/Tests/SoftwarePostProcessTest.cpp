@@ -0,0 +1,433 @@
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "SoftwarePostProcess.h"
+#include "JobSystem.h"
+#include "Random.h"
+
+using namespace std;
+
+// --------------------------------------------------------
+// Checks SoftwarePostProcess's SSE, tiled passes against a
+// plain scalar version of each shader, written straight from
+// BloomPS, BlurPS, RadialPS and PPPS: one pixel at a time, and
+// every sample a clamped bilinear lookup at the shader's uv.
+//
+// Without rounding the two only differ in float operation
+// order, so every channel has to be within 1e-4.  With 8 bit
+// rounding between passes a value can land either side of a
+// level, so the whole chain is allowed one level (1/255) on a
+// channel and 1/1000 RMS overall.
+//
+// The cheaper settings (fewer blur taps, a downsampled bloom)
+// get the same checks against a reference run the same way,
+// and then have to stay within 0.03 RMS of the full chain.
+// --------------------------------------------------------
+
+static const float passTolerance = 1e-4f;
+static const float quantizedTolerance = 1.0f / 255.0f + 1e-5f;
+static const float quantizedRmsTolerance = 1e-3f;
+static const float cheaperRmsBound = 0.03f;
+
+static const float blurWeights[15] = { 0.009033f, 0.018476f, 0.033851f, 0.055555f, 0.08167f,
+	0.107545f, 0.126854f, 0.134032f, 0.126854f, 0.107545f,
+	0.08167f, 0.055555f, 0.033851f, 0.018476f, 0.009033f };
+
+static const float radialWeights[16] = { 0.132368f, 0.125279f, 0.106209f, 0.080656f,
+	0.054865f, 0.033431f, 0.018246f, 0.008920f,
+	0.003906f, 0.001532f, 0.000538f, 0.000169f,
+	0.000048f, 0.000012f, 0.000003f, 0.000001f };
+
+struct Color
+{
+	float c[4];
+};
+
+static void Resize(FloatImage& image, int width, int height)
+{
+	image.Width = width;
+	image.Height = height;
+	image.Pixels.assign(width * height * 4, 0.0f);
+}
+
+static Color Texel(const FloatImage& image, int x, int y)
+{
+	x = x < 0 ? 0 : (x >= image.Width ? image.Width - 1 : x);
+	y = y < 0 ? 0 : (y >= image.Height ? image.Height - 1 : y);
+	Color color;
+	for (int i = 0; i < 4; i++)
+		color.c[i] = image.Pixels[(y * image.Width + x) * 4 + i];
+	return color;
+}
+
+static void Store(FloatImage& image, int x, int y, const Color& color)
+{
+	for (int i = 0; i < 4; i++)
+		image.Pixels[(y * image.Width + x) * 4 + i] = color.c[i];
+}
+
+//A MIN_MAG_MIP_LINEAR sampler with clamped addressing
+static Color Sample(const FloatImage& image, float u, float v)
+{
+	float x = u * image.Width - 0.5f;
+	float y = v * image.Height - 0.5f;
+	int x0 = (int)floorf(x);
+	int y0 = (int)floorf(y);
+	float tx = x - x0;
+	float ty = y - y0;
+
+	Color a = Texel(image, x0, y0);
+	Color b = Texel(image, x0 + 1, y0);
+	Color c = Texel(image, x0, y0 + 1);
+	Color d = Texel(image, x0 + 1, y0 + 1);
+	Color result;
+	for (int i = 0; i < 4; i++)
+	{
+		float top = a.c[i] * (1.0f - tx) + b.c[i] * tx;
+		float bottom = c.c[i] * (1.0f - tx) + d.c[i] * tx;
+		result.c[i] = top * (1.0f - ty) + bottom * ty;
+	}
+	return result;
+}
+
+static float U(const FloatImage& image, int x) { return (x + 0.5f) / image.Width; }
+static float V(const FloatImage& image, int y) { return (y + 0.5f) / image.Height; }
+
+//BloomPS.  Clipped pixels keep the target's clear colour
+static void ReferenceBloom(const FloatImage& src, FloatImage& dst, float clipValue)
+{
+	Resize(dst, src.Width, src.Height);
+	for (int y = 0; y < src.Height; y++)
+	{
+		for (int x = 0; x < src.Width; x++)
+		{
+			Color base = Sample(src, U(src, x), V(src, y));
+			float brightness = base.c[0] * 0.3f + base.c[1] * 0.59f + base.c[2] * 0.11f;
+			if (brightness - clipValue >= 0.0f)
+				Store(dst, x, y, base);
+		}
+	}
+}
+
+//BlurPS, offsets spacing texels apart.  Fewer taps keep the middle of the
+//kernel, scaled up to the full kernel's total
+static void ReferenceBlur(const FloatImage& src, FloatImage& dst, float dirX, float dirY, float spacing = 2.0f, int taps = 15)
+{
+	Resize(dst, src.Width, src.Height);
+	int first = 7 - taps / 2;
+	float full = 0.0f;
+	float kept = 0.0f;
+	for (int i = 0; i < 15; i++)
+	{
+		full += blurWeights[i];
+		if (i >= first && i < first + taps)
+			kept += blurWeights[i];
+	}
+
+	float pixelWidth = 1.0f / src.Width;
+	float pixelHeight = 1.0f / src.Height;
+	for (int y = 0; y < src.Height; y++)
+	{
+		for (int x = 0; x < src.Width; x++)
+		{
+			Color sum = {};
+			for (int i = first; i < first + taps; i++)
+			{
+				float u = U(src, x) + (i - 7) * dirX * pixelWidth * spacing;
+				float v = V(src, y) + (i - 7) * dirY * pixelHeight * spacing;
+				Color s = Sample(src, u, v);
+				for (int c = 0; c < 4; c++)
+					sum.c[c] += blurWeights[i] * full / kept * s.c[c];
+			}
+			Store(dst, x, y, sum);
+		}
+	}
+}
+
+//The average of each factor x factor block, part blocks at the edges
+//averaging what they cover
+static void ReferenceDownsample(const FloatImage& src, FloatImage& dst, int factor)
+{
+	Resize(dst, (src.Width + factor - 1) / factor, (src.Height + factor - 1) / factor);
+	for (int y = 0; y < dst.Height; y++)
+	{
+		for (int x = 0; x < dst.Width; x++)
+		{
+			Color sum = {};
+			int count = 0;
+			for (int sy = y * factor; sy < src.Height && sy < (y + 1) * factor; sy++)
+			{
+				for (int sx = x * factor; sx < src.Width && sx < (x + 1) * factor; sx++)
+				{
+					Color s = Texel(src, sx, sy);
+					for (int c = 0; c < 4; c++)
+						sum.c[c] += s.c[c];
+					count++;
+				}
+			}
+			for (int c = 0; c < 4; c++)
+				sum.c[c] /= count;
+			Store(dst, x, y, sum);
+		}
+	}
+}
+
+//RadialPS
+static void ReferenceRadial(const FloatImage& src, FloatImage& dst)
+{
+	Resize(dst, src.Width, src.Height);
+	for (int y = 0; y < src.Height; y++)
+	{
+		for (int x = 0; x < src.Width; x++)
+		{
+			float u = U(src, x);
+			float v = V(src, y);
+			float toX = 0.5f - u;
+			float toY = 0.5f - v;
+			float factor = sqrtf(toX * toX + toY * toY) - 0.25f;
+			factor = factor < 0.0f ? 0.0f : (factor > 1.0f ? 1.0f : factor);
+
+			Color sum = {};
+			for (int i = 0; i < 16; i++)
+			{
+				Color s = Sample(src, u + i * factor * toX / 32.0f, v + i * factor * toY / 32.0f);
+				for (int c = 0; c < 4; c++)
+					sum.c[c] += 2.0f * radialWeights[i] * s.c[c];
+			}
+			Store(dst, x, y, sum);
+		}
+	}
+}
+
+//PPPS, with a null bloom texture reading as zero
+static void ReferenceCombine(const FloatImage& base, const FloatImage* bloom, FloatImage& dst)
+{
+	Resize(dst, base.Width, base.Height);
+	for (int y = 0; y < base.Height; y++)
+	{
+		for (int x = 0; x < base.Width; x++)
+		{
+			Color color = Sample(base, U(base, x), V(base, y));
+			Color glow = bloom ? Sample(*bloom, U(base, x), V(base, y)) : Color();
+			for (int c = 0; c < 4; c++)
+				color.c[c] = color.c[c] + (glow.c[c] - color.c[c] * glow.c[c]);
+			Store(dst, x, y, color);
+		}
+	}
+}
+
+//What an R8G8B8A8_UNORM target stores
+static void ReferenceQuantize(FloatImage& image)
+{
+	for (size_t i = 0; i < image.Pixels.size(); i++)
+	{
+		float v = image.Pixels[i];
+		v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+		image.Pixels[i] = nearbyintf(v * 255.0f) / 255.0f;
+	}
+}
+
+static void ReferenceRun(const FloatImage& scene, FloatImage& result, const SoftwarePostProcess::Settings& settings)
+{
+	FloatImage bright, reduced, blurH, blurV, radial;
+	const FloatImage* bloom = 0;
+	if (settings.Bloom)
+	{
+		ReferenceBloom(scene, bright, settings.ClipValue);
+		if (settings.Quantize) ReferenceQuantize(bright);
+
+		//A smaller bloom target, blurred over the same distance on screen
+		const FloatImage* blurSource = &bright;
+		float spacing = 2.0f;
+		if (settings.BloomDownsample > 1)
+		{
+			ReferenceDownsample(bright, reduced, settings.BloomDownsample);
+			if (settings.Quantize) ReferenceQuantize(reduced);
+			blurSource = &reduced;
+			spacing /= settings.BloomDownsample;
+		}
+
+		ReferenceBlur(*blurSource, blurH, 1.0f, 0.0f, spacing, settings.BlurTaps);
+		if (settings.Quantize) ReferenceQuantize(blurH);
+		ReferenceBlur(blurH, blurV, 0.0f, 1.0f, spacing, settings.BlurTaps);
+		if (settings.Quantize) ReferenceQuantize(blurV);
+		bloom = &blurV;
+	}
+
+	const FloatImage* base = &scene;
+	if (settings.RadialBlur)
+	{
+		ReferenceRadial(scene, radial);
+		if (settings.Quantize) ReferenceQuantize(radial);
+		base = &radial;
+	}
+
+	ReferenceCombine(*base, bloom, result);
+	if (settings.Quantize) ReferenceQuantize(result);
+}
+
+//Dim noise with a few bright blobs, so bloom has something to pick out.
+//Sizes that aren't a whole number of tiles check the tile edges
+static FloatImage MakeScene(int width, int height, unsigned long long seed)
+{
+	Random random(seed);
+	FloatImage image;
+	Resize(image, width, height);
+	for (int i = 0; i < width * height; i++)
+	{
+		for (int c = 0; c < 3; c++)
+			image.Pixels[i * 4 + c] = random.Range(0.0f, 0.6f);
+		image.Pixels[i * 4 + 3] = 1.0f;
+	}
+
+	for (int b = 0; b < 6; b++)
+	{
+		int cx = (int)random.NextInt(width);
+		int cy = (int)random.NextInt(height);
+		int r = 2 + (int)random.NextInt(8);
+		for (int y = cy - r; y <= cy + r; y++)
+			for (int x = cx - r; x <= cx + r; x++)
+				if (x >= 0 && x < width && y >= 0 && y < height)
+					for (int c = 0; c < 3; c++)
+						image.Pixels[(y * width + x) * 4 + c] = random.Range(0.8f, 1.0f);
+	}
+	return image;
+}
+
+//Every channel, alpha included, within tolerance
+static bool Matches(const char* what, const FloatImage& result, const FloatImage& reference, float tolerance, float rmsTolerance = 1.0f)
+{
+	if (result.Width != reference.Width || result.Height != reference.Height)
+	{
+		printf("%s: %dx%d, expected %dx%d\n", what, result.Width, result.Height, reference.Width, reference.Height);
+		return false;
+	}
+
+	float largest = 0.0f;
+	int worst = 0;
+	for (size_t i = 0; i < result.Pixels.size(); i++)
+	{
+		float d = fabsf(result.Pixels[i] - reference.Pixels[i]);
+		if (d > largest)
+		{
+			largest = d;
+			worst = (int)i;
+		}
+	}
+	float rms = SoftwarePostProcess::Compare(result, reference);
+
+	if (largest > tolerance || rms > rmsTolerance)
+	{
+		int pixel = worst / 4;
+		printf("%s: largest error %g at (%d, %d) channel %d, RMS %g\n",
+			what, largest, pixel % result.Width, pixel / result.Width, worst % 4, rms);
+		return false;
+	}
+	return true;
+}
+
+int main()
+{
+	JobSystem jobSystem;
+	SoftwarePostProcess software(&jobSystem);
+	int failures = 0;
+
+	int sizes[3][2] = { { 64, 64 }, { 150, 97 }, { 33, 200 } };
+	for (int s = 0; s < 3; s++)
+	{
+		FloatImage scene = MakeScene(sizes[s][0], sizes[s][1], 1 + s);
+		FloatImage result, reference;
+
+		software.Bloom(scene, result, 0.72f);
+		ReferenceBloom(scene, reference, 0.72f);
+		failures += !Matches("Bloom", result, reference, passTolerance);
+
+		//Blur the bloom output, like the game does
+		FloatImage bright = reference;
+		software.Blur(bright, result, true);
+		ReferenceBlur(bright, reference, 1.0f, 0.0f);
+		failures += !Matches("Horizontal blur", result, reference, passTolerance);
+
+		software.Blur(scene, result, false);
+		ReferenceBlur(scene, reference, 0.0f, 1.0f);
+		failures += !Matches("Vertical blur", result, reference, passTolerance);
+
+		software.Radial(scene, result);
+		ReferenceRadial(scene, reference);
+		failures += !Matches("Radial blur", result, reference, passTolerance);
+
+		software.Combine(scene, &bright, result);
+		ReferenceCombine(scene, &bright, reference);
+		failures += !Matches("Combine", result, reference, passTolerance);
+
+		//The cheaper passes: fewer taps, and the half spacing a downsampled bloom uses
+		int taps[3] = { 9, 5, 1 };
+		for (int t = 0; t < 3; t++)
+		{
+			software.Blur(bright, result, true, 2.0f, taps[t]);
+			ReferenceBlur(bright, reference, 1.0f, 0.0f, 2.0f, taps[t]);
+			failures += !Matches("Reduced horizontal blur", result, reference, passTolerance);
+
+			software.Blur(scene, result, false, 0.5f, taps[t]);
+			ReferenceBlur(scene, reference, 0.0f, 1.0f, 0.5f, taps[t]);
+			failures += !Matches("Reduced vertical blur", result, reference, passTolerance);
+		}
+
+		for (int factor = 2; factor <= 4; factor++)
+		{
+			software.Downsample(bright, result, factor);
+			ReferenceDownsample(bright, reference, factor);
+			failures += !Matches("Downsample", result, reference, passTolerance);
+		}
+
+		//The whole chain with each effect on and off, then rounded like the game
+		for (int mode = 0; mode < 4; mode++)
+		{
+			SoftwarePostProcess::Settings settings;
+			settings.Bloom = (mode & 1) == 0;
+			settings.RadialBlur = (mode & 2) == 0;
+			settings.Quantize = false;
+			software.Run(scene, result, settings);
+			ReferenceRun(scene, reference, settings);
+			failures += !Matches("Chain", result, reference, passTolerance);
+		}
+
+		SoftwarePostProcess::Settings settings;
+		software.Run(scene, result, settings);
+		ReferenceRun(scene, reference, settings);
+		failures += !Matches("Quantized chain", result, reference, quantizedTolerance, quantizedRmsTolerance);
+		FloatImage full = result;
+
+		//Cheaper bloom chains against their own reference, and against the full
+		//chain: close enough to stand in for it
+		int cheaperTaps[3] = { 15, 9, 7 };
+		int cheaperDownsample[3] = { 2, 1, 4 };
+		for (int c = 0; c < 3; c++)
+		{
+			SoftwarePostProcess::Settings cheaper;
+			cheaper.BlurTaps = cheaperTaps[c];
+			cheaper.BloomDownsample = cheaperDownsample[c];
+			cheaper.Quantize = false;
+			software.Run(scene, result, cheaper);
+			ReferenceRun(scene, reference, cheaper);
+			failures += !Matches("Cheaper chain", result, reference, passTolerance);
+
+			cheaper.Quantize = true;
+			software.Run(scene, result, cheaper);
+			ReferenceRun(scene, reference, cheaper);
+			failures += !Matches("Quantized cheaper chain", result, reference, quantizedTolerance, quantizedRmsTolerance);
+
+			float largest = 0.0f;
+			float rms = SoftwarePostProcess::Compare(result, full, &largest);
+			if (rms > cheaperRmsBound)
+			{
+				printf("%d taps at 1/%d: RMS %g (largest %g) from the full chain, more than %g\n",
+					cheaper.BlurTaps, cheaper.BloomDownsample, rms, largest, cheaperRmsBound);
+				failures++;
+			}
+		}
+	}
+
+	printf(failures ? "SoftwarePostProcessTest: %d failures\n" : "SoftwarePostProcessTest: passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "StateCache.h"
+#include "Random.h"
+#include "RecordingStateTarget.h"
+
+using namespace std;
+
+// --------------------------------------------------------
+// Runs the same draw list through a filtering StateCache and
+// one with filtering off, each in front of a target that keeps
+// the state D3D would have bound.  At every draw both targets
+// have to hold the same state, and the filtering one has to
+// have been sent fewer calls.
+// --------------------------------------------------------
+
+enum OpType
+{
+	OP_INPUT_LAYOUT,
+	OP_VERTEX_SHADER,
+	OP_PIXEL_SHADER,
+	OP_VS_CONSTANT_BUFFER,
+	OP_PS_CONSTANT_BUFFER,
+	OP_VS_RESOURCE,
+	OP_PS_RESOURCE,
+	OP_VS_SAMPLER,
+	OP_PS_SAMPLER,
+	OP_CLEAR_RESOURCES,
+	OP_BLEND,
+	OP_DEPTH,
+	OP_RASTER,
+	OP_RENDER_TARGETS,
+	OP_BEHIND_BACK,		// Something binds state without the cache, then invalidates it
+	OP_DRAW,
+	OP_COUNT
+};
+
+struct Op
+{
+	OpType Type;
+	unsigned int Slot;
+	unsigned int Id;
+	float Factor;
+};
+
+//Few distinct objects per kind, so most calls repeat what's bound
+static vector<Op> MakeDrawList(int count, unsigned long long seed)
+{
+	Random random(seed);
+	vector<Op> ops;
+	for (int i = 0; i < count; i++)
+	{
+		Op op;
+		op.Type = (OpType)random.NextInt(OP_COUNT);
+		op.Id = random.NextInt(4);
+		op.Factor = random.NextInt(4) == 0 ? 0.5f : 1.0f;
+		switch (op.Type)
+		{
+		case OP_VS_CONSTANT_BUFFER:
+		case OP_PS_CONSTANT_BUFFER:
+			op.Slot = random.NextInt(3);
+			break;
+		case OP_VS_RESOURCE:
+		case OP_PS_RESOURCE:
+			//Mostly tracked slots, now and then one past them
+			op.Slot = random.NextInt(8) == 0 ? 16 + random.NextInt(resourceSlots - 16) : random.NextInt(3);
+			break;
+		case OP_VS_SAMPLER:
+		case OP_PS_SAMPLER:
+			op.Slot = random.NextInt(2);
+			break;
+		default:
+			op.Slot = 0;
+			break;
+		}
+		ops.push_back(op);
+	}
+	return ops;
+}
+
+//Plays the list, keeping the bound state at every draw
+static void Play(const vector<Op>& ops, bool filtering, vector<BoundState>& draws, int& calls, int& issued, int& filtered)
+{
+	RecordingStateTarget target;
+	StateCache cache(&target);
+	cache.SetFiltering(filtering);
+
+	for (const Op& op : ops)
+	{
+		switch (op.Type)
+		{
+		case OP_INPUT_LAYOUT: cache.IASetInputLayout(Fake<ID3D11InputLayout>(op.Id)); break;
+		case OP_VERTEX_SHADER: cache.VSSetShader(Fake<ID3D11VertexShader>(op.Id)); break;
+		case OP_PIXEL_SHADER: cache.PSSetShader(Fake<ID3D11PixelShader>(op.Id)); break;
+		case OP_VS_CONSTANT_BUFFER: cache.VSSetConstantBuffer(op.Slot, Fake<ID3D11Buffer>(op.Id)); break;
+		case OP_PS_CONSTANT_BUFFER: cache.PSSetConstantBuffer(op.Slot, Fake<ID3D11Buffer>(op.Id)); break;
+		case OP_VS_RESOURCE: cache.VSSetShaderResource(op.Slot, Fake<ID3D11ShaderResourceView>(op.Id)); break;
+		case OP_PS_RESOURCE: cache.PSSetShaderResource(op.Slot, Fake<ID3D11ShaderResourceView>(op.Id)); break;
+		case OP_VS_SAMPLER: cache.VSSetSampler(op.Slot, Fake<ID3D11SamplerState>(op.Id)); break;
+		case OP_PS_SAMPLER: cache.PSSetSampler(op.Slot, Fake<ID3D11SamplerState>(op.Id)); break;
+		case OP_CLEAR_RESOURCES: cache.PSClearShaderResources(); break;
+		case OP_DEPTH: cache.OMSetDepthStencilState(Fake<ID3D11DepthStencilState>(op.Id), op.Id & 1); break;
+		case OP_RASTER: cache.RSSetState(Fake<ID3D11RasterizerState>(op.Id)); break;
+		case OP_BLEND:
+		{
+			//Null factors mean all ones, so they have to match a 1,1,1,1 one
+			float factor[4] = { op.Factor, op.Factor, op.Factor, op.Factor };
+			cache.OMSetBlendState(Fake<ID3D11BlendState>(op.Id), op.Factor == 1.0f && (op.Id & 1) ? 0 : factor, 0xffffffff);
+			break;
+		}
+		case OP_RENDER_TARGETS:
+		{
+			ID3D11RenderTargetView* rtv = Fake<ID3D11RenderTargetView>(op.Id);
+			cache.OMSetRenderTargets(1, &rtv, Fake<ID3D11DepthStencilView>(op.Id & 1));
+			break;
+		}
+		case OP_BEHIND_BACK:
+		{
+			//Like SpriteBatch: its own shaders, states and texture
+			ID3D11ShaderResourceView* srv = Fake<ID3D11ShaderResourceView>(op.Id);
+			target.VSSetShader(Fake<ID3D11VertexShader>(100));
+			target.PSSetShader(Fake<ID3D11PixelShader>(100));
+			target.PSSetShaderResources(0, 1, &srv);
+			target.OMSetBlendState(Fake<ID3D11BlendState>(100), 0, 0xffffffff);
+			target.RSSetState(0);
+			cache.Invalidate();
+			break;
+		}
+		case OP_DRAW:
+			draws.push_back(target.State);
+			break;
+		default:
+			break;
+		}
+	}
+
+	cache.EndFrame();
+	calls = target.Calls;
+	issued = cache.GetIssuedCalls();
+	filtered = cache.GetFilteredCalls();
+}
+
+int main()
+{
+	int failures = 0;
+	for (unsigned long long seed = 1; seed <= 20; seed++)
+	{
+		vector<Op> ops = MakeDrawList(5000, seed);
+
+		vector<BoundState> filteredDraws, unfilteredDraws;
+		int filteredCalls, filteredIssued, filteredSkipped;
+		int unfilteredCalls, unfilteredIssued, unfilteredSkipped;
+		Play(ops, true, filteredDraws, filteredCalls, filteredIssued, filteredSkipped);
+		Play(ops, false, unfilteredDraws, unfilteredCalls, unfilteredIssued, unfilteredSkipped);
+
+		//Both runs have to draw with the same state every time
+		int mismatch = -1;
+		for (size_t i = 0; i < filteredDraws.size() && mismatch < 0; i++)
+			if (memcmp(&filteredDraws[i], &unfilteredDraws[i], sizeof(BoundState)) != 0)
+				mismatch = (int)i;
+		if (filteredDraws.size() != unfilteredDraws.size() || mismatch >= 0)
+		{
+			printf("Seed %llu: state differs at draw %d of %d\n", seed, mismatch, (int)filteredDraws.size());
+			failures++;
+		}
+
+		//Every call the cache was given is either sent or dropped, and the
+		//unfiltered one drops nothing
+		if (unfilteredSkipped != 0 || filteredIssued + filteredSkipped != unfilteredIssued)
+		{
+			printf("Seed %llu: counts don't add up, %d + %d filtered against %d unfiltered (%d skipped)\n",
+				seed, filteredIssued, filteredSkipped, unfilteredIssued, unfilteredSkipped);
+			failures++;
+		}
+
+		//Target calls are the cache's plus the ones made behind its back,
+		//which are the same in both runs
+		if (unfilteredCalls - filteredCalls != filteredSkipped)
+		{
+			printf("Seed %llu: target got %d calls filtered, %d unfiltered, but %d were dropped\n",
+				seed, filteredCalls, unfilteredCalls, filteredSkipped);
+			failures++;
+		}
+
+		if (filteredSkipped == 0)
+		{
+			printf("Seed %llu: nothing was filtered\n", seed);
+			failures++;
+		}
+
+		if (seed == 1)
+			printf("%d draws, %d calls filtered down to %d\n",
+				(int)filteredDraws.size(), unfilteredIssued, filteredIssued);
+	}
+
+	printf(failures ? "StateCacheTest: %d failures\n" : "StateCacheTest: passed\n", failures);
+	return failures ? 1 : 0;
+}
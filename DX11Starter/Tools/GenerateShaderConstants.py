@@ -0,0 +1,285 @@
+#!/usr/bin/env python3
+"""
+Generates ShaderConstants.h from the cbuffers declared in the project's .hlsl
+files, so C++ can fill a typed struct and copy a whole constant buffer at once.
+
+Every cbuffer becomes a struct in a namespace named after its shader file.
+Members are laid out with the HLSL packing rules (16 byte registers, nothing
+straddles a register, arrays and structs start on a new one) with explicit
+padding, and every offset is checked with a static_assert.  HLSL structs that
+already have a C++ twin in Lights.h are used as-is, with their size checked.
+Each shader also gets a table of the offsets and sizes the shader compiler's
+reflection should report, which the game checks against the compiled shaders
+in debug builds.
+
+Only needs Python, no shader compiler:
+    python GenerateShaderConstants.py <shader dir> [output header]
+"""
+
+import os
+import re
+import sys
+
+# HLSL type -> (C++ type, size in bytes, components)
+BASIC_TYPES = {
+	"float":    ("float", 4),
+	"float2":   ("DirectX::XMFLOAT2", 8),
+	"float3":   ("DirectX::XMFLOAT3", 12),
+	"float4":   ("DirectX::XMFLOAT4", 16),
+	"int":      ("int", 4),
+	"int2":     ("DirectX::XMINT2", 8),
+	"int3":     ("DirectX::XMINT3", 12),
+	"int4":     ("DirectX::XMINT4", 16),
+	"uint":     ("unsigned int", 4),
+	"uint2":    ("DirectX::XMUINT2", 8),
+	"uint3":    ("DirectX::XMUINT3", 12),
+	"uint4":    ("DirectX::XMUINT4", 16),
+	"bool":     ("int", 4),
+	"matrix":   ("DirectX::XMFLOAT4X4", 64),
+	"float4x4": ("DirectX::XMFLOAT4X4", 64),
+}
+
+# HLSL structs that C++ already declares, in Lights.h
+KNOWN_STRUCTS = {
+	"DirectionalLight": "DirectionalLight",
+	"PointLight": "PointLight",
+}
+
+REGISTER = 16
+
+
+class LayoutError(Exception):
+	pass
+
+
+def strip_comments(text):
+	text = re.sub(r"/\*.*?\*/", " ", text, flags=re.S)
+	return re.sub(r"//[^\n]*", " ", text)
+
+
+def parse_members(body):
+	"""Splits a struct or cbuffer body into (type, name, array length, packoffset)"""
+	members = []
+	for statement in body.split(";"):
+		statement = " ".join(statement.split())
+		if not statement:
+			continue
+		m = re.match(r"^(?:row_major |column_major )?(\w+) (\w+)\s*(?:\[(\d+)\])?\s*(?::\s*packoffset\(\s*c(\d+)(?:\.([xyzw]))?\s*\))?$", statement)
+		if not m:
+			raise LayoutError("can't parse member '%s'" % statement)
+		hlslType, name, count, reg, component = m.groups()
+		offset = None
+		if reg is not None:
+			offset = int(reg) * REGISTER + ("xyzw".index(component) * 4 if component else 0)
+		members.append((hlslType, name, int(count) if count else 0, offset))
+	return members
+
+
+def parse_file(text):
+	text = strip_comments(text)
+	structs = {}
+	for m in re.finditer(r"\bstruct\s+(\w+)\s*\{(.*?)\}", text, flags=re.S):
+		# Pipeline structs have semantics, which parse_members rejects.  Only
+		# structs used in a cbuffer need to parse
+		try:
+			structs[m.group(1)] = parse_members(m.group(2))
+		except LayoutError:
+			structs[m.group(1)] = None
+
+	cbuffers = []
+	for m in re.finditer(r"\bcbuffer\s+(\w+)\s*(?::\s*register\(\s*b(\d+)\s*\))?\s*\{(.*?)\}", text, flags=re.S):
+		cbuffers.append((m.group(1), m.group(2), parse_members(m.group(3))))
+	return structs, cbuffers
+
+
+def type_size(hlslType, structs):
+	"""Size of one element, and whether it has to start on a new register"""
+	if hlslType in BASIC_TYPES:
+		size = BASIC_TYPES[hlslType][1]
+		return size, size >= 64
+	if hlslType in structs:
+		if structs[hlslType] is None:
+			raise LayoutError("struct %s can't go in a cbuffer" % hlslType)
+		return layout(structs[hlslType], structs)[1], True
+	raise LayoutError("unknown type %s" % hlslType)
+
+
+def layout(members, structs):
+	"""Returns [(type, name, count, offset, size)] and the packed size"""
+	placed = []
+	offset = 0
+	for hlslType, name, count, packOffset in members:
+		elementSize, newRegister = type_size(hlslType, structs)
+		if count:
+			# Every array element gets its own register, the last one isn't padded
+			size = REGISTER * (count - 1) + elementSize
+			newRegister = True
+		else:
+			size = elementSize
+
+		if packOffset is not None:
+			if packOffset < offset:
+				raise LayoutError("%s overlaps the member before it" % name)
+			offset = packOffset
+		elif newRegister or offset % REGISTER + size > REGISTER:
+			offset = (offset + REGISTER - 1) // REGISTER * REGISTER
+
+		placed.append((hlslType, name, count, offset, size))
+		offset += size
+	return placed, offset
+
+
+def cpp_type(hlslType):
+	if hlslType in BASIC_TYPES:
+		return BASIC_TYPES[hlslType][0]
+	if hlslType in KNOWN_STRUCTS:
+		return KNOWN_STRUCTS[hlslType]
+	raise LayoutError("struct %s has no C++ version, add it to KNOWN_STRUCTS" % hlslType)
+
+
+def buffer_size(size):
+	return (size + REGISTER - 1) // REGISTER * REGISTER
+
+
+def emit_reflection(cbuffers, structs):
+	"""The table of what reflection should find in one shader's cbuffers"""
+	lines = ["", "\t// What reflection on the compiled shader should report"]
+	lines.append("\tstatic const ShaderConstantInfo Reflection[] =")
+	lines.append("\t{")
+	for name, _, members in cbuffers:
+		placed, size = layout(members, structs)
+		lines.append("\t\t{ \"%s\", 0, 0, %d }," % (name, buffer_size(size)))
+		for _, member, _, offset, memberSize in placed:
+			lines.append("\t\t{ \"%s\", \"%s\", %d, %d }," % (name, member, offset, memberSize))
+	lines.append("\t};")
+	return lines
+
+
+def emit_cbuffer(name, register, members, structs):
+	placed, size = layout(members, structs)
+	bufferSize = buffer_size(size)
+
+	lines = []
+	if register is not None:
+		lines.append("\t// register(b%s)" % register)
+	lines.append("\tstruct %s" % name)
+	lines.append("\t{")
+	asserts = []
+	cursor = 0
+	pad = 0
+	for hlslType, member, count, offset, memberSize in placed:
+		if offset > cursor:
+			lines.append("\t\tunsigned char _pad%d[%d];" % (pad, offset - cursor))
+			pad += 1
+		elementSize = type_size(hlslType, structs)[0]
+		if count and elementSize != REGISTER:
+			raise LayoutError("%s: arrays of types smaller than a register aren't supported" % member)
+		lines.append("\t\t%s %s%s;" % (cpp_type(hlslType), member, "[%d]" % count if count else ""))
+		asserts.append("\tstatic_assert(offsetof(%s, %s) == %d, \"%s.%s is at the wrong offset\");" % (name, member, offset, name, member))
+		cursor = offset + memberSize
+	if bufferSize > cursor:
+		lines.append("\t\tunsigned char _pad%d[%d];" % (pad, bufferSize - cursor))
+	lines.append("\t};")
+	asserts.append("\tstatic_assert(sizeof(%s) == %d, \"%s is the wrong size\");" % (name, bufferSize, name))
+	return lines + asserts
+
+
+def generate(shaderDir):
+	out = []
+	shaders = []
+	usedStructs = {}
+	for fileName in sorted(os.listdir(shaderDir)):
+		if not fileName.endswith(".hlsl"):
+			continue
+		with open(os.path.join(shaderDir, fileName)) as f:
+			structs, cbuffers = parse_file(f.read())
+		cbuffers = [c for c in cbuffers if c[2]]
+		if not cbuffers:
+			continue
+
+		shader = os.path.splitext(fileName)[0]
+		out.append("")
+		out.append("// %s" % fileName)
+		out.append("namespace %s" % shader)
+		out.append("{")
+		for i, (name, register, members) in enumerate(cbuffers):
+			if i > 0:
+				out.append("")
+			try:
+				out.extend(emit_cbuffer(name, register, members, structs))
+			except LayoutError as e:
+				raise LayoutError("%s, cbuffer %s: %s" % (fileName, name, e))
+			for hlslType, _, _, _ in members:
+				if hlslType in KNOWN_STRUCTS:
+					usedStructs[hlslType] = type_size(hlslType, structs)[0]
+		out.extend(emit_reflection(cbuffers, structs))
+		out.append("}")
+		shaders.append(shader)
+
+	header = [
+		"// Generated by Tools/GenerateShaderConstants.py from the cbuffers in the .hlsl",
+		"// files.  Don't edit by hand, rerun it after changing a cbuffer.",
+		"#pragma once",
+		"",
+		"#include <cstddef>",
+		"#include \"Portable.h\"",
+		"#include \"Lights.h\"",
+		"",
+		"// The C++ light structs have to match the HLSL ones",
+	]
+	for hlslType in sorted(usedStructs):
+		header.append("static_assert(sizeof(%s) == %d, \"%s doesn't match HLSL\");" % (KNOWN_STRUCTS[hlslType], usedStructs[hlslType], hlslType))
+	header += [
+		"",
+		"// A cbuffer member's offset and size, or with a null Variable the",
+		"// whole cbuffer's size",
+		"struct ShaderConstantInfo",
+		"{",
+		"\tconst char* Buffer;",
+		"\tconst char* Variable;",
+		"\tunsigned int Offset;",
+		"\tunsigned int Size;",
+		"};",
+		"",
+		"struct ShaderConstantLayout",
+		"{",
+		"\tconst char* Shader;\t\t// The .hlsl file's name, without the extension",
+		"\tconst ShaderConstantInfo* Members;",
+		"\tunsigned int Count;",
+		"};",
+	]
+
+	table = ["", "// Every shader above"]
+	table.append("static const ShaderConstantLayout ShaderConstantLayouts[] =")
+	table.append("{")
+	for shader in shaders:
+		table.append("\t{ \"%s\", %s::Reflection, sizeof(%s::Reflection) / sizeof(ShaderConstantInfo) }," % (shader, shader, shader))
+	table.append("};")
+	return "\n".join(header + out + table) + "\n"
+
+
+def main():
+	if len(sys.argv) < 2:
+		print("usage: GenerateShaderConstants.py <shader dir> [output header]")
+		return 1
+	shaderDir = sys.argv[1]
+	output = sys.argv[2] if len(sys.argv) > 2 else os.path.join(shaderDir, "ShaderConstants.h")
+
+	try:
+		text = generate(shaderDir)
+	except LayoutError as e:
+		print("GenerateShaderConstants: error: %s" % e)
+		return 1
+
+	# Leave the file alone if nothing changed, so it doesn't trigger a rebuild
+	if os.path.exists(output):
+		with open(output) as f:
+			if f.read() == text:
+				return 0
+	with open(output, "w", newline="\n") as f:
+		f.write(text)
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())